@@ -38,6 +38,8 @@
 
 #include <cstdint>
 #include <cstring>
+#include <iterator>
+#include <string>
 
 // Supported codepages
 #include "encodings/cp932.h"
@@ -45,6 +47,9 @@
 #include "encodings/cp949.h"
 #include "encodings/western.h"
 
+#include "utf8cpp/utf8.h"
+#include "utilities/string_utilities.h"
+
 // -----------------------------------------------------------------------
 // Codepage
 // -----------------------------------------------------------------------
@@ -85,6 +90,65 @@ bool Codepage::DbcsDelim(char* str) const { return false; }
 
 bool Codepage::IsItalic(uint16_t ch) const { return false; }
 
+bool Codepage::IsLeadByte(unsigned char c) const { return false; }
+
+std::string Codepage::ConvertStringToUTF8(const std::string& s) const {
+  std::string out;
+  out.reserve(s.size() + s.size() / 2);
+
+  // Some table entries are UTF-16 surrogates. They're paired up, or rejected,
+  // exactly as utf8::utf16to8() would on the output of ConvertString().
+  uint32_t lead_surrogate = 0;
+
+  const char* str = s.data();
+  size_t length = s.size();
+  size_t i = 0;
+  while (i < length) {
+    if (!lead_surrogate) {
+      size_t ascii = AsciiPrefixLength(str + i, length - i);
+      out.append(str + i, ascii);
+      i += ascii;
+      if (i == length)
+        break;
+    }
+
+    unsigned char c = str[i++];
+    if (c == 0)
+      break;
+
+    uint16_t unit;
+    if (IsLeadByte(c)) {
+      // A lead byte at the very end pairs with the terminating NUL.
+      unsigned char trail = i < length ? str[i++] : 0;
+      unit = Convert((c << 8) | trail);
+    } else {
+      unit = Convert(c);
+    }
+
+    if (lead_surrogate) {
+      if (!utf8::internal::is_trail_surrogate(unit))
+        throw utf8::invalid_utf16(unit);
+      utf8::append((lead_surrogate << 10) + unit +
+                       utf8::internal::SURROGATE_OFFSET,
+                   std::back_inserter(out));
+      lead_surrogate = 0;
+    } else if (utf8::internal::is_lead_surrogate(unit)) {
+      lead_surrogate = unit;
+    } else if (utf8::internal::is_trail_surrogate(unit)) {
+      throw utf8::invalid_utf16(unit);
+    } else {
+      utf8::append(unit, std::back_inserter(out));
+    }
+  }
+
+  // An unpaired lead surrogate at the end isn't a valid code point, so this
+  // throws.
+  if (lead_surrogate)
+    utf8::append(lead_surrogate, std::back_inserter(out));
+
+  return out;
+}
+
 std::unique_ptr<Codepage> Cp::instance_;
 int Cp::codepage = -1;
 int Cp::scenario = -1;
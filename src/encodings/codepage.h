@@ -50,6 +50,14 @@ struct Codepage {
   virtual bool DbcsDelim(char* str) const;
   virtual bool IsItalic(unsigned short ch) const;
 
+  // Whether |c| starts a two byte character. Bytes below 0x80 never do:
+  // every supported codepage is a superset of ASCII.
+  virtual bool IsLeadByte(unsigned char c) const;
+
+  // Converts |s| straight to UTF-8, in one pass, stopping at the first NUL
+  // like ConvertString() does. Runs of ASCII are copied as is.
+  std::string ConvertStringToUTF8(const std::string& s) const;
+
   int UseUnicode;
   int DesirableCharset;
   bool NoTransforms;
@@ -1291,3 +1291,5 @@ std::wstring Cp932::ConvertString(const std::string& s) const {
 }
 
 #endif
+
+bool Cp932::IsLeadByte(unsigned char c) const { return shiftjis_lead_byte(c); }
@@ -44,6 +44,7 @@
 struct Cp932 : public Codepage {
   virtual unsigned short Convert(unsigned short ch) const;
   virtual std::wstring ConvertString(const std::string& s) const;
+  virtual bool IsLeadByte(unsigned char c) const;
   Cp932();
 };
 
@@ -2844,3 +2844,5 @@ std::wstring Cp936::ConvertString(const std::string& s) const {
 }
 
 #endif
+
+bool Cp936::IsLeadByte(unsigned char c) const { return c >= 0x80; }
@@ -1779,3 +1779,5 @@ uint16_t Cp949::Convert(uint16_t ch) const { return ch; }
 std::wstring Cp949::ConvertString(const std::string& s) const { return NULL; }
 
 #endif
+
+bool Cp949::IsLeadByte(unsigned char c) const { return c >= 0x80; }
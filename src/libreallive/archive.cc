@@ -35,8 +35,15 @@
 
 #include <boost/algorithm/string.hpp>
 #include <boost/filesystem.hpp>
+#include <algorithm>
+#include <cstdint>
 #include <cstring>
+#include <ctime>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
 #include <string>
+#include <vector>
 
 #include "libreallive/compression.h"
 
@@ -46,8 +53,61 @@ namespace fs = boost::filesystem;
 
 namespace libreallive {
 
+namespace {
+
+// Bump this whenever the layout of a disk cache entry changes.
+const uint32_t kDiskCacheVersion = 1;
+
+const char kDiskCacheMagic[8] = {'R', 'L', 'V', 'M', 'S', 'E', 'E', 'N'};
+
+// Start of a disk cache entry. It's followed by the REGNAME and then the
+// decompressed bytecode. An entry is valid when its header is byte for byte
+// the one MakeDiskCacheHeader() builds for the scenario.
+struct DiskCacheHeader {
+  char magic[8];
+  uint32_t version;
+  uint32_t scenario_length;
+  uint64_t source_size;
+  int64_t source_mtime;
+  uint32_t regname_length;
+  uint32_t bytecode_length;
+};
+
+// Describes the scenario at |fp|, which was read from |source|. Returns false
+// if |source| can't be stat()ed.
+bool MakeDiskCacheHeader(const std::string& source,
+                         const FilePos& fp,
+                         const std::string& regname,
+                         DiskCacheHeader* header) {
+  boost::system::error_code ec;
+  const uintmax_t size = fs::file_size(source, ec);
+  if (ec)
+    return false;
+  const std::time_t mtime = fs::last_write_time(source, ec);
+  if (ec)
+    return false;
+
+  memset(header, 0, sizeof(*header));
+  memcpy(header->magic, kDiskCacheMagic, sizeof(header->magic));
+  header->version = kDiskCacheVersion;
+  header->scenario_length = fp.length;
+  header->source_size = size;
+  header->source_mtime = mtime;
+  header->regname_length = regname.size();
+  header->bytecode_length = read_i32(fp.data + 0x24);
+  return true;
+}
+
+}  // namespace
+
+Archive::DiskCacheStats::DiskCacheStats() : hits(0), misses(0), writes(0) {}
+
 Archive::Archive(const std::string& filename)
-    : name_(filename), info_(filename, Read), second_level_xor_key_(NULL) {
+    : name_(filename),
+      info_(filename, Read),
+      second_level_xor_key_(NULL),
+      prefetch_loading_(-1),
+      prefetch_shutdown_(false) {
   ReadTOC();
   ReadOverrides();
 }
@@ -56,7 +116,9 @@ Archive::Archive(const std::string& filename, const std::string& regname)
     : name_(filename),
       info_(filename, Read),
       second_level_xor_key_(NULL),
-      regname_(regname) {
+      regname_(regname),
+      prefetch_loading_(-1),
+      prefetch_shutdown_(false) {
   ReadTOC();
   ReadOverrides();
 
@@ -92,20 +154,69 @@ Archive::Archive(const std::string& filename, const std::string& regname)
   }
 }
 
-Archive::~Archive() {}
+Archive::~Archive() {
+  if (prefetch_thread_) {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      prefetch_shutdown_ = true;
+    }
+    prefetch_wakeup_.notify_all();
+    prefetch_thread_->join();
+  }
+}
 
 Scenario* Archive::GetScenario(int index) {
+  std::unique_lock<std::mutex> lock(mutex_);
+
+  // If the prefetch thread is in the middle of parsing this scenario, wait
+  // for it instead of doing the work twice.
+  prefetch_loaded_.wait(lock, [&] { return prefetch_loading_ != index; });
+
+  Scenario* scene = NULL;
   accessed_t::const_iterator at = accessed_.find(index);
-  if (at != accessed_.end())
-    return at->second.get();
-  scenarios_t::const_iterator st = scenarios_.find(index);
-  if (st != scenarios_.end()) {
-    Scenario* scene =
-        new Scenario(st->second, index, regname_, second_level_xor_key_);
-    accessed_[index].reset(scene);
-    return scene;
+  if (at != accessed_.end()) {
+    scene = at->second.get();
+  } else {
+    if (scenarios_.find(index) == scenarios_.end())
+      return NULL;
+
+    to_load_.erase(std::remove(to_load_.begin(), to_load_.end(), index),
+                   to_load_.end());
+
+    // Keep the prefetch thread from starting its own copy while we parse.
+    main_thread_loading_.insert(index);
+    lock.unlock();
+    std::unique_ptr<Scenario> loaded;
+    try {
+      loaded = LoadScenario(index);
+    }
+    catch (...) {
+      lock.lock();
+      main_thread_loading_.erase(index);
+      throw;
+    }
+    lock.lock();
+    main_thread_loading_.erase(index);
+
+    // Never replace an entry: someone may already hold a pointer to it.
+    scene = accessed_.emplace(index, std::move(loaded)).first->second.get();
   }
-  return NULL;
+
+  return scene;
+}
+
+void Archive::EnablePrefetching() {
+  if (!prefetch_thread_)
+    prefetch_thread_.reset(new std::thread(&Archive::PrefetchLoop, this));
+}
+
+void Archive::EnableDiskCache(const std::string& directory) {
+  cache_directory_ = directory;
+}
+
+Archive::DiskCacheStats Archive::GetDiskCacheStats() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return cache_stats_;
 }
 
 int Archive::GetProbableEncodingType() const {
@@ -120,6 +231,189 @@ int Archive::GetProbableEncodingType() const {
   return 0;
 }
 
+std::unique_ptr<Scenario> Archive::LoadScenario(int index) {
+  std::unique_ptr<Scenario> scenario;
+  if (!cache_directory_.empty()) {
+    const char* bytecode = ReadCachedBytecode(index);
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      if (bytecode)
+        cache_stats_.hits++;
+      else
+        cache_stats_.misses++;
+    }
+
+    if (bytecode)
+      scenario.reset(new Scenario(scenarios_.at(index), bytecode, index));
+  }
+
+  if (!scenario) {
+    scenario.reset(new Scenario(
+        scenarios_.at(index), index, regname_, second_level_xor_key_));
+    if (!cache_directory_.empty())
+      WriteCachedBytecode(index, *scenario);
+  }
+
+  // Nothing has been parsed yet; the prefetch thread follows the script's
+  // jumps as the interpreter parses its way through it.
+  scenario->set_region_parsed_callback(
+      [this, index](size_t region) { QueueRegionScan(index, region); });
+  return scenario;
+}
+
+const char* Archive::ReadCachedBytecode(int index) {
+  DiskCacheHeader expected;
+  if (!MakeDiskCacheHeader(SourceFile(index), scenarios_.at(index), regname_,
+                           &expected)) {
+    return NULL;
+  }
+
+  std::unique_ptr<Mapping> mapping;
+  try {
+    mapping.reset(new Mapping(CachePath(index), Read));
+  }
+  catch (Error& e) {
+    return NULL;
+  }
+
+  const char* data = mapping->get();
+  const size_t bytecode_offset = sizeof(expected) + regname_.size();
+  if (mapping->size() != bytecode_offset + expected.bytecode_length ||
+      memcmp(data, &expected, sizeof(expected)) != 0 ||
+      regname_.compare(0, regname_.size(), data + sizeof(expected),
+                       regname_.size()) != 0) {
+    return NULL;
+  }
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  cache_maps_.push_back(std::move(mapping));
+  return data + bytecode_offset;
+}
+
+void Archive::WriteCachedBytecode(int index, const Scenario& scenario) {
+  const char* bytecode = scenario.decompressed_bytecode();
+  DiskCacheHeader header;
+  if (!bytecode ||
+      !MakeDiskCacheHeader(SourceFile(index), scenarios_.at(index), regname_,
+                           &header)) {
+    return;
+  }
+
+  // Write to a temporary file and move it into place, so nobody ever maps a
+  // half written entry. The cache is only an optimization; give up quietly
+  // on any error.
+  boost::system::error_code ec;
+  fs::create_directories(cache_directory_, ec);
+  const std::string path = CachePath(index);
+  const std::string temp =
+      path + "." + fs::unique_path("%%%%%%%%").string() + ".tmp";
+  {
+    std::ofstream out(temp.c_str(), std::ios::out | std::ios::binary);
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    out.write(regname_.data(), regname_.size());
+    out.write(bytecode, scenario.bytecode_length());
+    out.close();
+    if (out.fail()) {
+      fs::remove(temp, ec);
+      return;
+    }
+  }
+
+  fs::rename(temp, path, ec);
+  if (ec) {
+    fs::remove(temp, ec);
+    return;
+  }
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  cache_stats_.writes++;
+}
+
+const std::string& Archive::SourceFile(int index) const {
+  std::map<int, std::string>::const_iterator it = override_files_.find(index);
+  return it != override_files_.end() ? it->second : name_;
+}
+
+std::string Archive::CachePath(int index) const {
+  std::ostringstream oss;
+  oss << "seen" << std::setw(4) << std::setfill('0') << index << ".cache";
+  return (fs::path(cache_directory_) / oss.str()).string();
+}
+
+void Archive::QueueRegionScan(int index, size_t region) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (!prefetch_thread_)
+    return;
+
+  to_scan_.emplace_back(index, region);
+  prefetch_wakeup_.notify_all();
+}
+
+void Archive::PrefetchLoop() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  while (true) {
+    prefetch_wakeup_.wait(lock, [&] {
+      return prefetch_shutdown_ || !to_scan_.empty() || !to_load_.empty();
+    });
+    if (prefetch_shutdown_)
+      return;
+
+    if (!to_scan_.empty()) {
+      std::pair<int, size_t> job = to_scan_.front();
+      to_scan_.pop_front();
+      accessed_t::const_iterator at = accessed_.find(job.first);
+      if (at == accessed_.end())
+        continue;
+
+      // Scenarios are never removed from |accessed_| and the scan only reads
+      // a region that is already parsed, under the Script's own lock, so
+      // this doesn't need |mutex_|.
+      Scenario* scene = at->second.get();
+      lock.unlock();
+      std::vector<int> targets;
+      try {
+        targets = scene->GetReachableScenarios(job.second);
+      }
+      catch (...) {
+        // Nothing worth prefetching, then.
+      }
+      lock.lock();
+
+      for (int target : targets) {
+        if (scenarios_.count(target) && !accessed_.count(target) &&
+            !main_thread_loading_.count(target) &&
+            std::find(to_load_.begin(), to_load_.end(), target) ==
+                to_load_.end()) {
+          to_load_.push_back(target);
+        }
+      }
+    } else {
+      int index = to_load_.front();
+      to_load_.pop_front();
+      if (accessed_.count(index) || main_thread_loading_.count(index))
+        continue;
+
+      prefetch_loading_ = index;
+      lock.unlock();
+      std::unique_ptr<Scenario> loaded;
+      try {
+        loaded = LoadScenario(index);
+      }
+      catch (...) {
+        // Leave the scenario unloaded; GetScenario() will parse it again
+        // and report the error on the main thread where it can be handled.
+      }
+      lock.lock();
+
+      // GetScenario() may have loaded it in the meantime; keep its copy.
+      if (loaded)
+        accessed_.emplace(index, std::move(loaded));
+      prefetch_loading_ = -1;
+      prefetch_loaded_.notify_all();
+    }
+  }
+}
+
 void Archive::ReadTOC() {
   const char* idx = info_.get();
   for (int i = 0; i < 10000; ++i, idx += 8) {
@@ -144,6 +438,7 @@ void Archive::ReadOverrides() {
 
       int index = std::stoi(filename.substr(4, 4));
       scenarios_[index] = FilePos(mapping->get(), mapping->size());
+      override_files_[index] = (seen_dir / filename).string();
     }
   }
 }
@@ -34,9 +34,15 @@
 #ifndef SRC_LIBREALLIVE_ARCHIVE_H_
 #define SRC_LIBREALLIVE_ARCHIVE_H_
 
+#include <condition_variable>
+#include <deque>
 #include <map>
 #include <memory>
+#include <mutex>
+#include <set>
 #include <string>
+#include <thread>
+#include <utility>
 #include <vector>
 
 #include "libreallive/defs.h"
@@ -67,6 +73,29 @@ class Archive {
   // Returns a specific scenario by |index| number or NULL if none exist.
   Scenario* GetScenario(int index);
 
+  // Starts a worker thread which decompresses and parses the scenarios that
+  // the scenarios returned by GetScenario() can jump or farcall into, so that
+  // the later jump doesn't have to stall on them. Off by default.
+  void EnablePrefetching();
+  bool prefetching() const { return prefetch_thread_ != nullptr; }
+
+  // Keeps a decompressed copy of every scenario loaded in |directory|, so
+  // that later runs can map it instead of undoing the compression and xor
+  // again. Entries are checked against the size and modification time of the
+  // file the scenario came from and the game's REGNAME, and are rewritten
+  // when they don't match. Off by default; call before the first
+  // GetScenario().
+  void EnableDiskCache(const std::string& directory);
+
+  struct DiskCacheStats {
+    DiskCacheStats();
+
+    int hits;
+    int misses;
+    int writes;
+  };
+  DiskCacheStats GetDiskCacheStats() const;
+
   // Does a quick pass through all scenarios in the archive, looking for any
   // with non-default encoding. This short circuits when it finds one.
   int GetProbableEncodingType() const;
@@ -79,14 +108,54 @@ class Archive {
 
   void ReadOverrides();
 
+  // Decompresses and parses scenario |index|. Doesn't touch |accessed_|.
+  std::unique_ptr<Scenario> LoadScenario(int index);
+
+  // Returns the cached bytecode of scenario |index| if the disk cache has a
+  // valid entry for it, or NULL.
+  const char* ReadCachedBytecode(int index);
+
+  // Stores the decompressed bytecode of |scenario| in the disk cache.
+  void WriteCachedBytecode(int index, const Scenario& scenario);
+
+  // The file scenario |index| is read from.
+  const std::string& SourceFile(int index) const;
+
+  // Path of the cache entry for scenario |index|.
+  std::string CachePath(int index) const;
+
+  // Called whenever region |region| of scenario |index| has been parsed.
+  // Queues the region to be searched for jump targets to prefetch.
+  void QueueRegionScan(int index, size_t region);
+
+  // Body of |prefetch_thread_|.
+  void PrefetchLoop();
+
   scenarios_t scenarios_;
+
+  // Scenarios which have been parsed. Entries are never removed, so pointers
+  // to them stay valid for the lifetime of the Archive. Written to by the
+  // prefetch thread, so all access goes through |mutex_|.
   accessed_t accessed_;
+
   string name_;
   Mapping info_;
 
   // Mappings to unarchived SEEN\d{4}.TXT files on disk.
   std::vector<std::unique_ptr<Mapping>> maps_to_delete_;
 
+  // Scenarios whose data comes from one of |maps_to_delete_| rather than
+  // |name_|, and the file they come from.
+  std::map<int, std::string> override_files_;
+
+  // Disk cache directory, empty when the cache is off.
+  std::string cache_directory_;
+
+  // Mappings of the disk cache entries that scenarios were built from.
+  // Guarded by |mutex_|.
+  std::vector<std::unique_ptr<Mapping>> cache_maps_;
+  DiskCacheStats cache_stats_;
+
   // Now that VisualArts is using per game xor keys, this is equivalent to the
   // game's second level xor key.
   const compression::XorKey* second_level_xor_key_;
@@ -94,6 +163,27 @@ class Archive {
   // The #REGNAME key from the Gameexe.ini file. Passed down to Scenario for
   // prettier error messages.
   std::string regname_;
+
+  // Prefetching state. |mutex_| guards everything below and |accessed_|.
+  mutable std::mutex mutex_;
+  std::condition_variable prefetch_wakeup_;
+  std::condition_variable prefetch_loaded_;
+  std::unique_ptr<std::thread> prefetch_thread_;
+
+  // Parsed regions, as (scenario, region) pairs, whose jump targets still
+  // need to be found. Each region is parsed, and so queued, only once.
+  std::deque<std::pair<int, size_t>> to_scan_;
+
+  // Scenarios to load on the prefetch thread.
+  std::deque<int> to_load_;
+
+  // The scenario the prefetch thread is currently parsing, or -1.
+  int prefetch_loading_;
+
+  // Scenarios GetScenario() is parsing with |mutex_| released.
+  std::set<int> main_thread_loading_;
+
+  bool prefetch_shutdown_;
 };
 
 }  // namespace libreallive
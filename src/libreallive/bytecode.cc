@@ -42,6 +42,7 @@
 #include <utility>
 #include <vector>
 
+#include "libreallive/bytecode_arena.h"
 #include "libreallive/scenario.h"
 #include "libreallive/expression.h"
 
@@ -51,6 +52,37 @@ namespace libreallive {
 
 namespace {
 
+// Constructs a T in |arena|, or on the heap if there is no arena.
+template <typename T, typename... Args>
+T* MakeElement(BytecodeArena* arena, Args&&... args) {
+  if (arena)
+    return arena->Construct<T>(std::forward<Args>(args)...);
+  return new T(std::forward<Args>(args)...);
+}
+
+CommandElement* BuildFunctionElement(const char* stream,
+                                     BytecodeArena* arena) {
+  const char* ptr = stream;
+  ptr += 8;
+  std::vector<std::string> params;
+  if (*ptr == '(') {
+    const char* end = ptr + 1;
+    while (*end != ')') {
+      const size_t len = NextData(end);
+      params.emplace_back(end, len);
+      end += len;
+    }
+  }
+
+  if (params.size() == 0)
+    return MakeElement<VoidFunctionElement>(arena, stream);
+  else if (params.size() == 1)
+    return MakeElement<SingleArgFunctionElement>(arena, stream,
+                                                 params.front());
+  else
+    return MakeElement<FunctionElement>(arena, stream, params);
+}
+
 inline BytecodeElement* ReadFunction(const char* stream,
                                      ConstructionData& cdata) {
   // opcode: 0xttmmoooo (Type, Module, Opcode: e.g. 0x01030101 = 1:03:00257
@@ -63,7 +95,7 @@ inline BytecodeElement* ReadFunction(const char* stream,
     case 0x00050005:
     case 0x00060001:
     case 0x00060005:
-      return new GotoElement(stream, cdata);
+      return MakeElement<GotoElement>(cdata.arena, stream, cdata);
     case 0x00010001:
     case 0x00010002:
     case 0x00010006:
@@ -75,24 +107,24 @@ inline BytecodeElement* ReadFunction(const char* stream,
     case 0x00060002:
     case 0x00060006:
     case 0x00060007:
-      return new GotoIfElement(stream, cdata);
+      return MakeElement<GotoIfElement>(cdata.arena, stream, cdata);
     case 0x00010003:
     case 0x00010008:
     case 0x00050003:
     case 0x00050008:
     case 0x00060003:
     case 0x00060008:
-      return new GotoOnElement(stream, cdata);
+      return MakeElement<GotoOnElement>(cdata.arena, stream, cdata);
     case 0x00010004:
     case 0x00010009:
     case 0x00050004:
     case 0x00050009:
     case 0x00060004:
     case 0x00060009:
-      return new GotoCaseElement(stream, cdata);
+      return MakeElement<GotoCaseElement>(cdata.arena, stream, cdata);
     case 0x00010010:
     case 0x00060010:
-      return new GosubWithElement(stream, cdata);
+      return MakeElement<GosubWithElement>(cdata.arena, stream, cdata);
 
     // Select elements.
     case 0x00020000:
@@ -100,35 +132,18 @@ inline BytecodeElement* ReadFunction(const char* stream,
     case 0x00020002:
     case 0x00020003:
     case 0x00020010:
-      return new SelectElement(stream);
+      return MakeElement<SelectElement>(cdata.arena, stream);
   }
 
-  return BuildFunctionElement(stream);
+  return BuildFunctionElement(stream, cdata.arena);
 }
 
 }  // namespace
 
-char BytecodeElement::entrypoint_marker = '@';
+std::atomic<char> BytecodeElement::entrypoint_marker('@');
 
 CommandElement* BuildFunctionElement(const char* stream) {
-  const char* ptr = stream;
-  ptr += 8;
-  std::vector<std::string> params;
-  if (*ptr == '(') {
-    const char* end = ptr + 1;
-    while (*end != ')') {
-      const size_t len = NextData(end);
-      params.emplace_back(end, len);
-      end += len;
-    }
-  }
-
-  if (params.size() == 0)
-    return new VoidFunctionElement(stream);
-  else if (params.size() == 1)
-    return new SingleArgFunctionElement(stream, params.front());
-  else
-    return new FunctionElement(stream, params);
+  return BuildFunctionElement(stream, NULL);
 }
 
 void PrintParameterString(std::ostream& oss,
@@ -159,13 +174,20 @@ void PrintParameterString(std::ostream& oss,
 // ConstructionData
 // -----------------------------------------------------------------------
 
-ConstructionData::ConstructionData(size_t kt, pointer_t pt)
-    : kidoku_table(kt), null(pt) {}
+ConstructionData::ConstructionData(size_t kt, BytecodeArena* arena)
+    : kidoku_table(kt), arena(arena), script(NULL) {}
 
 // -----------------------------------------------------------------------
 
 ConstructionData::~ConstructionData() {}
 
+// -----------------------------------------------------------------------
+
+pointer_t ConstructionData::Find(unsigned long offset) const {
+  assert(script);
+  return script->FindElement(offset);
+}
+
 // -----------------------------------------------------------------------
 // Pointers
 // -----------------------------------------------------------------------
@@ -177,12 +199,8 @@ Pointers::~Pointers() {}
 void Pointers::SetPointers(ConstructionData& cdata) {
   assert(target_ids.size() != 0);
   targets.reserve(target_ids.size());
-  for (unsigned int i = 0; i < target_ids.size(); ++i) {
-    ConstructionData::offsets_t::const_iterator it =
-        cdata.offsets.find(target_ids[i]);
-    assert(it != cdata.offsets.end());
-    targets.push_back(it->second);
-  }
+  for (unsigned int i = 0; i < target_ids.size(); ++i)
+    targets.push_back(cdata.Find(target_ids[i]));
   target_ids.clear();
 }
 
@@ -223,18 +241,18 @@ BytecodeElement* BytecodeElement::Read(const char* stream,
   switch (c) {
     case 0:
     case ',':
-      return new CommaElement;
+      return MakeElement<CommaElement>(cdata.arena);
     case '\n':
-      return new MetaElement(0, stream);
+      return MakeElement<MetaElement>(cdata.arena, nullptr, stream);
     case '@':  // fall through
     case '!':
-      return new MetaElement(&cdata, stream);
+      return MakeElement<MetaElement>(cdata.arena, &cdata, stream);
     case '$':
-      return new ExpressionElement(stream);
+      return MakeElement<ExpressionElement>(cdata.arena, stream);
     case '#':
       return ReadFunction(stream, cdata);
     default:
-      return new TextoutElement(stream, end);
+      return MakeElement<TextoutElement>(cdata.arena, stream, end);
   }
 }
 
@@ -373,16 +391,19 @@ ExpressionElement::ExpressionElement(const char* src)
   const char* end = src;
   parsed_expression_ = GetAssignment(end);
   length_ = std::distance(src, end);
+  compiled_expression_ = CompiledExpression(parsed_expression_);
 }
 
 ExpressionElement::ExpressionElement(const long val)
     : length_(0),
-      parsed_expression_(ExpressionPiece::IntConstant(val)) {
+      parsed_expression_(ExpressionPiece::IntConstant(val)),
+      compiled_expression_(parsed_expression_) {
 }
 
 ExpressionElement::ExpressionElement(const ExpressionElement& rhs)
     : length_(0),
-      parsed_expression_(rhs.parsed_expression_) {
+      parsed_expression_(rhs.parsed_expression_),
+      compiled_expression_(rhs.compiled_expression_) {
 }
 
 ExpressionElement::~ExpressionElement() {}
@@ -433,6 +454,12 @@ const ExpressionPiecesVector& CommandElement::GetParsedParameters() const {
   return parsed_parameters_;
 }
 
+void CommandElement::SetCachedOperation(int dispatch_id,
+                                        RLOperation* op) const {
+  cached_dispatch_id_ = dispatch_id;
+  cached_operation_ = op;
+}
+
 const size_t CommandElement::GetPointersCount() const { return 0; }
 
 pointer_t CommandElement::GetPointer(int i) const { return pointer_t(); }
@@ -730,9 +757,7 @@ pointer_t GotoElement::GetPointer(int i) const {
 const size_t GotoElement::GetBytecodeLength() const { return 12; }
 
 void GotoElement::SetPointers(ConstructionData& cdata) {
-  ConstructionData::offsets_t::const_iterator it = cdata.offsets.find(id_);
-  assert(it != cdata.offsets.end());
-  pointer_ = it->second;
+  pointer_ = cdata.Find(id_);
 }
 
 // -----------------------------------------------------------------------
@@ -782,9 +807,7 @@ const size_t GotoIfElement::GetBytecodeLength() const {
 }
 
 void GotoIfElement::SetPointers(ConstructionData& cdata) {
-  ConstructionData::offsets_t::const_iterator it = cdata.offsets.find(id_);
-  assert(it != cdata.offsets.end());
-  pointer_ = it->second;
+  pointer_ = cdata.Find(id_);
 }
 
 // -----------------------------------------------------------------------
@@ -930,9 +953,7 @@ const size_t GosubWithElement::GetBytecodeLength() const {
 }
 
 void GosubWithElement::SetPointers(ConstructionData& cdata) {
-  ConstructionData::offsets_t::const_iterator it = cdata.offsets.find(id_);
-  assert(it != cdata.offsets.end());
-  pointer_ = it->second;
+  pointer_ = cdata.Find(id_);
 }
 
 }  // namespace libreallive
@@ -34,16 +34,19 @@
 #ifndef SRC_LIBREALLIVE_BYTECODE_H_
 #define SRC_LIBREALLIVE_BYTECODE_H_
 
+#include <atomic>
 #include <cstdint>
 #include <map>
 #include <string>
 #include <vector>
 
 #include "libreallive/bytecode_fwd.h"
+#include "libreallive/compiled_expression.h"
 #include "libreallive/defs.h"
 #include "libreallive/expression.h"
 
 class RLMachine;
+class RLOperation;
 
 namespace libreallive {
 
@@ -56,13 +59,21 @@ void PrintParameterString(std::ostream& oss,
                           const std::vector<std::string>& paramseters);
 
 struct ConstructionData {
-  ConstructionData(size_t kt, pointer_t pt);
+  ConstructionData(size_t kt, BytecodeArena* arena);
   ~ConstructionData();
 
+  // Returns the element that starts at byte |offset|.
+  pointer_t Find(unsigned long offset) const;
+
   std::vector<unsigned long> kidoku_table;
-  pointer_t null;
-  typedef std::map<unsigned long, pointer_t> offsets_t;
-  offsets_t offsets;
+
+  // Where Read() constructs elements. When NULL, elements are allocated on
+  // the heap and owned by the caller.
+  BytecodeArena* arena;
+
+  // The Script being read. Jump targets are resolved through it, which may
+  // parse the part of the script they land in.
+  const Script* script;
 };
 
 class Pointers {
@@ -120,13 +131,15 @@ class BytecodeElement {
   // Execute this bytecode instruction on this virtual machine
   virtual void RunOnMachine(RLMachine& machine) const;
 
-  // Read the next element from a stream.
+  // Read the next element from a stream. The element is constructed in
+  // |cdata.arena| if there is one; otherwise the caller owns it.
   static BytecodeElement* Read(const char* stream,
                                const char* end,
                                ConstructionData& cdata);
 
  protected:
-  static char entrypoint_marker;
+  // Written while parsing, which may happen on Archive's prefetch thread.
+  static std::atomic<char> entrypoint_marker;
   BytecodeElement(const BytecodeElement& c);
 
  private:
@@ -199,6 +212,12 @@ class ExpressionElement : public BytecodeElement {
   // Returns an ExpressionPiece representing this expression.
   const ExpressionPiece& ParsedExpression() const;
 
+  // Returns the flattened form of ParsedExpression(). May be invalid, in which
+  // case the ExpressionPiece must be evaluated instead.
+  const CompiledExpression& GetCompiledExpression() const {
+    return compiled_expression_;
+  }
+
   // Overridden from BytecodeElement:
   virtual void PrintSourceRepresentation(RLMachine* machine,
                                          std::ostream& oss) const final;
@@ -211,6 +230,8 @@ class ExpressionElement : public BytecodeElement {
   // Storage for the parsed expression so we only have to calculate
   // it once (and so we can return it by const reference)
   ExpressionPiece parsed_expression_;
+
+  CompiledExpression compiled_expression_;
 };
 
 // Command elements.
@@ -237,6 +258,14 @@ class CommandElement : public BytecodeElement {
   void SetParsedParameters(ExpressionPiecesVector p) const;
   const ExpressionPiecesVector& GetParsedParameters() const;
 
+  // Gets/Sets the RLOperation this command was resolved to by the RLMachine
+  // whose set of modules is identified by |dispatch_id|. Returns NULL if this
+  // command hasn't been resolved against that set of modules.
+  RLOperation* GetCachedOperation(int dispatch_id) const {
+    return dispatch_id == cached_dispatch_id_ ? cached_operation_ : nullptr;
+  }
+  void SetCachedOperation(int dispatch_id, RLOperation* op) const;
+
   // Returns the number of parameters.
   virtual const size_t GetParamCount() const = 0;
   virtual string GetParam(int index) const = 0;
@@ -259,6 +288,9 @@ class CommandElement : public BytecodeElement {
   unsigned char command[COMMAND_SIZE];
 
   mutable std::vector<ExpressionPiece> parsed_parameters_;
+
+  mutable int cached_dispatch_id_ = 0;
+  mutable RLOperation* cached_operation_ = nullptr;
 };
 
 class SelectElement : public CommandElement {
@@ -0,0 +1,88 @@
+// -*- Mode: C++; tab-width:2; indent-tabs-mode: nil; c-basic-offset: 2 -*-
+// vi:tw=80:et:ts=2:sts=2
+//
+// -----------------------------------------------------------------------
+//
+// This file is part of libreallive, a dependency of RLVM.
+//
+// -----------------------------------------------------------------------
+//
+// Copyright (c) 2015 Elliot Glaysher
+//
+// Permission is hereby granted, free of charge, to any person
+// obtaining a copy of this software and associated documentation
+// files (the "Software"), to deal in the Software without
+// restriction, including without limitation the rights to use, copy,
+// modify, merge, publish, distribute, sublicense, and/or sell copies
+// of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+// BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+// ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+
+#include "libreallive/bytecode_arena.h"
+
+#include <cstdint>
+
+#include "libreallive/bytecode.h"
+
+namespace libreallive {
+
+namespace {
+
+// Alignment for every allocation. BytecodeElements hold vectors, strings and
+// pointers, so the fundamental alignment is always enough.
+const size_t kAlignment = alignof(std::max_align_t);
+
+size_t RoundUp(size_t size) {
+  return (size + kAlignment - 1) & ~(kAlignment - 1);
+}
+
+}  // namespace
+
+BytecodeArena::BytecodeArena()
+    : cursor_(NULL), limit_(NULL), bytes_used_(0) {}
+
+BytecodeArena::~BytecodeArena() {
+  for (auto it = elements_.rbegin(); it != elements_.rend(); ++it)
+    (*it)->~BytecodeElement();
+}
+
+void* BytecodeArena::Allocate(size_t size) {
+  size = RoundUp(size);
+  bytes_used_ += size;
+
+  if (size > kBlockSize) {
+    // Oversized: give it a dedicated block, but keep bumping in the current
+    // one.
+    blocks_.emplace_back(new char[size + kAlignment]);
+    char* block = blocks_.back().get();
+    return block + (RoundUp(reinterpret_cast<uintptr_t>(block)) -
+                    reinterpret_cast<uintptr_t>(block));
+  }
+
+  if (cursor_ == NULL || static_cast<size_t>(limit_ - cursor_) < size) {
+    blocks_.emplace_back(new char[kBlockSize + kAlignment]);
+    char* block = blocks_.back().get();
+    cursor_ = block + (RoundUp(reinterpret_cast<uintptr_t>(block)) -
+                       reinterpret_cast<uintptr_t>(block));
+    limit_ = cursor_ + kBlockSize;
+  }
+
+  void* memory = cursor_;
+  cursor_ += size;
+  return memory;
+}
+
+}  // namespace libreallive
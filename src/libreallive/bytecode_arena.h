@@ -0,0 +1,94 @@
+// -*- Mode: C++; tab-width:2; indent-tabs-mode: nil; c-basic-offset: 2 -*-
+// vi:tw=80:et:ts=2:sts=2
+//
+// -----------------------------------------------------------------------
+//
+// This file is part of libreallive, a dependency of RLVM.
+//
+// -----------------------------------------------------------------------
+//
+// Copyright (c) 2015 Elliot Glaysher
+//
+// Permission is hereby granted, free of charge, to any person
+// obtaining a copy of this software and associated documentation
+// files (the "Software"), to deal in the Software without
+// restriction, including without limitation the rights to use, copy,
+// modify, merge, publish, distribute, sublicense, and/or sell copies
+// of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+// BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+// ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+
+#ifndef SRC_LIBREALLIVE_BYTECODE_ARENA_H_
+#define SRC_LIBREALLIVE_BYTECODE_ARENA_H_
+
+#include <cstddef>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "libreallive/bytecode_fwd.h"
+
+namespace libreallive {
+
+// Bump allocator that owns the BytecodeElements of one Script. A SEEN file
+// parses into tens of thousands of small elements; instead of giving each one
+// its own heap allocation, they are placement constructed back to back in
+// large blocks, so elements that are next to each other in the bytecode are
+// next to each other in memory. Everything is destroyed together when the
+// arena goes away.
+class BytecodeArena {
+ public:
+  BytecodeArena();
+  ~BytecodeArena();
+
+  // Constructs a T in the arena. The arena keeps ownership.
+  template <typename T, typename... Args>
+  T* Construct(Args&&... args) {
+    void* memory = Allocate(sizeof(T));
+    T* element = new (memory) T(std::forward<Args>(args)...);
+    elements_.push_back(element);
+    return element;
+  }
+
+  // Number of elements constructed so far.
+  size_t size() const { return elements_.size(); }
+
+  // Bytes handed out to elements, not counting slack at the end of blocks.
+  size_t bytes_used() const { return bytes_used_; }
+
+  // Size of a normal block. Elements larger than this get a block of their
+  // own.
+  static const size_t kBlockSize = 64 * 1024;
+
+ private:
+  // Returns |size| bytes of suitably aligned memory.
+  void* Allocate(size_t size);
+
+  std::vector<std::unique_ptr<char[]>> blocks_;
+  char* cursor_;
+  char* limit_;
+  size_t bytes_used_;
+
+  // Every constructed element, so their destructors can be run.
+  std::vector<BytecodeElement*> elements_;
+
+  BytecodeArena(const BytecodeArena&) = delete;
+  BytecodeArena& operator=(const BytecodeArena&) = delete;
+};
+
+}  // namespace libreallive
+
+#endif  // SRC_LIBREALLIVE_BYTECODE_ARENA_H_
@@ -29,17 +29,16 @@
 #ifndef SRC_LIBREALLIVE_BYTECODE_FWD_H_
 #define SRC_LIBREALLIVE_BYTECODE_FWD_H_
 
-#include <forward_list>
-#include <memory>
+#include "libreallive/script_iterator.h"
 
 namespace libreallive {
 
 // List definitions.
 class ExpressionPiece;
 class BytecodeElement;
-typedef std::forward_list<std::unique_ptr<BytecodeElement>> BytecodeList;
-typedef BytecodeList::iterator pointer_t;
+typedef ScriptIterator pointer_t;
 
+class BytecodeArena;
 struct ConstructionData;
 class Pointers;
 
@@ -0,0 +1,265 @@
+// -*- Mode: C++; tab-width:2; indent-tabs-mode: nil; c-basic-offset: 2 -*-
+// vi:tw=80:et:ts=2:sts=2
+//
+// -----------------------------------------------------------------------
+//
+// This file is part of libreallive, a dependency of RLVM.
+//
+// -----------------------------------------------------------------------
+//
+// Copyright (c) 2015 Elliot Glaysher
+//
+// Permission is hereby granted, free of charge, to any person
+// obtaining a copy of this software and associated documentation
+// files (the "Software"), to deal in the Software without
+// restriction, including without limitation the rights to use, copy,
+// modify, merge, publish, distribute, sublicense, and/or sell copies
+// of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+// BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+// ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#include "libreallive/compiled_expression.h"
+
+#include "libreallive/expression.h"
+#include "libreallive/intmemref.h"
+#include "machine/memory.h"
+#include "machine/rlmachine.h"
+
+namespace libreallive {
+
+CompiledExpression::CompiledExpression() : depth_(0), max_depth_(0) {}
+
+CompiledExpression::CompiledExpression(const ExpressionPiece& piece)
+    : depth_(0), max_depth_(0) {
+  if (!Compile(piece) || max_depth_ > kMaxStackDepth)
+    code_.clear();
+
+  code_.shrink_to_fit();
+}
+
+CompiledExpression::~CompiledExpression() {}
+
+int CompiledExpression::Evaluate(RLMachine& machine) const {
+  int stack[kMaxStackDepth];
+  int sp = 0;
+
+  Memory& memory = machine.memory();
+  for (const Instruction& inst : code_) {
+    switch (inst.op) {
+      case OP_PUSH_CONSTANT:
+        stack[sp++] = inst.value;
+        break;
+      case OP_PUSH_STORE_REGISTER:
+        stack[sp++] = machine.store_register();
+        break;
+      case OP_LOAD_DIRECT:
+        stack[sp++] = memory.GetIntBank(inst.bank)[inst.value];
+        break;
+      case OP_LOAD:
+        stack[sp++] = machine.GetIntValue(
+            IntMemRef(inst.bank, inst.access_type, inst.value));
+        break;
+      case OP_LOAD_INDIRECT:
+        stack[sp - 1] = machine.GetIntValue(
+            IntMemRef(inst.bank, inst.access_type, stack[sp - 1]));
+        break;
+      case OP_NEGATE:
+        stack[sp - 1] = -stack[sp - 1];
+        break;
+      case OP_BINARY:
+        --sp;
+        stack[sp - 1] = ExpressionPiece::PerformBinaryOperationOn(
+            inst.value, stack[sp - 1], stack[sp]);
+        break;
+      case OP_ASSIGN_STORE_REGISTER:
+        machine.set_store_register(stack[sp - 1]);
+        break;
+      case OP_ASSIGN:
+        machine.SetIntValue(
+            IntMemRef(inst.bank, inst.access_type, inst.value),
+            stack[sp - 1]);
+        break;
+      case OP_ASSIGN_INDIRECT:
+        --sp;
+        machine.SetIntValue(
+            IntMemRef(inst.bank, inst.access_type, stack[sp]),
+            stack[sp - 1]);
+        break;
+    }
+  }
+
+  return stack[0];
+}
+
+bool CompiledExpression::Compile(const ExpressionPiece& piece) {
+  switch (piece.piece_type) {
+    case TYPE_STORE_REGISTER:
+      Emit(OP_PUSH_STORE_REGISTER, 0);
+      return true;
+    case TYPE_INT_CONSTANT:
+      Emit(OP_PUSH_CONSTANT, piece.int_constant);
+      return true;
+    case TYPE_SIMPLE_MEMORY_REFERENCE: {
+      if (is_string_location(piece.simple_mem_reference.type))
+        return false;
+
+      IntMemRef ref(piece.simple_mem_reference.type,
+                    piece.simple_mem_reference.location);
+      if (ref.type() == 0 && ref.bank() >= INTA_LOCATION &&
+          ref.bank() <= INTZ_LOCATION && ref.location() >= 0 &&
+          ref.location() < SIZE_OF_MEM_BANK) {
+        // Bounds were checked here, so this can index the bank directly.
+        Emit(OP_LOAD_DIRECT, ref.location(), ref.bank());
+      } else {
+        Emit(OP_LOAD, ref.location(), ref.bank(), ref.type());
+      }
+      return true;
+    }
+    case TYPE_MEMORY_REFERENCE: {
+      if (is_string_location(piece.mem_reference.type) ||
+          !Compile(*piece.mem_reference.location))
+        return false;
+
+      IntMemRef ref(piece.mem_reference.type, 0);
+      Emit(OP_LOAD_INDIRECT, 0, ref.bank(), ref.type());
+      return true;
+    }
+    case TYPE_UNIARY_EXPRESSION: {
+      if (!Compile(*piece.uniary_expression.operand))
+        return false;
+
+      // Every other uniary operation is the identity.
+      if (piece.uniary_expression.operation == 0x01) {
+        if (code_.back().op == OP_PUSH_CONSTANT)
+          code_.back().value = -code_.back().value;
+        else
+          Emit(OP_NEGATE, 0);
+      }
+      return true;
+    }
+    case TYPE_BINARY_EXPRESSION: {
+      const char operation = piece.binary_expression.operation;
+      if (operation >= 20 && operation <= 30) {
+        return CompileAssignment(*piece.binary_expression.left_operand,
+                                 operation,
+                                 *piece.binary_expression.right_operand);
+      }
+
+      if (!Compile(*piece.binary_expression.left_operand) ||
+          !Compile(*piece.binary_expression.right_operand))
+        return false;
+
+      size_t size = code_.size();
+      if (code_[size - 2].op == OP_PUSH_CONSTANT &&
+          code_[size - 1].op == OP_PUSH_CONSTANT) {
+        // Constant fold. The parser already does this for literal operands,
+        // but not for operands which only became constant here, such as
+        // negated literals.
+        try {
+          code_[size - 2].value = ExpressionPiece::PerformBinaryOperationOn(
+              operation, code_[size - 2].value, code_[size - 1].value);
+        }
+        catch (Error& e) {
+          // Leave invalid operators to be reported at runtime.
+          return false;
+        }
+        code_.pop_back();
+        depth_--;
+      } else {
+        Emit(OP_BINARY, operation);
+      }
+      return true;
+    }
+    case TYPE_SIMPLE_ASSIGNMENT: {
+      IntMemRef ref(piece.simple_assignment.type,
+                    piece.simple_assignment.location);
+      Emit(OP_PUSH_CONSTANT, piece.simple_assignment.value);
+      Emit(OP_ASSIGN, ref.location(), ref.bank(), ref.type());
+      return true;
+    }
+    default:
+      return false;
+  }
+}
+
+bool CompiledExpression::CompileAssignment(const ExpressionPiece& lhs,
+                                           int operation,
+                                           const ExpressionPiece& rhs) {
+  if (lhs.piece_type != TYPE_STORE_REGISTER && !lhs.IsMemoryReference())
+    return false;
+
+  // Compound assignments read the left hand side before evaluating the right
+  // hand side, the same as ExpressionPiece::GetIntegerValue().
+  if (operation != 30) {
+    if (!Compile(lhs) || !Compile(rhs))
+      return false;
+    Emit(OP_BINARY, operation);
+  } else if (!Compile(rhs)) {
+    return false;
+  }
+
+  switch (lhs.piece_type) {
+    case TYPE_STORE_REGISTER:
+      Emit(OP_ASSIGN_STORE_REGISTER, 0);
+      return true;
+    case TYPE_SIMPLE_MEMORY_REFERENCE: {
+      if (is_string_location(lhs.simple_mem_reference.type))
+        return false;
+      IntMemRef ref(lhs.simple_mem_reference.type,
+                    lhs.simple_mem_reference.location);
+      Emit(OP_ASSIGN, ref.location(), ref.bank(), ref.type());
+      return true;
+    }
+    case TYPE_MEMORY_REFERENCE: {
+      if (is_string_location(lhs.mem_reference.type) ||
+          !Compile(*lhs.mem_reference.location))
+        return false;
+      IntMemRef ref(lhs.mem_reference.type, 0);
+      Emit(OP_ASSIGN_INDIRECT, 0, ref.bank(), ref.type());
+      return true;
+    }
+    default:
+      return false;
+  }
+}
+
+void CompiledExpression::Emit(Opcode op, int value, int bank,
+                              int access_type) {
+  Instruction inst;
+  inst.op = op;
+  inst.bank = bank;
+  inst.access_type = access_type;
+  inst.value = value;
+  code_.push_back(inst);
+
+  switch (op) {
+    case OP_PUSH_CONSTANT:
+    case OP_PUSH_STORE_REGISTER:
+    case OP_LOAD_DIRECT:
+    case OP_LOAD:
+      depth_++;
+      break;
+    case OP_BINARY:
+    case OP_ASSIGN_INDIRECT:
+      depth_--;
+      break;
+    default:
+      break;
+  }
+  if (depth_ > max_depth_)
+    max_depth_ = depth_;
+}
+
+}  // namespace libreallive
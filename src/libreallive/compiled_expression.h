@@ -0,0 +1,122 @@
+// -*- Mode: C++; tab-width:2; indent-tabs-mode: nil; c-basic-offset: 2 -*-
+// vi:tw=80:et:ts=2:sts=2
+//
+// -----------------------------------------------------------------------
+//
+// This file is part of libreallive, a dependency of RLVM.
+//
+// -----------------------------------------------------------------------
+//
+// Copyright (c) 2015 Elliot Glaysher
+//
+// Permission is hereby granted, free of charge, to any person
+// obtaining a copy of this software and associated documentation
+// files (the "Software"), to deal in the Software without
+// restriction, including without limitation the rights to use, copy,
+// modify, merge, publish, distribute, sublicense, and/or sell copies
+// of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+// BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+// ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#ifndef SRC_LIBREALLIVE_COMPILED_EXPRESSION_H_
+#define SRC_LIBREALLIVE_COMPILED_EXPRESSION_H_
+
+#include <cstdint>
+#include <vector>
+
+class RLMachine;
+
+namespace libreallive {
+
+class ExpressionPiece;
+
+// A flattened version of an integer ExpressionPiece tree. Instead of walking
+// heap allocated nodes and going through RLMachine::GetIntValue() for every
+// memory access, the expression is lowered once into a contiguous array of
+// stack machine instructions which Evaluate() runs in a single loop. Reads
+// from intA[]..intZ[] with a constant index go straight to the Memory banks.
+//
+// Not every expression can be compiled (strings, complex and special
+// parameters can't); in that case is_valid() returns false and the caller
+// should fall back to ExpressionPiece::GetIntegerValue().
+class CompiledExpression {
+ public:
+  CompiledExpression();
+  explicit CompiledExpression(const ExpressionPiece& piece);
+  ~CompiledExpression();
+
+  bool is_valid() const { return !code_.empty(); }
+
+  // Runs the compiled program. Has the same side effects and returns the same
+  // value as ExpressionPiece::GetIntegerValue() on the source expression.
+  int Evaluate(RLMachine& machine) const;
+
+  // Maximum depth of the evaluation stack. Deeper expressions are left
+  // uncompiled.
+  static const int kMaxStackDepth = 32;
+
+ private:
+  enum Opcode : uint8_t {
+    // Pushes |value|.
+    OP_PUSH_CONSTANT,
+    // Pushes the store register.
+    OP_PUSH_STORE_REGISTER,
+    // Pushes memory_bank[|value|] for a plain int bank other than intL.
+    OP_LOAD_DIRECT,
+    // Pushes the memory location at (|bank|, |access_type|, |value|).
+    OP_LOAD,
+    // Pops a location and pushes the memory at (|bank|, |access_type|, loc).
+    OP_LOAD_INDIRECT,
+    // Negates the top of the stack.
+    OP_NEGATE,
+    // Pops rhs and lhs and pushes the result of binary operation |value|.
+    OP_BINARY,
+    // Sets the store register to the top of the stack.
+    OP_ASSIGN_STORE_REGISTER,
+    // Writes the top of the stack to (|bank|, |access_type|, |value|).
+    OP_ASSIGN,
+    // Pops a location and writes the top of the stack to (|bank|,
+    // |access_type|, location).
+    OP_ASSIGN_INDIRECT
+  };
+
+  struct Instruction {
+    Opcode op;
+    uint8_t bank;
+    uint8_t access_type;
+    int value;
+  };
+
+  // Appends the code for |piece| to |code_|, tracking the stack depth.
+  // Returns false if |piece| can't be compiled.
+  bool Compile(const ExpressionPiece& piece);
+
+  // Appends the code for one of the assignment operators (20-30), where |lhs|
+  // is the store register or a memory reference. Returns false otherwise.
+  bool CompileAssignment(const ExpressionPiece& lhs, int operation,
+                         const ExpressionPiece& rhs);
+
+  void Emit(Opcode op, int value, int bank = 0, int access_type = 0);
+
+  std::vector<Instruction> code_;
+
+  // Current and maximum stack depth during compilation.
+  int depth_;
+  int max_depth_;
+};
+
+}  // namespace libreallive
+
+#endif  // SRC_LIBREALLIVE_COMPILED_EXPRESSION_H_
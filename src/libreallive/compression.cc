@@ -33,14 +33,21 @@
 
 #include "libreallive/compression.h"
 
+#include <cstdint>
+#include <cstring>
+#include <memory>
 #include <string>
 
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
 namespace libreallive {
 namespace compression {
 
 /* RealLive uses a rather basic XOR encryption scheme, to which this
  * is the key. */
-static char xor_mask[256] = {
+const char xor_mask[256] = {
     0x8b, 0xe5, 0x5d, 0xc3, 0xa1, 0xe0, 0x30, 0x44, 0x00, 0x85, 0xc0, 0x74,
     0x09, 0x5f, 0x5e, 0x33, 0xc0, 0x5b, 0x8b, 0xe5, 0x5d, 0xc3, 0x8b, 0x45,
     0x0c, 0x85, 0xc0, 0x75, 0x14, 0x8b, 0x55, 0xec, 0x83, 0xc2, 0x20, 0x52,
@@ -114,36 +121,94 @@ const XorKey kud_wafter_all_ages_xor_mask[] = {
 
 // -----------------------------------------------------------------------
 
+namespace {
+
+// Undoes the first level xor. Byte |i| of the compressed data is xored with
+// xor_mask[i % 256]; the key repeats every 256 bytes, so both can be walked
+// in step a block at a time.
+void RemoveXorMask(const char* src, char* dst, size_t len) {
+  size_t i = 0;
+
+#if defined(__SSE2__)
+  for (; i + 16 <= len; i += 16) {
+    __m128i data = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+    __m128i key = _mm_loadu_si128(
+        reinterpret_cast<const __m128i*>(xor_mask + (i & 0xff)));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i),
+                     _mm_xor_si128(data, key));
+  }
+#else
+  for (; i + 8 <= len; i += 8) {
+    uint64_t data, key;
+    std::memcpy(&data, src + i, sizeof(data));
+    std::memcpy(&key, xor_mask + (i & 0xff), sizeof(key));
+    data ^= key;
+    std::memcpy(dst + i, &data, sizeof(data));
+  }
+#endif
+
+  for (; i < len; ++i)
+    dst[i] = src[i] ^ xor_mask[i & 0xff];
+}
+
+}  // namespace
+
 // Decompress an archived file.
 void Decompress(const char* src,
                 size_t src_len,
                 char* dst,
                 size_t dst_len,
                 const XorKey* per_game_xor_key) {
-  int bit = 1;
-  const char* srcend = src + src_len;
+  if (src_len <= 8)
+    return;
+
+  // Strip the xor in one pass up front, so the LZ loop only deals with plain
+  // bytes.
+  std::unique_ptr<char[]> plain(new char[src_len]);
+  RemoveXorMask(src, plain.get(), src_len);
+
+  const unsigned char* in =
+      reinterpret_cast<const unsigned char*>(plain.get()) + 8;
+  const unsigned char* inend =
+      reinterpret_cast<const unsigned char*>(plain.get()) + src_len;
   char* dststart = dst;
   char* dstend = dst + dst_len;
-  src += 8;
-  unsigned char mask = 8;
-  char flag = *src++ ^ xor_mask[mask++];
-  while (src < srcend && dst < dstend) {
+  int bit = 1;
+  int flag = *in++;
+  while (in < inend && dst < dstend) {
     if (bit == 256) {
       bit = 1;
-      flag = *src++ ^ xor_mask[mask++];
+      flag = *in++;
     }
     if (flag & bit) {
-      *dst++ = *src++ ^ xor_mask[mask++];
+      *dst++ = *in++;
     } else {
-      char* repeat;
-      int count = *src++ ^ xor_mask[mask++];
-      count += (*src++ ^ xor_mask[mask++]) << 8;
-      repeat = dst - ((count >> 4) - 1) - 1;
-      count = (count & 0x0f) + 2;
-      if (repeat < dststart || repeat >= dst)
+      // A back reference: 12 bits of distance and 4 bits of length. If the
+      // data ends halfway through the pair, the missing byte reads as zero.
+      int count = *in++;
+      if (in < inend)
+        count |= *in << 8;
+      ++in;
+      const size_t distance = count >> 4;
+      size_t length = (count & 0x0f) + 2;
+      if (distance == 0 || distance > size_t(dst - dststart))
         throw Error("corrupt data");
-      for (int i = 0; i < count; i++)
-        *dst++ = *repeat++;
+      if (length > size_t(dstend - dst))
+        length = dstend - dst;
+
+      const char* repeat = dst - distance;
+      if (distance >= 8 && dstend - dst >= 24) {
+        // The source never overlaps the eight bytes being written, so copy a
+        // word at a time. This may write up to seven bytes past the match,
+        // which the next item overwrites.
+        for (size_t i = 0; i < length; i += 8)
+          std::memcpy(dst + i, repeat + i, 8);
+      } else {
+        // Short distance: the match repeats bytes it has just written.
+        for (size_t i = 0; i < length; ++i)
+          dst[i] = repeat[i];
+      }
+      dst += length;
     }
     bit <<= 1;
   }
@@ -43,6 +43,10 @@ struct XorKey {
   int xor_length;
 };
 
+// The xor key over all compressed scenario data. Byte i of a compressed
+// scenario is xored with xor_mask[i % 256].
+extern const char xor_mask[256];
+
 // Per game xor keys to be passed to decompress, terminated with -1 offset
 // entries.
 extern const XorKey little_busters_xor_mask[];
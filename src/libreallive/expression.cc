@@ -889,6 +889,21 @@ bool ExpressionPiece::IsSpecialParameter() const {
   return piece_type == TYPE_SPECIAL_EXPRESSION;
 }
 
+bool ExpressionPiece::IsIntConstant() const {
+  return piece_type == TYPE_INT_CONSTANT;
+}
+
+int ExpressionPiece::GetIntConstant() const {
+  if (piece_type != TYPE_INT_CONSTANT) {
+    std::ostringstream ss;
+    ss << "ExpressionPiece::GetIntConstant() invalid on object of type "
+       << piece_type;
+    throw Error(ss.str());
+  }
+
+  return int_constant;
+}
+
 ExpressionValueType ExpressionPiece::GetExpressionValueType() const {
   switch (piece_type) {
     case TYPE_STRING_CONSTANT:
@@ -133,6 +133,13 @@ class ExpressionPiece {
   // @see Special_T
   bool IsSpecialParameter() const;
 
+  // Capability method; returns true when this piece is an integer constant,
+  // which means its value can be read without an RLMachine.
+  bool IsIntConstant() const;
+
+  // Returns the value of an integer constant. Throws when !IsIntConstant().
+  int GetIntConstant() const;
+
   // Returns the value type of this expression (i.e. string or
   // integer)
   ExpressionValueType GetExpressionValueType() const;
@@ -173,6 +180,8 @@ class ExpressionPiece {
   int GetOverloadTag() const;
 
  private:
+  friend class CompiledExpression;
+
   ExpressionPiece();
 
   // Frees all possible memory and sets |piece_type| to TYPE_INVALID.
@@ -59,6 +59,10 @@ class Mapping {
 
   size_t size() const { return len; }
 
+  // Whether the file is mmap()ed, rather than read into a heap copy because
+  // mapping failed.
+  bool is_mapped() const { return mapped; }
+
  private:
   void mopen();
   void mclose();
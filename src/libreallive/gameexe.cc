@@ -40,7 +40,6 @@
 
 #include <iostream>
 #include <fstream>
-#include <iomanip>
 
 #include "libreallive/defs.h"
 
@@ -109,11 +108,73 @@ class gameexe_token_extractor {
 
 // -----------------------------------------------------------------------
 
-Gameexe::Gameexe() {}
+namespace {
+
+// Hands out Gameexe::generation() values. Taking them from one counter keeps
+// them unique across Gameexe objects as well as across changes.
+int NextGeneration() {
+  static int next_generation = 0;
+  return ++next_generation;
+}
+
+}  // namespace
+
+// -----------------------------------------------------------------------
+// GameexeKey
+// -----------------------------------------------------------------------
+
+GameexeKey::GameexeKey(const std::string& key)
+    : key_(key), hash_(std::hash<std::string>()(key)) {}
+
+// -----------------------------------------------------------------------
+// GameexeIndexedKey
+// -----------------------------------------------------------------------
+
+GameexeIndexedKey::GameexeIndexedKey(const std::string& prefix)
+    : prefix_(prefix), generation_(0) {}
+
+// -----------------------------------------------------------------------
+
+GameexeIndexedKey::GameexeIndexedKey(const std::string& prefix,
+                                     const std::string& suffix)
+    : prefix_(prefix), suffix_(suffix), generation_(0) {}
+
+// -----------------------------------------------------------------------
+
+GameexeIndexedKey::~GameexeIndexedKey() {}
+
+// -----------------------------------------------------------------------
+
+const GameexeInterpretObject& GameexeIndexedKey::operator()(Gameexe& gexe,
+                                                            int index) {
+  if (generation_ != gexe.generation()) {
+    cache_.clear();
+    generation_ = gexe.generation();
+  }
+
+  std::unordered_map<int, GameexeInterpretObject>::const_iterator it =
+      cache_.find(index);
+  if (it == cache_.end()) {
+    if (suffix_.empty())
+      it = cache_.emplace(index, gexe(GameexeKey(prefix_, index))).first;
+    else
+      it = cache_.emplace(index, gexe(GameexeKey(prefix_, index, suffix_)))
+               .first;
+  }
+
+  return it->second;
+}
+
+// -----------------------------------------------------------------------
+// Gameexe
+// -----------------------------------------------------------------------
+
+Gameexe::Gameexe() : index_valid_(false), generation_(NextGeneration()) {}
 
 // -----------------------------------------------------------------------
 
-Gameexe::Gameexe(const fs::path& gameexefile) : data_(), cdata_() {
+Gameexe::Gameexe(const fs::path& gameexefile)
+    : data_(), cdata_(), index_valid_(false), generation_(NextGeneration()) {
   fs::ifstream ifs(gameexefile);
   if (!ifs) {
     std::ostringstream oss;
@@ -165,6 +226,7 @@ void Gameexe::parseLine(const std::string& line) {
       }
     }
     data_.emplace(key, vec);
+    DataChanged();
   }
 }
 
@@ -192,7 +254,7 @@ int Gameexe::GetIntAt(GameexeData_t::const_iterator key, int index) {
 // -----------------------------------------------------------------------
 
 bool Gameexe::Exists(const std::string& key) {
-  return data_.find(key) != data_.end();
+  return Find(key) != data_.end();
 }
 
 // -----------------------------------------------------------------------
@@ -210,6 +272,7 @@ void Gameexe::SetStringAt(const std::string& key, const std::string& value) {
   toStore.push_back(cdata_.size() - 1);
   data_.erase(key);
   data_.emplace(key, toStore);
+  DataChanged();
 }
 
 // -----------------------------------------------------------------------
@@ -219,24 +282,81 @@ void Gameexe::SetIntAt(const std::string& key, const int value) {
   toStore.push_back(value);
   data_.erase(key);
   data_.emplace(key, toStore);
+  DataChanged();
+}
+
+// -----------------------------------------------------------------------
+
+GameexeInterpretObject Gameexe::operator()(const GameexeKey& key) {
+  return GameexeInterpretObject(key.str(), Find(key.str(), key.hash()), *this);
 }
 
 // -----------------------------------------------------------------------
 
 GameexeData_t::const_iterator Gameexe::Find(const std::string& key) {
-  return data_.find(key);
+  return Find(key, std::hash<std::string>()(key));
+}
+
+// -----------------------------------------------------------------------
+
+GameexeData_t::const_iterator Gameexe::Find(const std::string& key,
+                                            size_t hash) {
+  if (!index_valid_)
+    BuildIndex();
+
+  auto range = index_.equal_range(hash);
+  for (auto it = range.first; it != range.second; ++it) {
+    if (it->second->first == key)
+      return it->second;
+  }
+
+  return data_.end();
+}
+
+// -----------------------------------------------------------------------
+
+void Gameexe::BuildIndex() {
+  index_.clear();
+  index_.reserve(data_.size());
+
+  // Only index the first of several entries with the same key, which is the
+  // one std::multimap::find() would have returned.
+  std::hash<std::string> hasher;
+  const std::string* previous_key = NULL;
+  for (GameexeData_t::const_iterator it = data_.begin(); it != data_.end();
+       ++it) {
+    if (previous_key && *previous_key == it->first)
+      continue;
+
+    index_.emplace(hasher(it->first), it);
+    previous_key = &it->first;
+  }
+
+  index_valid_ = true;
+}
+
+// -----------------------------------------------------------------------
+
+void Gameexe::DataChanged() {
+  index_valid_ = false;
+  generation_ = NextGeneration();
 }
 
 // -----------------------------------------------------------------------
 
-void Gameexe::AddToStream(const std::string& x, std::ostringstream& ss) {
-  ss << x;
+void Gameexe::AppendKeyPiece(const std::string& x, std::string* key) {
+  *key += x;
 }
 
 // -----------------------------------------------------------------------
 
-void Gameexe::AddToStream(const int& x, std::ostringstream& ss) {
-  ss << std::setw(3) << std::setfill('0') << x;
+void Gameexe::AppendKeyPiece(const int& x, std::string* key) {
+  // Matches what std::setw(3) and std::setfill('0') used to produce, padding
+  // in front of any minus sign.
+  std::string digits = std::to_string(x);
+  if (digits.size() < 3)
+    key->append(3 - digits.size(), '0');
+  *key += digits;
 }
 
 // -----------------------------------------------------------------------
@@ -301,6 +421,14 @@ const int GameexeInterpretObject::ToInt() const {
 
 // -----------------------------------------------------------------------
 
+const int GameexeInterpretObject::ToNonNegativeInt(
+    const int defaultValue) const {
+  int value = ToInt(defaultValue);
+  return value < 0 ? defaultValue : value;
+}
+
+// -----------------------------------------------------------------------
+
 int GameexeInterpretObject::GetIntAt(int index) const {
   return object_to_lookup_on_.GetIntAt(iterator_, index);
 }
@@ -350,7 +478,7 @@ const std::vector<int>& GameexeInterpretObject::ToIntVector() const {
 // -----------------------------------------------------------------------
 
 bool GameexeInterpretObject::Exists() const {
-  return object_to_lookup_on_.Exists(key_);
+  return iterator_ != object_to_lookup_on_.data_.end();
 }
 
 // -----------------------------------------------------------------------
@@ -367,6 +495,7 @@ GameexeInterpretObject& GameexeInterpretObject::operator=(
     const std::string& value) {
   // Set the key to incoming int
   object_to_lookup_on_.SetStringAt(key_, value);
+  iterator_ = object_to_lookup_on_.Find(key_);
   return *this;
 }
 
@@ -375,6 +504,7 @@ GameexeInterpretObject& GameexeInterpretObject::operator=(
 GameexeInterpretObject& GameexeInterpretObject::operator=(const int value) {
   // Set the key to incoming int
   object_to_lookup_on_.SetIntAt(key_, value);
+  iterator_ = object_to_lookup_on_.Find(key_);
   return *this;
 }
 
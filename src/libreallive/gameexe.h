@@ -38,9 +38,11 @@
 #include <boost/iterator/iterator_facade.hpp>
 #include <boost/filesystem/path.hpp>
 
+#include <functional>
 #include <map>
 #include <sstream>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 class Gameexe;
@@ -87,6 +89,10 @@ class GameexeInterpretObject {
   // Finds an int value, throwing if non-existant.
   const int ToInt() const;
 
+  // Finds a size or count, returning |defaultValue| if it's non-existant or
+  // negative.
+  const int ToNonNegativeInt(const int defaultValue) const;
+
   // Allow implicit casts to int with no default value
   operator int() const { return ToInt(); }
 
@@ -143,6 +149,49 @@ class GameexeInterpretObject {
                          Gameexe& objectToLookupOn);
 };
 
+// A Gameexe key that has been formatted and hashed once, up front. Code that
+// looks up the same key over and over should hold on to one of these (usually
+// as a static) instead of passing the pieces to Gameexe::operator() each
+// time, which formats a new string and searches the whole table.
+class GameexeKey {
+ public:
+  explicit GameexeKey(const std::string& key);
+
+  template<typename A, typename B>
+  GameexeKey(const A& firstKey, const B& secondKey);
+
+  template<typename A, typename B, typename C>
+  GameexeKey(const A& firstKey, const B& secondKey, const C& thirdKey);
+
+  const std::string& str() const { return key_; }
+  size_t hash() const { return hash_; }
+
+ private:
+  std::string key_;
+  size_t hash_;
+};
+
+// Resolves keys of the form PREFIX.nnn or PREFIX.nnn.SUFFIX, such as
+// "COLOR_TABLE.012" or "WINDOW.003.MOJI_SIZE", and remembers the result for
+// each number so that repeated lookups neither format nor search. The cache
+// is dropped whenever the Gameexe it was filled from is modified.
+class GameexeIndexedKey {
+ public:
+  explicit GameexeIndexedKey(const std::string& prefix);
+  GameexeIndexedKey(const std::string& prefix, const std::string& suffix);
+  ~GameexeIndexedKey();
+
+  const GameexeInterpretObject& operator()(Gameexe& gexe, int index);
+
+ private:
+  std::string prefix_;
+  std::string suffix_;
+
+  // Gameexe::generation() of the object |cache_| was filled from.
+  int generation_;
+  std::unordered_map<int, GameexeInterpretObject> cache_;
+};
+
 // New interface to Gameexe, replacing the one inherited from Haeleth,
 // which was hard to use and was very C-ish. This interface's goal is
 // to make accessing data in the Gameexe as easy as possible.
@@ -168,6 +217,9 @@ class Gameexe {
   GameexeInterpretObject operator()(const A& firstKey, const B& secondKey,
                                     const C& thirdKey);
 
+  // Access a preformatted key.
+  GameexeInterpretObject operator()(const GameexeKey& key);
+
   // Returns iterators that filter on a possible value.
   GameexeFilteringIterator filtering_begin(const std::string& filter);
   GameexeFilteringIterator filtering_end();
@@ -184,6 +236,10 @@ class Gameexe {
   void SetStringAt(const std::string& key, const std::string& value);
   void SetIntAt(const std::string& key, const int value);
 
+  // Changes every time the stored data does, and differs between Gameexe
+  // objects, so caches of lookups can tell when they're stale.
+  int generation() const { return generation_; }
+
  private:
   const std::vector<int>& GetIntArray(GameexeData_t::const_iterator key);
   int GetIntAt(GameexeData_t::const_iterator key, int index);
@@ -193,13 +249,20 @@ class Gameexe {
   // is a function only for tight coupling with
   // GameexeInterpretObject.
   GameexeData_t::const_iterator Find(const std::string& key);
+  GameexeData_t::const_iterator Find(const std::string& key, size_t hash);
+
+  // Rebuilds |index_| from |data_|.
+  void BuildIndex();
+
+  // Called after every change to |data_|.
+  void DataChanged();
 
-  // Regrettable artifact of hack to get all integers in streams to
+  // Regrettable artifact of hack to get all integers in keys to
   // have setw(3).
-  void AddToStream(const std::string& x, std::ostringstream& ss);
+  static void AppendKeyPiece(const std::string& x, std::string* key);
 
-  // Hack to get all integers in streams to have setw(3).
-  void AddToStream(const int& x, std::ostringstream& ss);
+  // Hack to get all integers in keys to have setw(3).
+  static void AppendKeyPiece(const int& x, std::string* key);
 
   void ThrowUnknownKey(const std::string& key);
 
@@ -207,6 +270,7 @@ class Gameexe {
   // Allow access from the helper class
   friend class GameexeInterpretObject;
   friend class GameexeFilteringIterator;
+  friend class GameexeKey;
 
   // Implementation detail of how parsed Gameexe.ini data is stored in
   // the class. This was stolen directly from Haeleth's parser in
@@ -215,15 +279,23 @@ class Gameexe {
   // that int is an index into a vector of strings on the side.
   GameexeData_t data_;
   std::vector<std::string> cdata_;
+
+  // Maps the hash of each key to the first entry in |data_| with that key,
+  // so lookups don't have to walk the tree comparing strings. Lazily rebuilt
+  // after |data_| changes.
+  std::unordered_multimap<size_t, GameexeData_t::const_iterator> index_;
+  bool index_valid_;
+
+  int generation_;
 };
 
 // -----------------------------------------------------------------------
 
 template<typename A>
 GameexeInterpretObject Gameexe::operator()(const A& firstKey) {
-  std::ostringstream ss;
-  AddToStream(firstKey, ss);
-  return GameexeInterpretObject(ss.str(), *this);
+  std::string key;
+  AppendKeyPiece(firstKey, &key);
+  return GameexeInterpretObject(key, *this);
 }
 
 // -----------------------------------------------------------------------
@@ -238,11 +310,11 @@ inline GameexeInterpretObject Gameexe::operator()(const std::string& firstKey) {
 template<typename A, typename B>
 GameexeInterpretObject Gameexe::operator()(const A& firstKey,
                                            const B& secondKey) {
-  std::ostringstream ss;
-  AddToStream(firstKey, ss);
-  ss << ".";
-  AddToStream(secondKey, ss);
-  return GameexeInterpretObject(ss.str(), *this);
+  std::string key;
+  AppendKeyPiece(firstKey, &key);
+  key += '.';
+  AppendKeyPiece(secondKey, &key);
+  return GameexeInterpretObject(key, *this);
 }
 
 // -----------------------------------------------------------------------
@@ -251,13 +323,36 @@ template<typename A, typename B, typename C>
 GameexeInterpretObject Gameexe::operator()(const A& firstKey,
                                            const B& secondKey,
                                            const C& thirdKey) {
-  std::ostringstream ss;
-  AddToStream(firstKey, ss);
-  ss << ".";
-  AddToStream(secondKey, ss);
-  ss << ".";
-  AddToStream(thirdKey, ss);
-  return GameexeInterpretObject(ss.str(), *this);
+  std::string key;
+  AppendKeyPiece(firstKey, &key);
+  key += '.';
+  AppendKeyPiece(secondKey, &key);
+  key += '.';
+  AppendKeyPiece(thirdKey, &key);
+  return GameexeInterpretObject(key, *this);
+}
+
+// -----------------------------------------------------------------------
+
+template<typename A, typename B>
+GameexeKey::GameexeKey(const A& firstKey, const B& secondKey) {
+  Gameexe::AppendKeyPiece(firstKey, &key_);
+  key_ += '.';
+  Gameexe::AppendKeyPiece(secondKey, &key_);
+  hash_ = std::hash<std::string>()(key_);
+}
+
+// -----------------------------------------------------------------------
+
+template<typename A, typename B, typename C>
+GameexeKey::GameexeKey(const A& firstKey, const B& secondKey,
+                       const C& thirdKey) {
+  Gameexe::AppendKeyPiece(firstKey, &key_);
+  key_ += '.';
+  Gameexe::AppendKeyPiece(secondKey, &key_);
+  key_ += '.';
+  Gameexe::AppendKeyPiece(thirdKey, &key_);
+  hash_ = std::hash<std::string>()(key_);
 }
 
 // -----------------------------------------------------------------------
@@ -35,8 +35,11 @@
 
 #include <algorithm>
 #include <cassert>
+#include <functional>
 #include <sstream>
 #include <string>
+#include <utility>
+#include <vector>
 
 #include "libreallive/compression.h"
 #include "utilities/exception.h"
@@ -113,86 +116,235 @@ Script::Script(const Header& hdr,
                const size_t length,
                const std::string& regname,
                bool use_xor_2,
-               const compression::XorKey* second_level_xor_key) {
+               const compression::XorKey* second_level_xor_key,
+               const char* bytecode)
+    : cdat_(0, &arena_),
+      parsed_regions_(0),
+      bytecode_(bytecode),
+      uncompressed_length_(read_i32(data + 0x24)) {
   // Kidoku/entrypoint table
   const int kidoku_offs = read_i32(data + 0x08);
   const size_t kidoku_length = read_i32(data + 0x0c);
-  ConstructionData cdat(kidoku_length, elts_.end());
+  cdat_.kidoku_table.resize(kidoku_length);
   for (size_t i = 0; i < kidoku_length; ++i)
-    cdat.kidoku_table[i] = read_i32(data + kidoku_offs + i * 4);
+    cdat_.kidoku_table[i] = read_i32(data + kidoku_offs + i * 4);
+  cdat_.script = this;
 
   // Decompress data
-  const size_t dlen = read_i32(data + 0x24);
-
-  const compression::XorKey* key = NULL;
-  if (use_xor_2) {
-    if (second_level_xor_key) {
-      key = second_level_xor_key;
-    } else {
-      // Probably safe to assume that any game we don't know about has a
-      // Japanese encoding.
-      throw rlvm::UserPresentableError(
-          str(format(_("Can not read game script for %1%")) %
-              cp932toUTF8(regname, 0)),
-          _("Some games require individual reverse engineering. This game can "
-            "not be played until someone has figured out how the game script "
-            "is encoded."));
+  const size_t dlen = uncompressed_length_;
+  if (!bytecode_) {
+    const compression::XorKey* key = NULL;
+    if (use_xor_2) {
+      if (second_level_xor_key) {
+        key = second_level_xor_key;
+      } else {
+        // Probably safe to assume that any game we don't know about has a
+        // Japanese encoding.
+        throw rlvm::UserPresentableError(
+            str(format(_("Can not read game script for %1%")) %
+                cp932toUTF8(regname, 0)),
+            _("Some games require individual reverse engineering. This game "
+              "can not be played until someone has figured out how the game "
+              "script is encoded."));
+      }
     }
-  }
 
-  char* uncompressed = new char[dlen];
-  compression::Decompress(data + read_i32(data + 0x20),
-                          read_i32(data + 0x28),
-                          uncompressed,
-                          dlen,
-                          key);
-  // Read bytecode
-  const char* stream = uncompressed;
-  const char* end = uncompressed + dlen;
-  size_t pos = 0;
-  pointer_t it = elts_.before_begin();
-  while (pos < dlen) {
-    // Read element
-    it = elts_.emplace_after(it, BytecodeElement::Read(stream, end, cdat));
-    cdat.offsets[pos] = it;
-
-    // Keep track of the entrypoints
-    int entrypoint = (*it)->GetEntrypoint();
-    if (entrypoint != BytecodeElement::kInvalidEntrypoint)
-      entrypoint_associations_.emplace(entrypoint, it);
-
-    // Advance
-    size_t l = (*it)->GetBytecodeLength();
-    if (l <= 0)
-      l = 1;  // Failsafe: always advance at least one byte.
-    stream += l;
-    pos += l;
+    uncompressed_.reset(new char[dlen]);
+    compression::Decompress(data + read_i32(data + 0x20),
+                            read_i32(data + 0x28),
+                            uncompressed_.get(),
+                            dlen,
+                            key);
+    bytecode_ = uncompressed_.get();
   }
 
-  // Resolve pointers
-  for (auto& element : elts_) {
-    element->SetPointers(cdat);
+  // The header lists the offset of each of the 100 entrypoints. Unused
+  // entries are zero. Only trust offsets that land on an entrypoint marker;
+  // GetEntrypoint() falls back to parsing everything for the rest.
+  std::vector<unsigned long> starts(1, 0);
+  for (int i = 0; i < 100; ++i) {
+    const unsigned long offset = read_i32(data + 0x34 + i * 4);
+    if ((offset == 0 && i != 0) || offset >= dlen)
+      continue;
+    if (bytecode_[offset] != '!' && bytecode_[offset] != '@')
+      continue;
+
+    entrypoint_offsets_.emplace(i, offset);
+    starts.push_back(offset);
   }
+  std::sort(starts.begin(), starts.end());
+  starts.erase(std::unique(starts.begin(), starts.end()), starts.end());
 
-  delete[] uncompressed;
+  if (dlen == 0)
+    return;
+  regions_.reserve(starts.size());
+  for (size_t i = 0; i < starts.size(); ++i) {
+    regions_.emplace_back(starts[i],
+                          i + 1 < starts.size() ? starts[i + 1] : dlen);
+  }
 }
 
 Script::~Script() {}
 
 const pointer_t Script::GetEntrypoint(int entrypoint) const {
+  std::lock_guard<std::recursive_mutex> lock(mutex_);
   pointernumber::const_iterator it = entrypoint_associations_.find(entrypoint);
-  if (it == entrypoint_associations_.end())
-    throw Error("Unknown entrypoint");
+  if (it == entrypoint_associations_.end()) {
+    // Parse the region the header says the entrypoint starts, and if that
+    // doesn't turn it up, the whole script.
+    std::map<int, unsigned long>::const_iterator offset =
+        entrypoint_offsets_.find(entrypoint);
+    if (offset != entrypoint_offsets_.end())
+      Materialize(RegionFor(offset->second));
+
+    for (size_t i = 0; i < regions_.size() &&
+                       !entrypoint_associations_.count(entrypoint); ++i) {
+      Materialize(i);
+    }
+
+    it = entrypoint_associations_.find(entrypoint);
+    if (it == entrypoint_associations_.end())
+      throw Error("Unknown entrypoint");
+  }
 
   return it->second;
 }
 
+pointer_t Script::FindElement(unsigned long offset) const {
+  assert(!regions_.empty());
+  const size_t region = RegionFor(offset);
+  const BytecodeList& elements = Materialize(region);
+  const std::vector<unsigned long>& offsets = regions_[region].offsets;
+  std::vector<unsigned long>::const_iterator it =
+      std::lower_bound(offsets.begin(), offsets.end(), offset);
+  assert(it != offsets.end() && *it == offset);
+  return pointer_t(this, &elements, region, it - offsets.begin());
+}
+
+pointer_t Script::begin() const {
+  if (regions_.empty())
+    return end();
+  return pointer_t(this, &Materialize(0), 0, 0);
+}
+
+pointer_t Script::end() const {
+  return pointer_t(this, NULL, regions_.size(), 0);
+}
+
+size_t Script::parsed_region_count() const {
+  std::lock_guard<std::recursive_mutex> lock(mutex_);
+  return parsed_regions_;
+}
+
+void Script::ForEachParsedElement(
+    size_t region,
+    const std::function<void(const BytecodeElement*)>& func) const {
+  std::lock_guard<std::recursive_mutex> lock(mutex_);
+  if (region >= regions_.size() || !regions_[region].parsed)
+    return;
+
+  for (const BytecodeElement* element : regions_[region].elements)
+    func(element);
+}
+
+void Script::set_region_parsed_callback(
+    const RegionParsedCallback& callback) {
+  std::lock_guard<std::recursive_mutex> lock(mutex_);
+  region_parsed_ = callback;
+}
+
+const BytecodeList& Script::Materialize(size_t region) const {
+  std::lock_guard<std::recursive_mutex> lock(mutex_);
+  Region& r = regions_[region];
+  if (r.parsed)
+    return r.elements;
+
+  // Read bytecode
+  const char* stream = bytecode_ + r.start;
+  const char* end = bytecode_ + uncompressed_length_;
+  unsigned long pos = r.start;
+  try {
+    while (pos < r.end) {
+      // Read element
+      BytecodeElement* element = BytecodeElement::Read(stream, end, cdat_);
+      r.elements.push_back(element);
+      r.offsets.push_back(pos);
+
+      // Keep track of the entrypoints
+      int entrypoint = element->GetEntrypoint();
+      if (entrypoint != BytecodeElement::kInvalidEntrypoint) {
+        entrypoint_associations_.emplace(
+            entrypoint,
+            pointer_t(this, &r.elements, region, r.elements.size() - 1));
+      }
+
+      // Advance
+      size_t l = element->GetBytecodeLength();
+      if (l <= 0)
+        l = 1;  // Failsafe: always advance at least one byte.
+      stream += l;
+      pos += l;
+    }
+
+    if (pos != r.end)
+      throw Error("Bytecode element runs past an entrypoint");
+  }
+  catch (...) {
+    for (pointernumber::iterator it = entrypoint_associations_.begin();
+         it != entrypoint_associations_.end();) {
+      if (it->second.region_ == region)
+        it = entrypoint_associations_.erase(it);
+      else
+        ++it;
+    }
+    r.elements.clear();
+    r.offsets.clear();
+    throw;
+  }
+
+  r.elements.shrink_to_fit();
+  r.offsets.shrink_to_fit();
+  r.parsed = true;
+  if (++parsed_regions_ == regions_.size()) {
+    bytecode_ = NULL;
+    uncompressed_.reset();
+  }
+
+  // Resolve pointers. This may parse the regions they point into.
+  for (BytecodeElement* element : r.elements)
+    element->SetPointers(cdat_);
+
+  if (region_parsed_)
+    region_parsed_(region);
+
+  return r.elements;
+}
+
+size_t Script::RegionFor(unsigned long offset) const {
+  std::vector<Region>::const_iterator it = std::upper_bound(
+      regions_.begin(), regions_.end(), offset,
+      [](unsigned long offset, const Region& region) {
+        return offset < region.start;
+      });
+  assert(it != regions_.begin());
+  return (it - regions_.begin()) - 1;
+}
+
+void ScriptIterator::NextRegion() {
+  // Only move once the next region has parsed, so that a parse error leaves
+  // the iterator where it was.
+  const size_t next = region_ + 1;
+  list_ = next < script_->regions_.size() ? &script_->Materialize(next) : NULL;
+  region_ = next;
+  index_ = 0;
+}
+
 Scenario::Scenario(const char* data, const size_t length, int sn,
                    const std::string& regname,
                    const compression::XorKey* second_level_xor_key)
   : header(data, length),
     script(header, data, length, regname,
-           header.use_xor_2_, second_level_xor_key),
+           header.use_xor_2_, second_level_xor_key, NULL),
     scenario_number_(sn) {
 }
 
@@ -201,14 +353,71 @@ Scenario::Scenario(const FilePos& fp, int sn,
                    const compression::XorKey* second_level_xor_key)
   : header(fp.data, fp.length),
     script(header, fp.data, fp.length, regname,
-           header.use_xor_2_, second_level_xor_key),
+           header.use_xor_2_, second_level_xor_key, NULL),
+    scenario_number_(sn) {
+}
+
+Scenario::Scenario(const FilePos& fp, const char* bytecode, int sn)
+  : header(fp.data, fp.length),
+    script(header, fp.data, fp.length, "", header.use_xor_2_, NULL, bytecode),
     scenario_number_(sn) {
 }
 
+const char* Scenario::decompressed_bytecode() const {
+  std::lock_guard<std::recursive_mutex> lock(script.mutex_);
+  return script.bytecode_;
+}
+
 Scenario::~Scenario() {}
 
 Scenario::const_iterator Scenario::FindEntrypoint(int entrypoint) const {
   return script.GetEntrypoint(entrypoint);
 }
 
+std::vector<int> Scenario::GetReachableScenarios() const {
+  std::vector<int> scenarios;
+  for (size_t i = 0; i < script.region_count(); ++i)
+    FindReachableScenarios(i, &scenarios);
+  return scenarios;
+}
+
+std::vector<int> Scenario::GetReachableScenarios(size_t region) const {
+  std::vector<int> scenarios;
+  FindReachableScenarios(region, &scenarios);
+  return scenarios;
+}
+
+void Scenario::FindReachableScenarios(size_t region,
+                                      std::vector<int>* scenarios) const {
+  script.ForEachParsedElement(region, [&](const BytecodeElement* element) {
+    const CommandElement* command =
+        dynamic_cast<const CommandElement*>(element);
+    if (!command || command->modtype() != 0)
+      return;
+
+    // jump, farcall and farcall_with in the Jmp module and its aliases.
+    const int module = command->module();
+    const int opcode = command->opcode();
+    if ((module != 1 && module != 5 && module != 6) ||
+        (opcode != 11 && opcode != 12 && opcode != 18) ||
+        command->GetParamCount() == 0)
+      return;
+
+    try {
+      std::string param = command->GetParam(0);
+      const char* src = param.c_str();
+      ExpressionPiece target(GetExpression(src));
+      if (target.IsIntConstant() &&
+          target.GetIntConstant() != scenario_number_ &&
+          std::find(scenarios->begin(), scenarios->end(),
+                    target.GetIntConstant()) == scenarios->end()) {
+        scenarios->push_back(target.GetIntConstant());
+      }
+    }
+    catch (Error& e) {
+      // Unparsable parameters are reported when the command is executed.
+    }
+  });
+}
+
 }  // namespace libreallive
@@ -34,10 +34,15 @@
 #ifndef SRC_LIBREALLIVE_SCENARIO_H_
 #define SRC_LIBREALLIVE_SCENARIO_H_
 
+#include <functional>
+#include <memory>
+#include <mutex>
 #include <string>
+#include <vector>
 
 #include "libreallive/defs.h"
 #include "libreallive/bytecode.h"
+#include "libreallive/bytecode_arena.h"
 
 namespace libreallive {
 
@@ -55,6 +60,10 @@ class Scenario {
   Scenario(const FilePos& fp, int scenarioNum,
            const std::string& regname,
            const compression::XorKey* second_level_xor_key);
+  // Builds a scenario from the header in |fp| and bytecode that was already
+  // decompressed elsewhere (see Archive::EnableDiskCache()). |bytecode| must
+  // outlive the Scenario.
+  Scenario(const FilePos& fp, const char* bytecode, int scenarioNum);
   ~Scenario();
 
   // Get the scenario number
@@ -69,17 +78,46 @@ class Scenario {
   int savepoint_selcom()  const { return header.savepoint_selcom_;  }
   int savepoint_seentop() const { return header.savepoint_seentop_; }
 
-  // Access to script
-  typedef BytecodeList::const_iterator const_iterator;
-  typedef BytecodeList::iterator iterator;
+  // Access to script. Iterating parses the script as it goes.
+  typedef pointer_t const_iterator;
+  typedef pointer_t iterator;
 
-  const_iterator begin() const  { return script.elts_.cbegin(); }
-  const_iterator end() const    { return script.elts_.cend();   }
+  const_iterator begin() const  { return script.begin(); }
+  const_iterator end() const    { return script.end();   }
+
+  // The decompressed bytecode, which is bytecode_length() bytes long, or
+  // NULL once the whole script has been parsed and it has been released.
+  const char* decompressed_bytecode() const;
+  size_t bytecode_length() const { return script.uncompressed_length_; }
+
+  // Number of regions the script is split into, and how many of them have
+  // been parsed so far.
+  size_t region_count() const { return script.region_count(); }
+  size_t parsed_region_count() const { return script.parsed_region_count(); }
 
   // Locate the entrypoint
   const_iterator FindEntrypoint(int entrypoint) const;
 
+  // Returns the numbers of the other scenarios this scenario can jump or
+  // farcall into from the regions parsed so far; nothing is parsed to find
+  // them. Only targets given as integer constants are found; targets
+  // computed at runtime are skipped.
+  std::vector<int> GetReachableScenarios() const;
+
+  // The same, for |region| alone.
+  std::vector<int> GetReachableScenarios(size_t region) const;
+
+  // See Script::set_region_parsed_callback().
+  void set_region_parsed_callback(
+      const Script::RegionParsedCallback& callback) {
+    script.set_region_parsed_callback(callback);
+  }
+
  private:
+  // Adds the targets in |region| to |scenarios|.
+  void FindReachableScenarios(size_t region,
+                              std::vector<int>* scenarios) const;
+
   Header header;
   Script script;
   int scenario_number_;
@@ -29,6 +29,7 @@
 #ifndef SRC_LIBREALLIVE_SCENARIO_INTERNALS_H_
 #define SRC_LIBREALLIVE_SCENARIO_INTERNALS_H_
 
+#include <functional>
 #include <map>
 #include <string>
 #include <vector>
@@ -74,23 +75,96 @@ class Header {
   Metadata rldev_metadata_;
 };
 
+// The bytecode of a scenario. Rather than parsing everything up front, the
+// bytecode is split at the entrypoints listed in the file header and each
+// region is parsed the first time something iterates into it, jumps into it
+// or looks up one of its entrypoints. A farcall into one entrypoint of a big
+// utility SEEN only parses that entrypoint's part of the file.
 class Script {
  public:
   const pointer_t GetEntrypoint(int entrypoint) const;
 
+  // Returns the element starting at byte |offset| of the uncompressed
+  // bytecode, parsing its region if needed.
+  pointer_t FindElement(unsigned long offset) const;
+
+  pointer_t begin() const;
+  pointer_t end() const;
+
+  size_t region_count() const { return regions_.size(); }
+  size_t parsed_region_count() const;
+
+  // Calls |func| on each element of |region| if that region has already been
+  // parsed. Never parses anything itself.
+  void ForEachParsedElement(
+      size_t region,
+      const std::function<void(const BytecodeElement*)>& func) const;
+
+  // Called with the index of each region right after it has been parsed, on
+  // whichever thread parsed it and with the script still locked.
+  typedef std::function<void(size_t region)> RegionParsedCallback;
+  void set_region_parsed_callback(const RegionParsedCallback& callback);
+
  private:
   friend class Scenario;
+  friend class ScriptIterator;
+
+  struct Region {
+    Region(unsigned long s, unsigned long e)
+        : start(s), end(e), parsed(false) {}
+
+    // Byte range of the uncompressed bytecode.
+    unsigned long start;
+    unsigned long end;
+
+    // Set once |elements| holds the whole region.
+    bool parsed;
+
+    BytecodeList elements;
 
+    // Byte offset of each element in |elements|.
+    std::vector<unsigned long> offsets;
+  };
+
+  // Decompresses the bytecode in |data| unless |bytecode| already holds it,
+  // in which case it must outlive the Script.
   Script(const Header& hdr, const char* data, const size_t length,
          const std::string& regname,
-         bool use_xor_2, const compression::XorKey* second_level_xor_key);
+         bool use_xor_2, const compression::XorKey* second_level_xor_key,
+         const char* bytecode);
   ~Script();
 
-  BytecodeList elts_;
+  // Returns the elements of |region|, parsing them first if needed.
+  const BytecodeList& Materialize(size_t region) const;
+
+  // Returns the index of the region holding byte |offset|.
+  size_t RegionFor(unsigned long offset) const;
+
+  // Guards all parsing. Recursive since resolving the pointers of one region
+  // can parse another.
+  mutable std::recursive_mutex mutex_;
+
+  // Owns every element parsed so far.
+  mutable BytecodeArena arena_;
+  mutable ConstructionData cdat_;
 
-  // Entrypoint handeling
+  mutable std::vector<Region> regions_;
+  mutable size_t parsed_regions_;
+
+  // Decompressed bytecode, released once every region has been parsed.
+  // Points into |uncompressed_| unless the caller supplied the bytecode.
+  mutable const char* bytecode_;
+  mutable std::unique_ptr<char[]> uncompressed_;
+  size_t uncompressed_length_;
+
+  // Byte offsets of the entrypoints from the file header.
+  std::map<int, unsigned long> entrypoint_offsets_;
+
+  // Entrypoint handeling; filled in as regions are parsed.
   typedef std::map<int, pointer_t> pointernumber;
-  pointernumber entrypoint_associations_;
+  mutable pointernumber entrypoint_associations_;
+
+  RegionParsedCallback region_parsed_;
 };
 
 #endif  // SRC_LIBREALLIVE_SCENARIO_INTERNALS_H_
@@ -0,0 +1,105 @@
+// -*- Mode: C++; tab-width:2; indent-tabs-mode: nil; c-basic-offset: 2 -*-
+// vi:tw=80:et:ts=2:sts=2
+//
+// -----------------------------------------------------------------------
+//
+// This file is part of libreallive, a dependency of RLVM.
+//
+// -----------------------------------------------------------------------
+//
+// Copyright (c) 2015 Elliot Glaysher
+//
+// Permission is hereby granted, free of charge, to any person
+// obtaining a copy of this software and associated documentation
+// files (the "Software"), to deal in the Software without
+// restriction, including without limitation the rights to use, copy,
+// modify, merge, publish, distribute, sublicense, and/or sell copies
+// of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be
+// included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+// BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+// ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+
+#ifndef SRC_LIBREALLIVE_SCRIPT_ITERATOR_H_
+#define SRC_LIBREALLIVE_SCRIPT_ITERATOR_H_
+
+#include <cstddef>
+#include <iterator>
+#include <vector>
+
+namespace libreallive {
+
+class BytecodeElement;
+class Script;
+
+// Elements of one region of a Script, in program order. The elements
+// themselves live in the Script's BytecodeArena.
+typedef std::vector<BytecodeElement*> BytecodeList;
+
+// Walks the elements of a Script in program order. A Script is parsed one
+// region at a time, so the iterator is a (region, index) pair; stepping off
+// the end of a region parses the next one if nobody has needed it yet.
+class ScriptIterator {
+ public:
+  typedef std::forward_iterator_tag iterator_category;
+  typedef BytecodeElement* value_type;
+  typedef std::ptrdiff_t difference_type;
+  typedef BytecodeElement* const* pointer;
+  typedef BytecodeElement* reference;
+
+  ScriptIterator() : script_(NULL), list_(NULL), region_(0), index_(0) {}
+
+  BytecodeElement* operator*() const { return (*list_)[index_]; }
+
+  ScriptIterator& operator++() {
+    if (index_ + 1 < list_->size())
+      ++index_;
+    else
+      NextRegion();
+    return *this;
+  }
+
+  ScriptIterator operator++(int) {
+    ScriptIterator old = *this;
+    ++*this;
+    return old;
+  }
+
+  bool operator==(const ScriptIterator& rhs) const {
+    return region_ == rhs.region_ && index_ == rhs.index_;
+  }
+  bool operator!=(const ScriptIterator& rhs) const { return !(*this == rhs); }
+
+ private:
+  friend class Script;
+
+  ScriptIterator(const Script* script, const BytecodeList* list,
+                 size_t region, size_t index)
+      : script_(script), list_(list), region_(region), index_(index) {}
+
+  // Moves to the first element of the next region, or to the end. Parsing
+  // errors propagate and leave the iterator unchanged.
+  void NextRegion();
+
+  const Script* script_;
+
+  // Elements of |region_|; NULL at the end of the script.
+  const BytecodeList* list_;
+  size_t region_;
+  size_t index_;
+};
+
+}  // namespace libreallive
+
+#endif  // SRC_LIBREALLIVE_SCRIPT_ITERATOR_H_
@@ -125,7 +125,8 @@ bool WaitLongOperation::operator()(RLMachine& machine) {
     graphics.MarkScreenAsDirty(GUT_MOUSE_MOTION);
     mouse_moved_ = false;
   } else if (graphics.object_state_dirty()) {
-    graphics.MarkScreenAsDirty(GUT_DISPLAY_OBJ);
+    // The refresh works out which objects changed.
+    graphics.MarkScreenAreaAsDirty(GUT_DISPLAY_OBJ, Rect());
   }
 
   if (break_on_clicks_) {
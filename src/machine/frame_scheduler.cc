@@ -0,0 +1,104 @@
+// -*- Mode: C++; tab-width:2; indent-tabs-mode: nil; c-basic-offset: 2 -*-
+// vi:tw=80:et:ts=2:sts=2
+//
+// -----------------------------------------------------------------------
+//
+// This file is part of RLVM, a RealLive virtual machine clone.
+//
+// -----------------------------------------------------------------------
+//
+// Copyright (C) 2015 Elliot Glaysher
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA.
+// -----------------------------------------------------------------------
+
+
+#include "machine/frame_scheduler.h"
+
+#include "machine/rlmachine.h"
+#include "systems/base/event_system.h"
+#include "systems/base/system.h"
+
+namespace {
+
+// Whether tick count |a| is at or after |b|, allowing for wraparound.
+bool TicksReached(unsigned int a, unsigned int b) {
+  return static_cast<int>(a - b) >= 0;
+}
+
+}  // namespace
+
+FrameScheduler::FrameScheduler(System& system, RLMachine& machine)
+    : system_(system),
+      machine_(machine),
+      frame_interval_(kDefaultFrameInterval),
+      deadline_(0),
+      started_(false),
+      frame_count_(0),
+      late_frame_count_(0),
+      instruction_count_(0) {}
+
+FrameScheduler::~FrameScheduler() {}
+
+void FrameScheduler::Run() {
+  while (!machine_.halted())
+    RunFrame();
+}
+
+void FrameScheduler::RunFrame() {
+  EventSystem& event = system_.event();
+  if (!started_) {
+    deadline_ = event.GetTicks();
+    started_ = true;
+  }
+
+  // Give the system a chance to respond to events, redraw the screen, etc.
+  system_.Run(machine_);
+  frame_count_++;
+
+  deadline_ += frame_interval_;
+  unsigned int now = event.GetTicks();
+  if (TicksReached(now, deadline_)) {
+    // The last frame overran this one entirely. Start the timeline again
+    // from here instead of trying to catch up.
+    late_frame_count_++;
+    deadline_ = now + frame_interval_;
+  }
+
+  // Run the machine until the frame is over. Bail out early if we switch to
+  // long operation mode, or if the screen is marked as dirty; those need the
+  // system to run before anything else happens.
+  int until_clock_check = kInstructionsPerClockCheck;
+  do {
+    machine_.ExecuteNextInstruction();
+    instruction_count_++;
+
+    if (--until_clock_check == 0) {
+      now = event.GetTicks();
+      until_clock_check = kInstructionsPerClockCheck;
+    }
+  } while (!machine_.halted() && !machine_.CurrentLongOperation() &&
+           !system_.force_wait() && !TicksReached(now, deadline_));
+
+  // Sleep off what's left of the frame to be nice to the processor and to
+  // give the GPU a chance to catch up.
+  if (!system_.ShouldFastForward()) {
+    now = event.GetTicks();
+    if (!TicksReached(now, deadline_))
+      event.Wait(deadline_ - now);
+  }
+
+  system_.set_force_wait(false);
+}
@@ -0,0 +1,84 @@
+// -*- Mode: C++; tab-width:2; indent-tabs-mode: nil; c-basic-offset: 2 -*-
+// vi:tw=80:et:ts=2:sts=2
+//
+// -----------------------------------------------------------------------
+//
+// This file is part of RLVM, a RealLive virtual machine clone.
+//
+// -----------------------------------------------------------------------
+//
+// Copyright (C) 2015 Elliot Glaysher
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA.
+// -----------------------------------------------------------------------
+
+
+#ifndef SRC_MACHINE_FRAME_SCHEDULER_H_
+#define SRC_MACHINE_FRAME_SCHEDULER_H_
+
+class RLMachine;
+class System;
+
+// Drives the main loop: lets the System handle events and redraw once per
+// frame, and spends the rest of the frame interpreting bytecode.
+//
+// Frames fall on a fixed timeline instead of being spaced by a sleep after
+// each burst of instructions. The interpreter runs until the next frame's
+// deadline and we only sleep for whatever time is left, so a script that
+// has work to do is never throttled by rendering. When a burst overruns,
+// the timeline is moved forward instead of running a string of catch-up
+// frames back to back.
+class FrameScheduler {
+ public:
+  // Default spacing of frames, in milliseconds.
+  static const unsigned int kDefaultFrameInterval = 10;
+
+  // Reading the clock is a virtual call into the event system, so we only do
+  // it every this many instructions.
+  static const int kInstructionsPerClockCheck = 16;
+
+  FrameScheduler(System& system, RLMachine& machine);
+  ~FrameScheduler();
+
+  // Runs frames until the machine halts.
+  void Run();
+
+  // Runs a single frame.
+  void RunFrame();
+
+  unsigned int frame_interval() const { return frame_interval_; }
+  void set_frame_interval(unsigned int ms) { frame_interval_ = ms; }
+
+  // Statistics since construction.
+  int frame_count() const { return frame_count_; }
+  int late_frame_count() const { return late_frame_count_; }
+  int instruction_count() const { return instruction_count_; }
+
+ private:
+  System& system_;
+  RLMachine& machine_;
+
+  unsigned int frame_interval_;
+
+  // When the current frame ends, in GetTicks() time.
+  unsigned int deadline_;
+  bool started_;
+
+  int frame_count_;
+  int late_frame_count_;
+  int instruction_count_;
+};
+
+#endif  // SRC_MACHINE_FRAME_SCHEDULER_H_
@@ -212,6 +212,11 @@ class Memory {
   // Sets the value of a certain memory location
   void SetIntValue(const libreallive::IntMemRef& ref, int value);
 
+  // Returns the raw storage for one of the banks intA[] through intZ[], for
+  // libreallive::CompiledExpression, which has already bounds checked its
+  // reads. |bank| is one of the INT*_LOCATION constants other than intL[].
+  int* GetIntBank(int bank) { return int_var[bank]; }
+
   // Returns the string value of a string memory bank
   const std::string& GetStringValue(int type, int location);
 
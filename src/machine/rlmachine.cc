@@ -35,6 +35,7 @@
 #include <boost/filesystem/fstream.hpp>
 #include <boost/filesystem/path.hpp>
 
+#include <atomic>
 #include <functional>
 #include <string>
 #include <sstream>
@@ -59,6 +60,7 @@
 #include "machine/serialization.h"
 #include "machine/stack_frame.h"
 #include "systems/base/graphics_system.h"
+#include "systems/base/sound_system.h"
 #include "systems/base/system.h"
 #include "systems/base/system_error.h"
 #include "systems/base/text_page.h"
@@ -94,6 +96,38 @@ bool IsNotLongOp(StackFrame& frame) {
   return frame.frame_type != StackFrame::TYPE_LONGOP;
 }
 
+// Source of RLMachine::dispatch_id_ values. Zero is never handed out, since
+// that's what an unresolved CommandElement holds.
+int NextDispatchId() {
+  static std::atomic<int> next_dispatch_id(1);
+  return next_dispatch_id++;
+}
+
+// How far past a textout PrefetchUpcomingVoices() looks, in bytecode elements
+// and in voices found. Voiced games put a koePlay in front of each line, so
+// this covers the next line or two.
+const int kVoiceLookaheadElements = 64;
+const int kVoiceLookaheadVoices = 2;
+
+// Whether |command| is one of the Koe module's opcodes that plays the voice
+// given as its first parameter.
+bool IsKoePlayCommand(const libreallive::CommandElement& command) {
+  if (command.modtype() != 1 || command.module() != 23)
+    return false;
+
+  switch (command.opcode()) {
+    case 0:   // koePlay
+    case 1:   // koePlayEx
+    case 7:   // koePlayExC
+    case 8:   // koeDoPlay
+    case 9:   // koeDoPlayEx
+    case 10:  // koeDoPlayExC
+      return command.GetParamCount() > 0;
+    default:
+      return false;
+  }
+}
+
 }  // namespace
 
 // -----------------------------------------------------------------------
@@ -102,6 +136,7 @@ bool IsNotLongOp(StackFrame& frame) {
 
 RLMachine::RLMachine(System& in_system, libreallive::Archive& in_archive)
     : memory_(new Memory(*this, in_system.gameexe())),
+      dispatch_id_(NextDispatchId()),
       archive_(in_archive),
       system_(in_system) {
   // Search in the Gameexe for #SEEN_START and place us there
@@ -169,6 +204,7 @@ void RLMachine::AttachModule(RLModule* module) {
   }
 
   modules_.emplace(packed_module, std::unique_ptr<RLModule>(module));
+  dispatch_id_ = NextDispatchId();
 }
 
 int RLMachine::GetIntValue(const libreallive::IntMemRef& ref) {
@@ -199,7 +235,7 @@ void RLMachine::MarkSavepoint() {
 }
 
 bool RLMachine::SavepointDecide(AttributeFunction func,
-                                const std::string& gameexe_key) const {
+                                const GameexeKey& gameexe_key) const {
   if (!mark_savepoints_)
     return false;
 
@@ -211,9 +247,9 @@ bool RLMachine::SavepointDecide(AttributeFunction func,
 
   //
   // check Gameexe key
-  Gameexe& gexe = system_.gameexe();
-  if (gexe.Exists(gameexe_key)) {
-    int value = gexe(gameexe_key);
+  GameexeInterpretObject key_obj = system_.gameexe()(gameexe_key);
+  if (key_obj.Exists()) {
+    int value = key_obj;
     if (value == 0)
       return false;
     else if (value == 1)
@@ -227,18 +263,18 @@ bool RLMachine::SavepointDecide(AttributeFunction func,
 void RLMachine::SetMarkSavepoints(const int in) { mark_savepoints_ = in; }
 
 bool RLMachine::ShouldSetMessageSavepoint() const {
-  return SavepointDecide(&libreallive::Scenario::savepoint_message,
-                         "SAVEPOINT_MESSAGE");
+  static const GameexeKey key("SAVEPOINT_MESSAGE");
+  return SavepointDecide(&libreallive::Scenario::savepoint_message, key);
 }
 
 bool RLMachine::ShouldSetSelcomSavepoint() const {
-  return SavepointDecide(&libreallive::Scenario::savepoint_selcom,
-                         "SAVEPOINT_SELCOM");
+  static const GameexeKey key("SAVEPOINT_SELCOM");
+  return SavepointDecide(&libreallive::Scenario::savepoint_selcom, key);
 }
 
 bool RLMachine::ShouldSetSeentopSavepoint() const {
-  return SavepointDecide(&libreallive::Scenario::savepoint_seentop,
-                         "SAVEPOINT_SEENTOP");
+  static const GameexeKey key("SAVEPOINT_SEENTOP");
+  return SavepointDecide(&libreallive::Scenario::savepoint_seentop, key);
 }
 
 void RLMachine::ExecuteNextInstruction() {
@@ -339,13 +375,20 @@ std::string RLMachine::GetCommandName(const libreallive::CommandElement& f) {
 }
 
 void RLMachine::ExecuteCommand(const libreallive::CommandElement& f) {
-  ModuleMap::iterator it =
-      modules_.find(PackModuleNumber(f.modtype(), f.module()));
-  if (it != modules_.end()) {
-    it->second->DispatchFunction(*this, f);
-  } else {
-    throw rlvm::UnimplementedOpcode(*this, f);
+  // Only the first execution of a command pays for the module and opcode
+  // lookups; afterwards the resolved operation is cached on |f|.
+  RLOperation* op = f.GetCachedOperation(dispatch_id_);
+  if (!op) {
+    ModuleMap::iterator it =
+        modules_.find(PackModuleNumber(f.modtype(), f.module()));
+    if (it != modules_.end())
+      op = it->second->FindOperation(f);
+    if (!op)
+      throw rlvm::UnimplementedOpcode(*this, f);
+    f.SetCachedOperation(dispatch_id_, op);
   }
+
+  RLModule::DispatchOperation(*this, f, op);
 }
 
 void RLMachine::Jump(int scenario_num, int entrypoint) {
@@ -404,12 +447,12 @@ void RLMachine::ReturnFromFarcall() {
   PopStackFrame();
 }
 
-void RLMachine::GotoLocation(libreallive::BytecodeList::iterator new_location) {
+void RLMachine::GotoLocation(libreallive::pointer_t new_location) {
   // Modify the current frame of the call stack so that it's
   call_stack_.back().ip = new_location;
 }
 
-void RLMachine::Gosub(libreallive::BytecodeList::iterator new_location) {
+void RLMachine::Gosub(libreallive::pointer_t new_location) {
   PushStackFrame(StackFrame(
       call_stack_.back().scenario, new_location, StackFrame::TYPE_GOSUB));
 }
@@ -546,7 +589,11 @@ const libreallive::Scenario& RLMachine::Scenario() const {
 }
 
 void RLMachine::ExecuteExpression(const libreallive::ExpressionElement& e) {
-  e.ParsedExpression().GetIntegerValue(*this);
+  const libreallive::CompiledExpression& compiled = e.GetCompiledExpression();
+  if (compiled.is_valid())
+    compiled.Evaluate(*this);
+  else
+    e.ParsedExpression().GetIntegerValue(*this);
   AdvanceInstructionPointer();
 }
 
@@ -565,6 +612,7 @@ void RLMachine::PerformTextout(const libreallive::TextoutElement& e) {
     Halt();
   }
 
+  PrefetchUpcomingVoices();
   PerformTextout(unparsed_text);
 }
 
@@ -600,6 +648,36 @@ void RLMachine::PerformTextout(const std::string& cp932str) {
   }
 }
 
+void RLMachine::PrefetchUpcomingVoices() {
+  if (call_stack_.empty())
+    return;
+
+  const StackFrame& frame = call_stack_.back();
+  libreallive::Scenario::const_iterator it = frame.ip;
+  int voices = 0;
+  for (int i = 0; i < kVoiceLookaheadElements && it != frame.scenario->end();
+       ++i, ++it) {
+    const libreallive::CommandElement* command =
+        dynamic_cast<const libreallive::CommandElement*>(*it);
+    if (!command || !IsKoePlayCommand(*command))
+      continue;
+
+    try {
+      std::string param = command->GetParam(0);
+      const char* src = param.c_str();
+      libreallive::ExpressionPiece id(libreallive::GetExpression(src));
+      if (id.IsIntConstant()) {
+        system().sound().PrefetchKoe(id.GetIntConstant());
+        if (++voices == kVoiceLookaheadVoices)
+          return;
+      }
+    }
+    catch (libreallive::Error& e) {
+      // Unparsable parameters are reported when the command is executed.
+    }
+  }
+}
+
 void RLMachine::SetKidokuMarker(int kidoku_number) {
   // Check to see if we mark savepoints on textout
   if (ShouldSetMessageSavepoint() &&
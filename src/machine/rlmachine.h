@@ -46,6 +46,7 @@ class Archive;
 class IntMemRef;
 };
 
+class GameexeKey;
 class LongOperation;
 class Memory;
 class OpcodeLog;
@@ -137,7 +138,7 @@ class RLMachine {
   //   return. On any other value, we fall through to...
   // - Check a Gameexe key, which has the final say.
   bool SavepointDecide(AttributeFunction func,
-                       const std::string& gameexe_key) const;
+                       const GameexeKey& gameexe_key) const;
 
   // Whether the DisableAutoSavepoints override is on. This is
   // triggered purely from bytecode.
@@ -175,12 +176,12 @@ class RLMachine {
 
   // Permanently moves the instruction pointer to the passed in
   // iterator in the current stack frame.
-  void GotoLocation(libreallive::BytecodeList::iterator new_location);
+  void GotoLocation(libreallive::pointer_t new_location);
 
   // Pushes a new stack frame onto the call stack, saving the current
   // location. The new frame contains the current SEEN with
   // new_location as the instruction pointer.
-  void Gosub(libreallive::BytecodeList::iterator new_location);
+  void Gosub(libreallive::pointer_t new_location);
 
   // Returns from the most recent gosub call. Throws if there's a mismatch
   // between farcall()/rtl() gosub()/ret() pairs.
@@ -362,6 +363,12 @@ class RLMachine {
   // Mapping between the module_type:module pair and the module implementation
   ModuleMap modules_;
 
+  // Identifies the current contents of |modules_|. CommandElements cache the
+  // RLOperation they resolve to under this id, so it changes whenever a
+  // module is attached, and is unique across RLMachine instances that share
+  // the same Scenarios.
+  int dispatch_id_;
+
   // States whether the RLMachine is in the halted state (and thus won't
   // execute more instructions)
   bool halted_ = false;
@@ -421,6 +428,11 @@ class RLMachine {
   // Currently loaded "DLLs".
   DLLMap loaded_dlls_;
 
+  // Looks a short way past the current instruction for koePlay family calls
+  // with constant ids, and has the sound system start decoding those voices
+  // so they're ready by the time the script plays them.
+  void PrefetchUpcomingVoices();
+
   // boost::serialization support
   friend class boost::serialization::access;
 
@@ -139,27 +139,39 @@ std::string RLModule::GetCommandName(RLMachine& machine,
 
 void RLModule::DispatchFunction(RLMachine& machine,
                                 const libreallive::CommandElement& f) {
+  RLOperation* op = FindOperation(f);
+  if (op)
+    DispatchOperation(machine, f, op);
+  else
+    throw rlvm::UnimplementedOpcode(machine, f);
+}
+
+RLOperation* RLModule::FindOperation(const libreallive::CommandElement& f) {
   OpcodeMap::iterator it =
       stored_operations_.find(PackOpcodeNumber(f.opcode(), f.overload()));
-  if (it != stored_operations_.end()) {
-    try {
-      if (machine.is_tracing_on()) {
-        std::cerr << "(SEEN" << std::setw(4) << std::setfill('0')
-                  << machine.SceneNumber()
-                  << ")(Line " << std::setw(4) << std::setfill('0')
-                  << machine.line_number() << "): " << it->second->name();
-        libreallive::PrintParameterString(std::cerr,
-                                          f.GetUnparsedParameters());
-        std::cerr << std::endl;
-      }
-      it->second->DispatchFunction(machine, f);
-    }
-    catch (rlvm::Exception& e) {
-      e.setOperation(it->second.get());
-      throw;
+  if (it != stored_operations_.end())
+    return it->second.get();
+  return nullptr;
+}
+
+// static
+void RLModule::DispatchOperation(RLMachine& machine,
+                                 const libreallive::CommandElement& f,
+                                 RLOperation* op) {
+  try {
+    if (machine.is_tracing_on()) {
+      std::cerr << "(SEEN" << std::setw(4) << std::setfill('0')
+                << machine.SceneNumber()
+                << ")(Line " << std::setw(4) << std::setfill('0')
+                << machine.line_number() << "): " << op->name();
+      libreallive::PrintParameterString(std::cerr, f.GetUnparsedParameters());
+      std::cerr << std::endl;
     }
-  } else {
-    throw rlvm::UnimplementedOpcode(machine, f);
+    op->DispatchFunction(machine, f);
+  }
+  catch (rlvm::Exception& e) {
+    e.setOperation(op);
+    throw;
   }
 }
 
@@ -130,6 +130,16 @@ class RLModule {
   void DispatchFunction(RLMachine& machine,
                         const libreallive::CommandElement& f);
 
+  // Returns the RLOperation in this module which implements |f|, or NULL if
+  // there isn't one.
+  RLOperation* FindOperation(const libreallive::CommandElement& f);
+
+  // Executes |f| with the already resolved operation |op|, handling tracing
+  // and annotating thrown exceptions with |op|.
+  static void DispatchOperation(RLMachine& machine,
+                                const libreallive::CommandElement& f,
+                                RLOperation* op);
+
   std::string GetCommandName(RLMachine& machine,
                              const libreallive::CommandElement& f);
 
@@ -32,6 +32,7 @@
 #include "libreallive/gameexe.h"
 #include "libreallive/reallive.h"
 #include "machine/dump_scenario.h"
+#include "machine/frame_scheduler.h"
 #include "machine/game_hacks.h"
 #include "machine/memory.h"
 #include "machine/rlmachine.h"
@@ -39,7 +40,6 @@
 #include "modules/module_sys_save.h"
 #include "modules/modules.h"
 #include "platforms/gcn/gcn_platform.h"
-#include "systems/base/event_system.h"
 #include "systems/base/graphics_system.h"
 #include "systems/base/system_error.h"
 #include "systems/sdl/sdl_system.h"
@@ -67,7 +67,11 @@ RLVMInstance::RLVMInstance()
       count_undefined_copcodes_(false),
       tracing_(false),
       load_save_(-1),
-      dump_seen_(-1) {
+      dump_seen_(-1),
+      prefetch_scenarios_(false),
+      cache_scenarios_(false),
+      image_cache_mb_(-1),
+      texture_cache_mb_(-1) {
   srand(time(NULL));
 }
 
@@ -103,8 +107,19 @@ void RLVMInstance::Run(const boost::filesystem::path& gamerootPath) {
       gameexe("__GAMEFONT") = custom_font_;
     }
 
+    if (image_cache_mb_ >= 0)
+      gameexe("__IMAGE_CACHE_MB") = image_cache_mb_;
+    if (texture_cache_mb_ >= 0)
+      gameexe("__TEXTURE_CACHE_MB") = texture_cache_mb_;
+
     libreallive::Archive arc(seenPath.string(), gameexe("REGNAME"));
+    if (prefetch_scenarios_)
+      arc.EnablePrefetching();
     SDLSystem sdlSystem(gameexe);
+    if (cache_scenarios_) {
+      arc.EnableDiskCache(
+          (sdlSystem.GameSaveDirectory() / "seen_cache").string());
+    }
     RLMachine rlmachine(sdlSystem, arc);
     AddAllModules(rlmachine);
     AddGameHacks(rlmachine);
@@ -152,34 +167,8 @@ void RLVMInstance::Run(const boost::filesystem::path& gamerootPath) {
     if (load_save_ != -1)
       Sys_load()(rlmachine, load_save_);
 
-    while (!rlmachine.halted()) {
-      // Give SDL a chance to respond to events, redraw the screen,
-      // etc.
-      sdlSystem.Run(rlmachine);
-
-      // Run the rlmachine through as many instructions as we can in a 10ms time
-      // slice. Bail out if we switch to long operation mode, or if the screen
-      // is marked as dirty.
-      unsigned int start_ticks = sdlSystem.event().GetTicks();
-      unsigned int end_ticks = start_ticks;
-      do {
-        rlmachine.ExecuteNextInstruction();
-        end_ticks = sdlSystem.event().GetTicks();
-      } while (!rlmachine.CurrentLongOperation() &&
-               !sdlSystem.force_wait() &&
-               (end_ticks - start_ticks < 10));
-
-      // Sleep to be nice to the processor and to give the GPU a chance to
-      // catch up.
-      if (!sdlSystem.ShouldFastForward()) {
-        int real_sleep_time = 10 - (end_ticks - start_ticks);
-        if (real_sleep_time < 1)
-          real_sleep_time = 1;
-        sdlSystem.event().Wait(real_sleep_time);
-      }
-
-      sdlSystem.set_force_wait(false);
-    }
+    FrameScheduler scheduler(sdlSystem, rlmachine);
+    scheduler.Run();
 
     Serialization::saveGlobalMemory(rlmachine);
   }
@@ -51,6 +51,10 @@ class RLVMInstance {
   void set_tracing() { tracing_ = true; }
   void set_load_save(int in) { load_save_ = in; }
   void set_custom_font(const std::string& font) { custom_font_ = font; }
+  void set_prefetch_scenarios() { prefetch_scenarios_ = true; }
+  void set_cache_scenarios() { cache_scenarios_ = true; }
+  void set_image_cache_mb(int in) { image_cache_mb_ = in; }
+  void set_texture_cache_mb(int in) { texture_cache_mb_ = in; }
 
   void set_dump_seen(int in) { dump_seen_ = in; }
 
@@ -110,6 +114,17 @@ class RLVMInstance {
 
   // Dumps pseudo-kepago of the current seen to stdout and exit if not -1.
   int dump_seen_;
+
+  // Whether the archive should parse upcoming SEENs on a background thread.
+  bool prefetch_scenarios_;
+
+  // Whether the archive should keep decompressed SEENs in the save directory.
+  bool cache_scenarios_;
+
+  // Overrides for the image cache budgets in megabytes (-1 if we shouldn't
+  // set these).
+  int image_cache_mb_;
+  int texture_cache_mb_;
 };
 
 #endif  // SRC_MACHINE_RLVM_INSTANCE_H_
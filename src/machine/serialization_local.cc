@@ -36,6 +36,8 @@
 #include <boost/filesystem/fstream.hpp>
 #include <boost/iostreams/filtering_stream.hpp>
 #include <boost/iostreams/filter/zlib.hpp>
+#include <cstdint>
+#include <cstring>
 #include <fstream>
 #include <sstream>
 #include <iostream>
@@ -69,12 +71,25 @@ namespace Serialization {
 
 RLMachine* g_current_machine = NULL;
 
-const int CURRENT_LOCAL_VERSION = 2;
+// Version of the binary save format. Version 0 is reserved for the legacy
+// format, which is a zlib compressed boost text archive of everything.
+// Version 1 was never released and isn't read.
+const int CURRENT_BINARY_VERSION = 2;
 
 }  // namespace Serialization
 
 namespace {
 
+// Binary save games start with this uncompressed tag, a little endian int32
+// format version and the SaveGameHeader; everything after that is zlib
+// compressed. This lets the save/load menus read a slot's header without
+// inflating anything. Legacy save games start with a zlib header instead, so
+// the two can't be confused.
+const char kBinarySaveMagic[] = {'R', 'L', 'V', 'M', 'S', 'A', 'V', 'E'};
+const size_t kBinarySaveMagicSize = sizeof(kBinarySaveMagic);
+
+const int64_t kNotADateTime = INT64_MIN;
+
 template <typename TYPE>
 void checkInFileOpened(TYPE& file, const fs::path& home) {
   if (!file) {
@@ -83,6 +98,171 @@ void checkInFileOpened(TYPE& file, const fs::path& home) {
   }
 }
 
+void CheckStream(std::istream& is) {
+  if (!is)
+    throw rlvm::Exception(_("Save game file is truncated"));
+}
+
+bool IsLittleEndian() {
+  const uint16_t probe = 1;
+  return *reinterpret_cast<const uint8_t*>(&probe) == 1;
+}
+
+void WriteInt32(std::ostream& os, int32_t value) {
+  uint8_t buf[4] = {uint8_t(value), uint8_t(value >> 8),
+                    uint8_t(value >> 16), uint8_t(value >> 24)};
+  os.write(reinterpret_cast<const char*>(buf), sizeof(buf));
+}
+
+int32_t ReadInt32(std::istream& is) {
+  uint8_t buf[4];
+  is.read(reinterpret_cast<char*>(buf), sizeof(buf));
+  CheckStream(is);
+  return int32_t(uint32_t(buf[0]) | (uint32_t(buf[1]) << 8) |
+                 (uint32_t(buf[2]) << 16) | (uint32_t(buf[3]) << 24));
+}
+
+void WriteInt64(std::ostream& os, int64_t value) {
+  WriteInt32(os, int32_t(value & 0xffffffff));
+  WriteInt32(os, int32_t(value >> 32));
+}
+
+int64_t ReadInt64(std::istream& is) {
+  uint32_t low = uint32_t(ReadInt32(is));
+  return (int64_t(ReadInt32(is)) << 32) | low;
+}
+
+void WriteString(std::ostream& os, const std::string& str) {
+  WriteInt32(os, str.size());
+  os.write(str.data(), str.size());
+}
+
+std::string ReadString(std::istream& is) {
+  int32_t size = ReadInt32(is);
+  if (size < 0)
+    throw rlvm::Exception(_("Save game file is corrupted"));
+
+  std::string str(size, '\0');
+  if (size)
+    is.read(&str[0], size);
+  CheckStream(is);
+  return str;
+}
+
+// Writes a whole int bank as one little endian block.
+void WriteIntBank(std::ostream& os, const int (&bank)[SIZE_OF_MEM_BANK]) {
+  if (IsLittleEndian()) {
+    os.write(reinterpret_cast<const char*>(bank), sizeof(bank));
+  } else {
+    for (int value : bank)
+      WriteInt32(os, value);
+  }
+}
+
+void ReadIntBank(std::istream& is, int (&bank)[SIZE_OF_MEM_BANK]) {
+  if (IsLittleEndian()) {
+    is.read(reinterpret_cast<char*>(bank), sizeof(bank));
+    CheckStream(is);
+  } else {
+    for (int& value : bank)
+      value = ReadInt32(is);
+  }
+}
+
+// Like LocalMemory::saveArrayRevertingChanges(), writes the contents of |a| as
+// they were at the last savepoint.
+void WriteIntBankRevertingChanges(std::ostream& os,
+                                  const int (&a)[SIZE_OF_MEM_BANK],
+                                  const std::map<int, int>& original) {
+  int merged[SIZE_OF_MEM_BANK];
+  std::copy(a, a + SIZE_OF_MEM_BANK, merged);
+  for (auto it = original.cbegin(); it != original.cend(); ++it)
+    merged[it->first] = it->second;
+  WriteIntBank(os, merged);
+}
+
+void WriteHeader(std::ostream& os, const SaveGameHeader& header) {
+  WriteString(os, header.title);
+
+  int64_t save_time = kNotADateTime;
+  if (!header.save_time.is_special()) {
+    const boost::posix_time::ptime epoch(boost::gregorian::date(1970, 1, 1));
+    save_time = (header.save_time - epoch).total_microseconds();
+  }
+  WriteInt64(os, save_time);
+}
+
+SaveGameHeader ReadHeader(std::istream& is) {
+  SaveGameHeader header;
+  header.title = ReadString(is);
+
+  int64_t save_time = ReadInt64(is);
+  if (save_time == kNotADateTime) {
+    header.save_time = boost::posix_time::ptime();
+  } else {
+    const boost::posix_time::ptime epoch(boost::gregorian::date(1970, 1, 1));
+    header.save_time = epoch + boost::posix_time::microseconds(save_time);
+  }
+  return header;
+}
+
+void WriteLocalMemory(std::ostream& os, const LocalMemory& local) {
+  WriteIntBankRevertingChanges(os, local.intA, local.original_intA);
+  WriteIntBankRevertingChanges(os, local.intB, local.original_intB);
+  WriteIntBankRevertingChanges(os, local.intC, local.original_intC);
+  WriteIntBankRevertingChanges(os, local.intD, local.original_intD);
+  WriteIntBankRevertingChanges(os, local.intE, local.original_intE);
+  WriteIntBankRevertingChanges(os, local.intF, local.original_intF);
+
+  for (int i = 0; i < SIZE_OF_MEM_BANK; ++i) {
+    auto it = local.original_strS.find(i);
+    WriteString(os, it != local.original_strS.end() ? it->second
+                                                    : local.strS[i]);
+  }
+
+  for (const std::string& name : local.local_names)
+    WriteString(os, name);
+}
+
+void ReadLocalMemory(std::istream& is, LocalMemory& local) {
+  ReadIntBank(is, local.intA);
+  ReadIntBank(is, local.intB);
+  ReadIntBank(is, local.intC);
+  ReadIntBank(is, local.intD);
+  ReadIntBank(is, local.intE);
+  ReadIntBank(is, local.intF);
+
+  for (std::string& str : local.strS)
+    str = ReadString(is);
+
+  for (std::string& name : local.local_names)
+    name = ReadString(is);
+}
+
+// Consumes the binary save tag at the start of |iss| and returns the binary
+// format version. If there is no tag, rewinds |iss| and returns 0, meaning
+// this is a legacy text archive save. Throws on binary versions we can't read.
+int ReadSaveFormatVersion(std::istream& iss) {
+  std::istream::pos_type start = iss.tellg();
+
+  char magic[kBinarySaveMagicSize];
+  iss.read(magic, kBinarySaveMagicSize);
+  if (iss && memcmp(magic, kBinarySaveMagic, kBinarySaveMagicSize) == 0) {
+    int version = ReadInt32(iss);
+    if (version > Serialization::CURRENT_BINARY_VERSION) {
+      throw rlvm::Exception(
+          _("Save game file was written by a newer version of rlvm"));
+    }
+    if (version < Serialization::CURRENT_BINARY_VERSION)
+      throw rlvm::Exception(_("Save game file is in an unsupported format"));
+    return version;
+  }
+
+  iss.clear();
+  iss.seekg(start);
+  return 0;
+}
+
 }  // namespace
 
 namespace Serialization {
@@ -96,19 +276,26 @@ void saveGameForSlot(RLMachine& machine, int slot) {
 }
 
 void saveGameTo(std::ostream& oss, RLMachine& machine) {
+  const SaveGameHeader header(machine.system().graphics().window_subtitle());
+
+  oss.write(kBinarySaveMagic, kBinarySaveMagicSize);
+  WriteInt32(oss, CURRENT_BINARY_VERSION);
+  WriteHeader(oss, header);
+
   boost::iostreams::filtering_stream<boost::iostreams::output> filtered_output;
   filtered_output.push(boost::iostreams::zlib_compressor());
   filtered_output.push(oss);
 
-  const SaveGameHeader header(machine.system().graphics().window_subtitle());
-
   g_current_machine = &machine;
 
   try {
+    // Local memory is the bulk of the file and is written as raw blocks. The
+    // rest of the state is small and polymorphic, so it still goes through
+    // boost::serialization.
+    WriteLocalMemory(filtered_output, machine.memory().local());
+
     boost::archive::text_oarchive oa(filtered_output);
-    oa << CURRENT_LOCAL_VERSION << header
-       << const_cast<const LocalMemory&>(machine.memory().local())
-       << const_cast<const RLMachine&>(machine)
+    oa << const_cast<const RLMachine&>(machine)
        << const_cast<const System&>(machine.system())
        << const_cast<const GraphicsSystem&>(machine.system().graphics())
        << const_cast<const TextSystem&>(machine.system().text())
@@ -141,6 +328,9 @@ SaveGameHeader loadHeaderForSlot(RLMachine& machine, int slot) {
 }
 
 SaveGameHeader loadHeaderFrom(std::istream& iss) {
+  if (ReadSaveFormatVersion(iss))
+    return ReadHeader(iss);
+
   boost::iostreams::filtering_stream<boost::iostreams::input> filtered_input;
   filtered_input.push(boost::iostreams::zlib_decompressor());
   filtered_input.push(iss);
@@ -164,10 +354,19 @@ void loadLocalMemoryForSlot(RLMachine& machine, int slot, Memory& memory) {
 }
 
 void loadLocalMemoryFrom(std::istream& iss, Memory& memory) {
+  int binary_version = ReadSaveFormatVersion(iss);
+  if (binary_version)
+    ReadHeader(iss);
+
   boost::iostreams::filtering_stream<boost::iostreams::input> filtered_input;
   filtered_input.push(boost::iostreams::zlib_decompressor());
   filtered_input.push(iss);
 
+  if (binary_version) {
+    ReadLocalMemory(filtered_input, memory.local());
+    return;
+  }
+
   int version;
   SaveGameHeader header;
 
@@ -185,13 +384,17 @@ void loadGameForSlot(RLMachine& machine, int slot) {
 }
 
 void loadGameFrom(std::istream& iss, RLMachine& machine) {
+  int version;
+  SaveGameHeader header;
+
+  int binary_version = ReadSaveFormatVersion(iss);
+  if (binary_version)
+    header = ReadHeader(iss);
+
   boost::iostreams::filtering_stream<boost::iostreams::input> filtered_input;
   filtered_input.push(boost::iostreams::zlib_decompressor());
   filtered_input.push(iss);
 
-  int version;
-  SaveGameHeader header;
-
   g_current_machine = &machine;
 
   try {
@@ -199,10 +402,18 @@ void loadGameFrom(std::istream& iss, RLMachine& machine) {
     // often hold references to objects in the System heiarchy.
     machine.Reset();
 
-    boost::archive::text_iarchive ia(filtered_input);
-    ia >> version >> header >> machine.memory().local() >> machine >>
-        machine.system() >> machine.system().graphics() >>
-        machine.system().text() >> machine.system().sound();
+    if (binary_version) {
+      ReadLocalMemory(filtered_input, machine.memory().local());
+
+      boost::archive::text_iarchive ia(filtered_input);
+      ia >> machine >> machine.system() >> machine.system().graphics() >>
+          machine.system().text() >> machine.system().sound();
+    } else {
+      boost::archive::text_iarchive ia(filtered_input);
+      ia >> version >> header >> machine.memory().local() >> machine >>
+          machine.system() >> machine.system().graphics() >>
+          machine.system().text() >> machine.system().sound();
+    }
 
     machine.system().graphics().ReplayGraphicsStack(machine);
 
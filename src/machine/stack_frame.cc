@@ -31,6 +31,7 @@
 #include "machine/stack_frame.h"
 
 #include <boost/serialization/vector.hpp>
+#include <iterator>
 #include <typeinfo>
 
 #include "libreallive/archive.h"
@@ -64,7 +65,7 @@ StackFrame::~StackFrame() {}
 
 std::ostream& operator<<(std::ostream& os, const StackFrame& frame) {
   os << "{seen=" << frame.scenario->scene_number()
-     << ", offset=" << distance(frame.scenario->begin(), frame.ip);
+     << ", offset=" << std::distance(frame.scenario->begin(), frame.ip);
 
   if (frame.long_op)
     os << " [LONG OP=" << typeid(*frame.long_op).name() << "]";
@@ -77,7 +78,7 @@ std::ostream& operator<<(std::ostream& os, const StackFrame& frame) {
 template <class Archive>
 void StackFrame::save(Archive& ar, unsigned int version) const {
   int scene_number = scenario->scene_number();
-  int position = distance(scenario->begin(), ip);
+  int position = std::distance(scenario->begin(), ip);
   ar& scene_number& position& frame_type& intL& strK;
 }
 
@@ -95,7 +96,8 @@ void StackFrame::load(Archive& ar, unsigned int version) {
     throw rlvm::Exception(oss.str());
   }
 
-  if (offset > distance(scenario->begin(), scenario->end()) || offset < 0) {
+  if (offset > std::distance(scenario->begin(), scenario->end()) ||
+      offset < 0) {
     std::ostringstream oss;
     oss << offset << " is an illegal bytecode offset for SEEN #" << scene_number
         << " in save file!";
@@ -103,7 +105,7 @@ void StackFrame::load(Archive& ar, unsigned int version) {
   }
 
   libreallive::Scenario::const_iterator position_it = scenario->begin();
-  advance(position_it, offset);
+  std::advance(position_it, offset);
 
   *this = StackFrame(scenario, position_it, type);
 
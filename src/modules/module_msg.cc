@@ -85,10 +85,11 @@ struct FontColour
 
 struct SetFontColour : public RLOpcode<DefaultIntValue_T<0>> {
   void operator()(RLMachine& machine, int textColorNum) {
-    Gameexe& gexe = machine.system().gameexe();
-    if (gexe("COLOR_TABLE", textColorNum).Exists()) {
-      machine.system().text().GetCurrentWindow()->SetDefaultTextColor(
-          gexe("COLOR_TABLE", textColorNum));
+    static GameexeIndexedKey color_table("COLOR_TABLE");
+    const GameexeInterpretObject& colour =
+        color_table(machine.system().gameexe(), textColorNum);
+    if (colour.Exists()) {
+      machine.system().text().GetCurrentWindow()->SetDefaultTextColor(colour);
     }
   }
 };
@@ -27,6 +27,7 @@
 
 #include "modules/module_obj_creation.h"
 
+#include <climits>
 #include <cmath>
 #include <memory>
 #include <string>
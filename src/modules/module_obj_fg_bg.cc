@@ -351,7 +351,7 @@ class objEveAdjust : public RLOpcode<IntConstant_T,
 
  private:
   // We need a custom mutator here. One of the parameters isn't varying.
-  class AdjustMutator : public ObjectMutator {
+  class AdjustMutator : public TweenObjectMutator {
    public:
     AdjustMutator(RLMachine& machine,
                   int repno,
@@ -363,17 +363,19 @@ class objEveAdjust : public RLOpcode<IntConstant_T,
                   int target_x,
                   int start_y,
                   int target_y)
-        : ObjectMutator(repno,
-                        "objEveAdjust",
-                        creation_time,
-                        duration_time,
-                        delay,
-                        type),
+        : TweenObjectMutator(machine.system().graphics().mutator_engine(),
+                             repno,
+                             "objEveAdjust",
+                             creation_time,
+                             duration_time,
+                             delay,
+                             type),
           repno_(repno),
-          start_x_(start_x),
           end_x_(target_x),
-          start_y_(start_y),
-          end_y_(target_y) {}
+          end_y_(target_y) {
+      AddTrack(start_x, target_x);
+      AddTrack(start_y, target_y);
+    }
 
    private:
     virtual void SetToEnd(RLMachine& machine,
@@ -388,17 +390,12 @@ class objEveAdjust : public RLOpcode<IntConstant_T,
 
     virtual void PerformSetting(RLMachine& machine,
                                 GraphicsObject& object) override {
-      int x = GetValueForTime(machine, start_x_, end_x_);
-      object.SetXAdjustment(repno_, x);
-
-      int y = GetValueForTime(machine, start_y_, end_y_);
-      object.SetYAdjustment(repno_, y);
+      object.SetXAdjustment(repno_, value(0));
+      object.SetYAdjustment(repno_, value(1));
     }
 
     int repno_;
-    int start_x_;
     int end_x_;
-    int start_y_;
     int end_y_;
   };
 };
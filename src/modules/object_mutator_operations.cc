@@ -78,7 +78,8 @@ void Op_ObjectMutatorInt::operator()(RLMachine& machine,
 
   int startval = (obj.*getter_)();
   obj.AddObjectMutator(std::unique_ptr<ObjectMutator>(
-      new OneIntObjectMutator(name_,
+      new OneIntObjectMutator(machine.system().graphics().mutator_engine(),
+                              name_,
                               creation_time,
                               duration_time,
                               delay,
@@ -109,7 +110,8 @@ void Op_ObjectMutatorRepnoInt::operator()(RLMachine& machine,
 
   int startval = (obj.*getter_)(repno);
   obj.AddObjectMutator(std::unique_ptr<ObjectMutator>(
-      new RepnoIntObjectMutator(name_,
+      new RepnoIntObjectMutator(machine.system().graphics().mutator_engine(),
+                                name_,
                                 creation_time,
                                 duration_time,
                                 delay,
@@ -148,7 +150,8 @@ void Op_ObjectMutatorIntInt::operator()(RLMachine& machine,
   int startval_two = (obj.*getter_two_)();
 
   obj.AddObjectMutator(std::unique_ptr<ObjectMutator>(
-      new TwoIntObjectMutator(name_,
+      new TwoIntObjectMutator(machine.system().graphics().mutator_engine(),
+                              name_,
                               creation_time,
                               duration_time,
                               delay,
@@ -87,7 +87,15 @@ int main(int argc, char* argv[]) {
   opts.add_options()("help", "Produce help message")(
       "help-debug", "Print help message for people working on rlvm")(
       "version", "Display version and license information")(
-      "font", po::value<string>(), "Specifies TrueType font to use.");
+      "font", po::value<string>(), "Specifies TrueType font to use.")(
+      "prefetch-seens",
+      "Decompress and parse upcoming SEENs on a background thread")(
+      "seen-cache",
+      "Keep decompressed SEENs in the save directory for faster starts")(
+      "image-cache-mb", po::value<int>(),
+      "Megabytes of decoded images to keep cached")(
+      "texture-cache-mb", po::value<int>(),
+      "Megabytes of image textures to keep cached");
 
   po::options_description debugOpts("Debugging Options");
   debugOpts.add_options()(
@@ -216,6 +224,18 @@ int main(int argc, char* argv[]) {
   if (vm.count("font"))
     instance.set_custom_font(vm["font"].as<string>());
 
+  if (vm.count("prefetch-seens"))
+    instance.set_prefetch_scenarios();
+
+  if (vm.count("seen-cache"))
+    instance.set_cache_scenarios();
+
+  if (vm.count("image-cache-mb"))
+    instance.set_image_cache_mb(vm["image-cache-mb"].as<int>());
+
+  if (vm.count("texture-cache-mb"))
+    instance.set_texture_cache_mb(vm["texture-cache-mb"].as<int>());
+
   instance.Run(gamerootPath);
 
   return 0;
@@ -99,6 +99,11 @@ void ColourFilterObjectData::PlaySet(int set) {
   // No op
 }
 
+bool ColourFilterObjectData::GetScreenFootprint(const GraphicsObject& go,
+                                                Rect* footprint) {
+  return false;
+}
+
 std::shared_ptr<const Surface> ColourFilterObjectData::CurrentSurface(
     const GraphicsObject& rp) {
   return std::shared_ptr<const Surface>();
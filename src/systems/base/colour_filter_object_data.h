@@ -63,6 +63,8 @@ class ColourFilterObjectData : public GraphicsObjectData {
   virtual void Execute(RLMachine& machine) override;
   virtual bool IsAnimation() const override;
   virtual void PlaySet(int set) override;
+  virtual bool GetScreenFootprint(const GraphicsObject& go,
+                                  Rect* footprint) override;
 
  protected:
   virtual std::shared_ptr<const Surface> CurrentSurface(
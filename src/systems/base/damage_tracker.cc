@@ -0,0 +1,119 @@
+// -*- Mode: C++; tab-width:2; indent-tabs-mode: nil; c-basic-offset: 2 -*-
+// vi:tw=80:et:ts=2:sts=2
+//
+// -----------------------------------------------------------------------
+//
+// This file is part of RLVM, a RealLive virtual machine clone.
+//
+// -----------------------------------------------------------------------
+//
+// Copyright (C) 2015 Elliot Glaysher
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA.
+// -----------------------------------------------------------------------
+
+
+#include "systems/base/damage_tracker.h"
+
+#include <algorithm>
+
+namespace {
+
+int64_t AreaOf(const Rect& rect) {
+  if (rect.width() <= 0 || rect.height() <= 0)
+    return 0;
+  return int64_t(rect.width()) * rect.height();
+}
+
+}  // namespace
+
+DamageTracker::Stats::Stats()
+    : full_frames(0),
+      partial_frames(0),
+      last_frame_pixels(0),
+      total_pixels(0) {}
+
+DamageTracker::DamageTracker(const Size& screen_size, int full_redraw_percent)
+    : screen_size_(screen_size),
+      full_redraw_percent_(full_redraw_percent),
+      full_(true),
+      has_damage_(false) {}
+
+DamageTracker::~DamageTracker() {}
+
+void DamageTracker::SetScreenSize(const Size& screen_size) {
+  screen_size_ = screen_size;
+  AddFull();
+}
+
+void DamageTracker::AddRect(const Rect& area) {
+  if (full_)
+    return;
+
+  // Rect::Intersection() counts touching edges as overlapping, so clip by
+  // hand.
+  int x1 = std::max(area.x(), 0);
+  int y1 = std::max(area.y(), 0);
+  int x2 = std::min(area.x2(), screen_size_.width());
+  int y2 = std::min(area.y2(), screen_size_.height());
+  if (x1 >= x2 || y1 >= y2)
+    return;
+
+  Rect clipped = Rect::GRP(x1, y1, x2, y2);
+  if (has_damage_) {
+    bounds_ = Rect::GRP(std::min(bounds_.x(), clipped.x()),
+                        std::min(bounds_.y(), clipped.y()),
+                        std::max(bounds_.x2(), clipped.x2()),
+                        std::max(bounds_.y2(), clipped.y2()));
+  } else {
+    bounds_ = clipped;
+    has_damage_ = true;
+  }
+}
+
+void DamageTracker::AddFull() {
+  full_ = true;
+}
+
+bool DamageTracker::IsFullRedraw() const {
+  if (full_)
+    return true;
+
+  int64_t screen_area = AreaOf(Rect(Point(0, 0), screen_size_));
+  return has_damage_ &&
+         AreaOf(bounds_) * 100 > screen_area * full_redraw_percent_;
+}
+
+Rect DamageTracker::GetRedrawRect() const {
+  if (IsFullRedraw())
+    return Rect(Point(0, 0), screen_size_);
+  else if (has_damage_)
+    return bounds_;
+  else
+    return Rect(Point(0, 0), Size(0, 0));
+}
+
+void DamageTracker::FrameDrawn(const Rect& redrawn) {
+  if (redrawn == Rect(Point(0, 0), screen_size_))
+    stats_.full_frames++;
+  else
+    stats_.partial_frames++;
+  stats_.last_frame_pixels = AreaOf(redrawn);
+  stats_.total_pixels += stats_.last_frame_pixels;
+
+  full_ = full_redraw_percent_ <= 0;
+  has_damage_ = false;
+  bounds_ = Rect();
+}
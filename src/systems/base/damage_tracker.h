@@ -0,0 +1,91 @@
+// -*- Mode: C++; tab-width:2; indent-tabs-mode: nil; c-basic-offset: 2 -*-
+// vi:tw=80:et:ts=2:sts=2
+//
+// -----------------------------------------------------------------------
+//
+// This file is part of RLVM, a RealLive virtual machine clone.
+//
+// -----------------------------------------------------------------------
+//
+// Copyright (C) 2015 Elliot Glaysher
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA.
+// -----------------------------------------------------------------------
+
+
+#ifndef SRC_SYSTEMS_BASE_DAMAGE_TRACKER_H_
+#define SRC_SYSTEMS_BASE_DAMAGE_TRACKER_H_
+
+#include <cstdint>
+
+#include "systems/base/rect.h"
+
+// Accumulates the parts of the screen that changed since the last frame, so
+// that the next frame only has to redraw their union. When the union covers
+// more than a configurable share of the screen, redrawing everything is
+// cheaper than clipping, so we fall back to a full redraw.
+class DamageTracker {
+ public:
+  struct Stats {
+    Stats();
+
+    int full_frames;
+    int partial_frames;
+
+    // Pixels redrawn by the most recent frame.
+    int64_t last_frame_pixels;
+    int64_t total_pixels;
+  };
+
+  // |full_redraw_percent| is the share of the screen past which we stop
+  // clipping. 0 disables partial redraws entirely.
+  DamageTracker(const Size& screen_size, int full_redraw_percent);
+  ~DamageTracker();
+
+  void SetScreenSize(const Size& screen_size);
+
+  // Adds |area| (in screen coordinates) to the damage. Areas off screen are
+  // ignored.
+  void AddRect(const Rect& area);
+
+  // Damages the entire screen.
+  void AddFull();
+
+  // Whether the next frame must redraw the entire screen.
+  bool IsFullRedraw() const;
+
+  // The area the next frame must redraw: the union of everything damaged so
+  // far, or the whole screen when IsFullRedraw(). May have no area when only
+  // things drawn on top of the frame (such as the cursor) changed.
+  Rect GetRedrawRect() const;
+
+  // Accounts for a frame that redrew |redrawn| and starts accumulating damage
+  // for the next one.
+  void FrameDrawn(const Rect& redrawn);
+
+  const Stats& GetStats() const { return stats_; }
+
+ private:
+  Size screen_size_;
+  int full_redraw_percent_;
+
+  bool full_;
+  bool has_damage_;
+  Rect bounds_;
+
+  Stats stats_;
+};
+
+#endif  // SRC_SYSTEMS_BASE_DAMAGE_TRACKER_H_
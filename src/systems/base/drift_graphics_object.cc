@@ -192,6 +192,12 @@ void DriftGraphicsObject::Execute(RLMachine& machine) {
   }
 }
 
+bool DriftGraphicsObject::GetScreenFootprint(const GraphicsObject& go,
+                                             Rect* footprint) {
+  // Particles wander over the whole drift area.
+  return false;
+}
+
 std::shared_ptr<const Surface> DriftGraphicsObject::CurrentSurface(
     const GraphicsObject& rp) {
   return surface_;
@@ -66,6 +66,8 @@ class DriftGraphicsObject : public GraphicsObjectData {
   virtual int PixelHeight(const GraphicsObject& rendering_properties) override;
   virtual GraphicsObjectData* Clone() const override;
   virtual void Execute(RLMachine& machine) override;
+  virtual bool GetScreenFootprint(const GraphicsObject& go,
+                                  Rect* footprint) override;
 
  protected:
   virtual std::shared_ptr<const Surface> CurrentSurface(
@@ -0,0 +1,100 @@
+// -*- Mode: C++; tab-width:2; indent-tabs-mode: nil; c-basic-offset: 2 -*-
+// vi:tw=80:et:ts=2:sts=2
+//
+// -----------------------------------------------------------------------
+//
+// This file is part of RLVM, a RealLive virtual machine clone.
+//
+// -----------------------------------------------------------------------
+//
+// Copyright (C) 2015 Elliot Glaysher
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA.
+// -----------------------------------------------------------------------
+
+
+#include "systems/base/glyph_cache.h"
+
+#include <functional>
+#include <string>
+#include <utility>
+
+namespace {
+
+// Rough cost of the list node, index slot and key on top of the coverage.
+const size_t kEntryOverhead = 96;
+
+}  // namespace
+
+// -----------------------------------------------------------------------
+// GlyphCache::Stats
+// -----------------------------------------------------------------------
+
+GlyphCache::Stats::Stats()
+    : hits(0), misses(0), evictions(0), entries(0), bytes(0) {}
+
+// -----------------------------------------------------------------------
+// GlyphCache
+// -----------------------------------------------------------------------
+
+GlyphCache::GlyphCache(size_t budget) : budget_(budget) {}
+
+GlyphCache::~GlyphCache() {}
+
+const Glyph* GlyphCache::Fetch(const std::string& text, int size, int style) {
+  return entries_.Fetch(Key{text, size, style});
+}
+
+const Glyph* GlyphCache::Insert(const std::string& text,
+                                int size,
+                                int style,
+                                Glyph glyph) {
+  size_t bytes = glyph.coverage.size() + text.size() + kEntryOverhead;
+  const Glyph* stored =
+      &entries_.Insert(Key{text, size, style}, std::move(glyph), bytes);
+  Trim();
+  return stored;
+}
+
+void GlyphCache::Clear() { entries_.Clear(); }
+
+void GlyphCache::SetBudget(size_t budget) {
+  budget_ = budget;
+  Trim();
+}
+
+GlyphCache::Stats GlyphCache::GetStats() const {
+  Stats stats;
+  stats.hits = entries_.hits();
+  stats.misses = entries_.misses();
+  stats.evictions = entries_.evictions();
+  stats.entries = entries_.size();
+  stats.bytes = entries_.bytes();
+  return stats;
+}
+
+size_t GlyphCache::KeyHash::operator()(const Key& key) const {
+  size_t hash = std::hash<std::string>()(key.text);
+  hash ^= std::hash<int>()(key.size) + 0x9e3779b9 + (hash << 6) + (hash >> 2);
+  hash ^= std::hash<int>()(key.style) + 0x9e3779b9 + (hash << 6) + (hash >> 2);
+  return hash;
+}
+
+void GlyphCache::Trim() {
+  while (entries_.bytes() > budget_) {
+    if (!entries_.EvictOldest())
+      break;
+  }
+}
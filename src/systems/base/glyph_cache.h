@@ -0,0 +1,112 @@
+// -*- Mode: C++; tab-width:2; indent-tabs-mode: nil; c-basic-offset: 2 -*-
+// vi:tw=80:et:ts=2:sts=2
+//
+// -----------------------------------------------------------------------
+//
+// This file is part of RLVM, a RealLive virtual machine clone.
+//
+// -----------------------------------------------------------------------
+//
+// Copyright (C) 2015 Elliot Glaysher
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA.
+// -----------------------------------------------------------------------
+
+
+#ifndef SRC_SYSTEMS_BASE_GLYPH_CACHE_H_
+#define SRC_SYSTEMS_BASE_GLYPH_CACHE_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "systems/base/rect.h"
+#include "utilities/sized_lru_cache.h"
+
+// A rasterized piece of text: one 8-bit coverage value per pixel, row by
+// row, with no padding. Coverage is independent of colour, so the same
+// glyph serves both the text and its shadow.
+struct Glyph {
+  Size size;
+  std::vector<uint8_t> coverage;
+};
+
+// Cache of rasterized glyphs, keyed by the UTF-8 text rendered (normally a
+// single character), the font size and the font style. Shared by everything
+// that draws text, so a character rasterized for the message window is
+// reused when the backlog replays the page or a text object shows it.
+// Evicts the least recently used glyphs once their coverage goes over a
+// memory budget.
+class GlyphCache {
+ public:
+  struct Stats {
+    Stats();
+
+    int hits;
+    int misses;
+    int evictions;
+
+    size_t entries;
+    size_t bytes;
+  };
+
+  explicit GlyphCache(size_t budget);
+  ~GlyphCache();
+
+  // Returns the glyph cached for |text| at |size| in |style| and marks it as
+  // the most recently used, or returns NULL. Counts as a hit or a miss. The
+  // pointer stays valid until the next call to Insert(), SetBudget() or
+  // Clear().
+  const Glyph* Fetch(const std::string& text, int size, int style);
+
+  // Caches |glyph| and returns the stored copy, then evicts least recently
+  // used entries until we're back under budget. The entry just inserted is
+  // never evicted, even if it alone is over budget.
+  const Glyph* Insert(const std::string& text,
+                      int size,
+                      int style,
+                      Glyph glyph);
+
+  void Clear();
+
+  // Budget is in bytes.
+  void SetBudget(size_t budget);
+  size_t budget() const { return budget_; }
+
+  Stats GetStats() const;
+
+ private:
+  struct Key {
+    std::string text;
+    int size;
+    int style;
+
+    bool operator==(const Key& rhs) const {
+      return size == rhs.size && style == rhs.style && text == rhs.text;
+    }
+  };
+
+  struct KeyHash {
+    size_t operator()(const Key& key) const;
+  };
+
+  void Trim();
+
+  SizedLRUCache<Key, Glyph, KeyHash> entries_;
+  size_t budget_;
+};
+
+#endif  // SRC_SYSTEMS_BASE_GLYPH_CACHE_H_
@@ -89,6 +89,8 @@ const Rect EMPTY_CLIP = Rect(Point(0, 0), Size(-1, -1));
 const boost::shared_ptr<GraphicsObject::Impl> GraphicsObject::s_empty_impl(
     new GraphicsObject::Impl);
 
+unsigned int GraphicsObject::s_last_revision = 0;
+
 // -----------------------------------------------------------------------
 // GraphicsObject::TextProperties
 // -----------------------------------------------------------------------
@@ -137,9 +139,11 @@ GraphicsObject::Impl::ButtonProperties::ButtonProperties()
 // -----------------------------------------------------------------------
 // GraphicsObject
 // -----------------------------------------------------------------------
-GraphicsObject::GraphicsObject() : impl_(s_empty_impl) {}
+GraphicsObject::GraphicsObject()
+    : impl_(s_empty_impl), revision_(++s_last_revision) {}
 
-GraphicsObject::GraphicsObject(const GraphicsObject& rhs) : impl_(rhs.impl_) {
+GraphicsObject::GraphicsObject(const GraphicsObject& rhs)
+    : impl_(rhs.impl_), revision_(++s_last_revision) {
   if (rhs.object_data_) {
     object_data_.reset(rhs.object_data_->Clone());
     object_data_->set_owned_by(*this);
@@ -156,6 +160,7 @@ GraphicsObject::~GraphicsObject() { DeleteObjectMutators(); }
 GraphicsObject& GraphicsObject::operator=(const GraphicsObject& obj) {
   DeleteObjectMutators();
   impl_ = obj.impl_;
+  Touch();
 
   if (obj.object_data_) {
     object_data_.reset(obj.object_data_->Clone());
@@ -173,6 +178,7 @@ GraphicsObject& GraphicsObject::operator=(const GraphicsObject& obj) {
 void GraphicsObject::SetObjectData(GraphicsObjectData* obj) {
   object_data_.reset(obj);
   object_data_->set_owned_by(*this);
+  Touch();
 }
 
 void GraphicsObject::SetVisible(const int in) {
@@ -856,8 +862,11 @@ void GraphicsObject::MakeImplUnique() {
   if (!impl_.unique()) {
     impl_.reset(new Impl(*impl_));
   }
+  Touch();
 }
 
+void GraphicsObject::Touch() { revision_ = ++s_last_revision; }
+
 void GraphicsObject::DeleteObjectMutators() {
   object_mutators_.clear();
 }
@@ -876,17 +885,20 @@ void GraphicsObject::Render(int objNum,
 
 void GraphicsObject::FreeObjectData() {
   object_data_.reset();
+  Touch();
   DeleteObjectMutators();
 }
 
 void GraphicsObject::InitializeParams() {
   impl_ = s_empty_impl;
+  Touch();
   DeleteObjectMutators();
 }
 
 void GraphicsObject::FreeDataAndInitializeParams() {
   object_data_.reset();
   impl_ = s_empty_impl;
+  Touch();
   DeleteObjectMutators();
 }
 
@@ -910,6 +922,8 @@ void GraphicsObject::Execute(RLMachine& machine) {
 template <class Archive>
 void GraphicsObject::serialize(Archive& ar, unsigned int version) {
   ar& impl_& object_data_;
+  if (Archive::is_loading::value)
+    Touch();
 }
 
 // -----------------------------------------------------------------------
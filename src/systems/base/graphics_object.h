@@ -315,12 +315,20 @@ class GraphicsObject {
   // Whether we have the default shared data. Only used in unit testing.
   bool is_cleared() const { return impl_ == s_empty_impl; }
 
+  // Changes every time anything that affects how this object renders is
+  // modified through this interface. Unique across all objects, so that
+  // GraphicsSystem can tell a changed object apart from a replaced one.
+  unsigned int revision() const { return revision_; }
+
  private:
   // Makes the internal copy for our copy-on-write semantics. This function
   // checks to see if our Impl object has only one reference to it. If it
   // doesn't, a local copy is made.
   void MakeImplUnique();
 
+  // Gives this object a new revision().
+  void Touch();
+
   // Immediately delete all mutators; doesn't run their SetToEnd() method.
   void DeleteObjectMutators();
 
@@ -525,6 +533,12 @@ class GraphicsObject {
   // RLMAX SDK.
   std::vector<std::unique_ptr<ObjectMutator>> object_mutators_;
 
+  // Not serialized; see revision().
+  unsigned int revision_;
+
+  // The last revision handed out to any object.
+  static unsigned int s_last_revision;
+
   friend class boost::serialization::access;
 
   // boost::serialization support
@@ -266,6 +266,23 @@ Rect GraphicsObjectData::DstRect(const GraphicsObject& go,
   return Rect::GRP(xPos1, yPos1, xPos2, yPos2);
 }
 
+bool GraphicsObjectData::GetScreenFootprint(const GraphicsObject& go,
+                                            Rect* footprint) {
+  // Rotation happens around the object's origin, so it can leave DstRect().
+  if (go.rotation() != 0)
+    return false;
+
+  Rect dst = DstRect(go, NULL);
+  if (go.GetButtonUsingOverides()) {
+    dst = Rect(dst.origin() + Size(go.GetButtonXOffsetOverride(),
+                                   go.GetButtonYOffsetOverride()),
+               dst.size());
+  }
+
+  *footprint = dst;
+  return true;
+}
+
 int GraphicsObjectData::GetRenderingAlpha(const GraphicsObject& go,
                                           const GraphicsObject* parent) {
   if (!parent) {
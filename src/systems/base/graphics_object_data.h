@@ -85,6 +85,12 @@ class GraphicsObjectData {
   // format.
   virtual Rect DstRect(const GraphicsObject& go, const GraphicsObject* parent);
 
+  // Stores in |footprint| a rectangle containing everything Render() draws
+  // for a top level object, for damage tracking. Returns false when that
+  // can't be bounded cheaply, in which case any change to the object
+  // redraws the whole screen.
+  virtual bool GetScreenFootprint(const GraphicsObject& go, Rect* footprint);
+
  protected:
   // Function called after animation ends when this object has been
   // set up to loop. Default implementation does nothing.
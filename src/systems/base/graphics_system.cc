@@ -61,9 +61,12 @@
 #include "systems/base/graphics_stack_frame.h"
 #include "systems/base/hik_renderer.h"
 #include "systems/base/hik_script.h"
+#include "systems/base/image_decoder.h"
 #include "systems/base/mouse_cursor.h"
+#include "systems/base/mutator_engine.h"
 #include "systems/base/object_mutator.h"
 #include "systems/base/object_settings.h"
+#include "systems/base/parent_graphics_object_data.h"
 #include "systems/base/surface.h"
 #include "systems/base/system.h"
 #include "systems/base/system_error.h"
@@ -83,6 +86,33 @@ using std::vector;
 
 namespace fs = boost::filesystem;
 
+namespace {
+
+const size_t kMegabyte = 1024 * 1024;
+
+// Default budgets for the image cache. The decoded budget holds about a dozen
+// full screen 1280x720 CGs.
+const int kDefaultImageCacheMB = 48;
+const int kDefaultTextureCacheMB = 64;
+
+// Past this share of the screen, clipping the redraw isn't worth it.
+const int kDefaultPartialRedrawPercent = 50;
+
+// Revision of everything that goes into rendering |obj|. Children of a parent
+// layer aren't reachable from the parent's own revision.
+unsigned int RenderRevision(GraphicsObject& obj) {
+  unsigned int revision = obj.revision();
+  if (obj.has_object_data() && obj.GetObjectData().IsParentLayer()) {
+    ParentGraphicsObjectData& parent =
+        static_cast<ParentGraphicsObjectData&>(obj.GetObjectData());
+    for (GraphicsObject& child : parent.objects())
+      revision += child.revision();
+  }
+  return revision;
+}
+
+}  // namespace
+
 // -----------------------------------------------------------------------
 // GraphicsSystem::GraphicsObjectSettings
 // -----------------------------------------------------------------------
@@ -229,6 +259,7 @@ GraphicsSystem::GraphicsSystem(System& system, Gameexe& gameexe)
       interface_hidden_(false),
       globals_(gameexe),
       time_at_last_queue_change_(0),
+      mutator_engine_(std::make_shared<MutatorEngine>()),
       graphics_object_settings_(new GraphicsObjectSettings(gameexe)),
       graphics_object_impl_(new GraphicsObjectImpl(
           graphics_object_settings_->objects_in_a_layer)),
@@ -238,7 +269,18 @@ GraphicsSystem::GraphicsSystem(System& system, Gameexe& gameexe)
       system_(system),
       preloaded_hik_scripts_(32),
       preloaded_g00_(256),
-      image_cache_(10) {}
+      image_cache_(
+          gameexe("__IMAGE_CACHE_MB").ToNonNegativeInt(kDefaultImageCacheMB) *
+              kMegabyte,
+          gameexe("__TEXTURE_CACHE_MB")
+                  .ToNonNegativeInt(kDefaultTextureCacheMB) *
+              kMegabyte),
+      image_decoder_(new ImageDecoder),
+      render_slots_(graphics_object_settings_->objects_in_a_layer),
+      damage_tracker_(Size(),
+                      gameexe("__PARTIAL_REDRAW_PERCENT")
+                          .ToInt(kDefaultPartialRedrawPercent)),
+      object_footprints_(graphics_object_settings_->objects_in_a_layer) {}
 
 // -----------------------------------------------------------------------
 
@@ -246,16 +288,35 @@ GraphicsSystem::~GraphicsSystem() {}
 
 // -----------------------------------------------------------------------
 
+GraphicsSystem::ObjectFootprint::ObjectFootprint()
+    : shown(false), revision(0), bounded(false) {}
+
+GraphicsSystem::RenderSlot::RenderSlot() : drawn(false), revision(0) {}
+
+// -----------------------------------------------------------------------
+
 void GraphicsSystem::MarkScreenAsDirty(GraphicsUpdateType type) {
+  // The cursor is drawn on top of the finished frame, so moving it doesn't
+  // damage anything.
+  MarkScreenAreaAsDirty(type,
+                        type == GUT_MOUSE_MOTION ? Rect() : screen_rect());
+}
+
+void GraphicsSystem::MarkScreenAreaAsDirty(GraphicsUpdateType type,
+                                           const Rect& area) {
   switch (screen_update_mode()) {
     case SCREENUPDATEMODE_AUTOMATIC:
     case SCREENUPDATEMODE_SEMIAUTOMATIC: {
       // Perform a blit of DC0 to the screen, and update it.
       screen_needs_refresh_ = true;
+      damage_tracker_.AddRect(area);
       break;
     }
     case SCREENUPDATEMODE_MANUAL: {
-      // Don't really do anything.
+      // Don't schedule a refresh, but remember the damage: the script may
+      // switch back to automatic mode without asking for one, and the next
+      // refresh has to include what changed in the meantime.
+      damage_tracker_.AddRect(area);
       break;
     }
     default: {
@@ -270,6 +331,7 @@ void GraphicsSystem::MarkScreenAsDirty(GraphicsUpdateType type) {
 
 void GraphicsSystem::ForceRefresh() {
   screen_needs_refresh_ = true;
+  damage_tracker_.AddFull();
 
   if (screen_update_mode_ == SCREENUPDATEMODE_MANUAL) {
     // Note: SDLEventSystem can also set_force_wait(), in the case of automatic
@@ -423,12 +485,14 @@ void GraphicsSystem::SetHikRenderer(HIKRenderer* renderer) {
 
 void GraphicsSystem::AddRenderable(Renderable* renderable) {
   final_renderers_.insert(renderable);
+  damage_tracker_.AddFull();
 }
 
 // -----------------------------------------------------------------------
 
 void GraphicsSystem::RemoveRenderable(Renderable* renderable) {
   final_renderers_.erase(renderable);
+  damage_tracker_.AddFull();
 }
 
 // -----------------------------------------------------------------------
@@ -477,6 +541,24 @@ void GraphicsSystem::Refresh(std::ostream* tree) {
   EndFrame();
 }
 
+void GraphicsSystem::RefreshDamagedArea() {
+  AddObjectDamage();
+
+  // Final renderers and screen shakes are drawn over or offset the whole
+  // frame.
+  Rect area = damage_tracker_.GetRedrawRect();
+  if (!damage_tracker_.IsFullRedraw() && final_renderers_.empty() &&
+      screen_shake_queue_.empty() && BeginPartialFrame(area)) {
+    if (area.width() > 0 && area.height() > 0)
+      DrawFrame(NULL);
+    EndPartialFrame(area);
+    damage_tracker_.FrameDrawn(area);
+  } else {
+    Refresh(NULL);
+    damage_tracker_.FrameDrawn(screen_rect());
+  }
+}
+
 std::shared_ptr<Surface> GraphicsSystem::RenderToSurface() {
   BeginFrame();
   DrawFrame(NULL);
@@ -518,8 +600,10 @@ void GraphicsSystem::DrawFrame(std::ostream* tree) {
 void GraphicsSystem::ExecuteGraphicsSystem(RLMachine& machine) {
   // Check to see if any of the graphics objects are reporting that
   // they want to force a redraw
+  mutator_engine_->BeginFrame(system().event().GetTicks());
   for (GraphicsObject& obj : GetForegroundObjects())
     obj.Execute(machine);
+  mutator_engine_->EndFrame();
 
   if (mouse_cursor_)
     mouse_cursor_->Execute(system());
@@ -566,6 +650,7 @@ void GraphicsSystem::Reset() {
   background_type_ = BACKGROUND_DC0;
   subtitle_ = "";
   interface_hidden_ = false;
+  damage_tracker_.AddFull();
 }
 
 std::shared_ptr<const Surface> GraphicsSystem::GetEmojiSurface() {
@@ -617,12 +702,13 @@ std::shared_ptr<HIKScript> GraphicsSystem::GetHIKScript(
 
 void GraphicsSystem::PreloadG00(int slot, const std::string& name) {
   // We first check our implicit cache just in case so we don't load it twice.
-  std::shared_ptr<const Surface> surface = image_cache_.fetch(name);
-  if (!surface)
-    surface = LoadSurfaceFromFile(name);
-
+  // Otherwise, decode it in the background; GetPreloadedG00() finishes the
+  // job the first time the image is used.
+  std::shared_ptr<const Surface> surface = image_cache_.Fetch(name);
   if (surface)
     surface->EnsureUploaded();
+  else
+    PrefetchSurface(name);
 
   preloaded_g00_[slot] = std::make_pair(name, surface);
 }
@@ -636,8 +722,14 @@ void GraphicsSystem::ClearAllPreloadedG00() { preloaded_g00_.Clear(); }
 std::shared_ptr<const Surface> GraphicsSystem::GetPreloadedG00(
     const std::string& name) {
   for (G00ArrayItem& item : preloaded_g00_) {
-    if (item.first == name)
+    if (item.first == name) {
+      if (!item.second) {
+        item.second = LoadSurfaceFromFile(name);
+        if (item.second)
+          item.second->EnsureUploaded();
+      }
       return item.second;
+    }
   }
 
   return std::shared_ptr<const Surface>();
@@ -665,16 +757,26 @@ std::shared_ptr<const Surface> GraphicsSystem::GetSurfaceNamed(
     return cached_surface;
 
   // First check to see if this surface is already in our internal cache
-  cached_surface = image_cache_.fetch(short_filename);
+  cached_surface = image_cache_.Fetch(short_filename);
   if (cached_surface)
     return cached_surface;
 
   std::shared_ptr<const Surface> surface_to_ret =
       LoadSurfaceFromFile(short_filename);
-  image_cache_.insert(short_filename, surface_to_ret);
+  image_cache_.Insert(short_filename, surface_to_ret);
   return surface_to_ret;
 }
 
+void GraphicsSystem::PrefetchSurface(const std::string& short_filename) {
+  if (image_cache_.Contains(short_filename))
+    return;
+
+  boost::filesystem::path path =
+      system().FindFile(short_filename, IMAGE_FILETYPES);
+  if (!path.empty())
+    image_decoder_->DecodeAsync(path);
+}
+
 // -----------------------------------------------------------------------
 
 void GraphicsSystem::ClearAndPromoteObjects() {
@@ -809,34 +911,115 @@ void GraphicsSystem::ClearAllDCs() {
 // -----------------------------------------------------------------------
 
 void GraphicsSystem::RenderObjects(std::ostream* tree) {
-  to_render_.clear();
+  UpdateRenderOrder();
+
+  LazyArray<GraphicsObject>& objects =
+      graphics_object_impl_->foreground_objects;
+  BeginRenderingObjects();
+  for (const RenderKey& key : render_order_) {
+    int obj_num = get<3>(key);
+    GraphicsObject& obj = objects[obj_num];
+    if (IsObjectShown(obj_num, obj))
+      obj.Render(obj_num, NULL, tree);
+  }
+  EndRenderingObjects();
+}
 
-  // Collate all objects that we might want to render.
-  AllocatedLazyArrayIterator<GraphicsObject> it =
-      graphics_object_impl_->foreground_objects.begin();
-  AllocatedLazyArrayIterator<GraphicsObject> end =
-      graphics_object_impl_->foreground_objects.end();
-  for (; it != end; ++it) {
-    const ObjectSettings& settings = GetObjectSettings(it.pos());
-    if (settings.obj_on_off == 1 && should_show_object1() == false)
-      continue;
-    else if (settings.obj_on_off == 2 && should_show_object2() == false)
+// -----------------------------------------------------------------------
+
+void GraphicsSystem::UpdateRenderOrder() {
+  LazyArray<GraphicsObject>& objects =
+      graphics_object_impl_->foreground_objects;
+  for (int i = 0; i < objects.size(); ++i) {
+    RenderSlot& slot = render_slots_[i];
+    bool exists = objects.exists(i);
+    if (!exists && !slot.drawn)
       continue;
-    else if (settings.weather_on_off && should_show_weather() == false)
+    if (exists && objects[i].revision() == slot.revision)
       continue;
-    else if (settings.space_key && is_interface_hidden())
+
+    bool drawn = false;
+    RenderKey key;
+    if (exists) {
+      GraphicsObject& obj = objects[i];
+      slot.revision = obj.revision();
+      drawn = obj.has_object_data() && obj.visible();
+      key = RenderKey(obj.z_order(), obj.z_layer(), obj.z_depth(), i);
+    }
+
+    if (slot.drawn == drawn && (!drawn || slot.key == key))
       continue;
 
-    to_render_.emplace_back(
-        it->z_order(), it->z_layer(), it->z_depth(), it.pos(), &*it);
+    if (slot.drawn) {
+      render_order_.erase(std::lower_bound(
+          render_order_.begin(), render_order_.end(), slot.key));
+    }
+    if (drawn) {
+      render_order_.insert(
+          std::upper_bound(render_order_.begin(), render_order_.end(), key),
+          key);
+    }
+    slot.drawn = drawn;
+    slot.key = key;
   }
+}
 
-  // Sort by all the ordering values.
-  std::sort(to_render_.begin(), to_render_.end());
+// -----------------------------------------------------------------------
+
+bool GraphicsSystem::IsObjectShown(int obj_num, const GraphicsObject& obj) {
+  const ObjectSettings& settings = GetObjectSettings(obj_num);
+  if (settings.obj_on_off == 1 && should_show_object1() == false)
+    return false;
+  else if (settings.obj_on_off == 2 && should_show_object2() == false)
+    return false;
+  else if (settings.weather_on_off && should_show_weather() == false)
+    return false;
+  else if (settings.space_key && is_interface_hidden())
+    return false;
+
+  return true;
+}
 
-  for (ToRenderVec::iterator it = to_render_.begin(); it != to_render_.end();
-       ++it) {
-    get<4>(*it)->Render(get<3>(*it), NULL, tree);
+// -----------------------------------------------------------------------
+
+void GraphicsSystem::AddObjectDamage() {
+  LazyArray<GraphicsObject>& objects =
+      graphics_object_impl_->foreground_objects;
+  for (int i = 0; i < objects.size(); ++i) {
+    ObjectFootprint now;
+    if (objects.exists(i)) {
+      GraphicsObject& obj = objects[i];
+      now.shown = obj.has_object_data() && obj.visible() &&
+                  IsObjectShown(i, obj);
+      if (now.shown) {
+        now.revision = RenderRevision(obj);
+        now.bounded = obj.GetObjectData().GetScreenFootprint(obj, &now.rect);
+      }
+    }
+
+    ObjectFootprint& before = object_footprints_[i];
+    if (now.shown != before.shown ||
+        (now.shown && now.revision != before.revision)) {
+      if ((before.shown && !before.bounded) || (now.shown && !now.bounded)) {
+        damage_tracker_.AddFull();
+      } else {
+        if (before.shown)
+          damage_tracker_.AddRect(before.rect);
+        if (now.shown)
+          damage_tracker_.AddRect(now.rect);
+      }
+    }
+
+    before = now;
+  }
+
+  Rect text_footprint;
+  if (!is_interface_hidden())
+    text_footprint = system().text().GetScreenFootprint();
+  if (text_footprint != text_footprint_) {
+    damage_tracker_.AddRect(text_footprint_);
+    damage_tracker_.AddRect(text_footprint);
+    text_footprint_ = text_footprint;
   }
 }
 
@@ -878,6 +1061,7 @@ std::shared_ptr<MouseCursor> GraphicsSystem::GetCurrentCursor() {
 void GraphicsSystem::SetScreenSize(const Size& size) {
   screen_size_ = size;
   screen_rect_ = Rect(Point(0, 0), size);
+  damage_tracker_.SetScreenSize(size);
 }
 
 // -----------------------------------------------------------------------
@@ -943,6 +1127,8 @@ void GraphicsSystem::load(Archive& ar, unsigned int version) {
   // Now alert all subclasses that we've set the subtitle
   SetWindowSubtitle(subtitle_,
                     Serialization::g_current_machine->GetTextEncoding());
+
+  damage_tracker_.AddFull();
 }
 
 // -----------------------------------------------------------------------
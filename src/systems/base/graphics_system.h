@@ -39,16 +39,18 @@
 #include <queue>
 #include <set>
 #include <string>
+#include <tuple>
 #include <utility>
 #include <vector>
 
 #include "systems/base/cgm_table.h"
+#include "systems/base/damage_tracker.h"
 #include "systems/base/event_listener.h"
 #include "systems/base/rect.h"
+#include "systems/base/surface_cache.h"
 #include "systems/base/tone_curve.h"
 
 #include "utilities/lazy_array.h"
-#include "lru_cache.hpp"
 
 class ColourFilter;
 class Gameexe;
@@ -57,7 +59,9 @@ class GraphicsObjectData;
 class GraphicsStackFrame;
 class HIKRenderer;
 class HIKScript;
+class ImageDecoder;
 class MouseCursor;
+class MutatorEngine;
 class Renderable;
 class RGBAColour;
 class RLMachine;
@@ -160,6 +164,9 @@ class GraphicsSystem : public EventListener {
 
   bool is_responsible_for_update() const { return is_responsible_for_update_; }
   void set_is_responsible_for_update(bool in) {
+    // Whoever drew the screen in the meantime didn't tell us what changed.
+    if (in && !is_responsible_for_update_)
+      damage_tracker_.AddFull();
     is_responsible_for_update_ = in;
   }
 
@@ -317,6 +324,11 @@ class GraphicsSystem : public EventListener {
   // various modes.
   virtual void MarkScreenAsDirty(GraphicsUpdateType type);
 
+  // Like MarkScreenAsDirty(), but only |area| of the screen changed, so the
+  // next refresh only needs to redraw that. Changes to graphics objects don't
+  // need to be reported here; RefreshDamagedArea() finds them itself.
+  void MarkScreenAreaAsDirty(GraphicsUpdateType type, const Rect& area);
+
   // Forces a refresh of the screen the next time the graphics system
   // executes.
   virtual void ForceRefresh();
@@ -337,6 +349,14 @@ class GraphicsSystem : public EventListener {
   // Performs a full redraw of the screen.
   void Refresh(std::ostream* tree);
 
+  // Redraws the parts of the screen that changed since the last call, or the
+  // whole screen when the platform can't draw a partial frame or when most of
+  // it changed anyway.
+  void RefreshDamagedArea();
+
+  // Accounting of what RefreshDamagedArea() redrew.
+  const DamageTracker& damage_tracker() const { return damage_tracker_; }
+
   // Draws the screen (as if refresh() was called), but draw to the returned
   // surface instead of the screen.
   std::shared_ptr<Surface> RenderToSurface();
@@ -367,6 +387,20 @@ class GraphicsSystem : public EventListener {
   std::shared_ptr<const Surface> GetSurfaceNamed(
       const std::string& short_filename);
 
+  // Starts decoding |short_filename| on a background thread so that a later
+  // GetSurfaceNamed() doesn't have to wait on disk IO and decompression. Does
+  // nothing if the image is already loaded or doesn't exist.
+  void PrefetchSurface(const std::string& short_filename);
+
+  // The cache behind GetSurfaceNamed(), exposed for its budgets and stats.
+  SurfaceCache& image_cache() { return image_cache_; }
+
+  // Interpolates the objEve* style tweens of every object; handed to each
+  // TweenObjectMutator.
+  const std::shared_ptr<MutatorEngine>& mutator_engine() const {
+    return mutator_engine_;
+  }
+
   virtual std::shared_ptr<Surface> GetHaikei() = 0;
 
   virtual std::shared_ptr<Surface> GetDC(int dc) = 0;
@@ -450,7 +484,8 @@ class GraphicsSystem : public EventListener {
       const std::string& name,
       const boost::filesystem::path& file);
 
-  // We have a cache of preloaded g00 files.
+  // We have a cache of preloaded g00 files. Preloading only starts decoding
+  // the file; the Surface is created when the image is first asked for.
   void PreloadG00(int slot, const std::string& name);
   void ClearPreloadedG00(int slot);
   void ClearAllPreloadedG00();
@@ -470,7 +505,44 @@ class GraphicsSystem : public EventListener {
 
   void DrawFrame(std::ostream* tree);
 
+  // Called around the object drawing in RenderObjects() so that platforms
+  // can batch it.
+  virtual void BeginRenderingObjects() {}
+  virtual void EndRenderingObjects() {}
+
+  // Used by RefreshDamagedArea() in place of BeginFrame() and EndFrame().
+  // BeginPartialFrame() restores the previous frame, and clips drawing to
+  // |area|; it returns false when there's no previous frame to build on.
+  virtual bool BeginPartialFrame(const Rect& area) { return false; }
+  virtual void EndPartialFrame(const Rect& area) {}
+
+  // Decoder used by LoadSurfaceFromFile() implementations, which picks up the
+  // results of PrefetchSurface().
+  ImageDecoder& image_decoder() { return *image_decoder_; }
+
  private:
+  // What we knew about an object the last time RefreshDamagedArea() ran.
+  struct ObjectFootprint {
+    ObjectFootprint();
+
+    bool shown;
+    unsigned int revision;
+
+    // Whether |rect| bounds everything the object draws.
+    bool bounded;
+    Rect rect;
+  };
+
+  // Whether RenderObjects() draws the object at |obj_num|.
+  bool IsObjectShown(int obj_num, const GraphicsObject& obj);
+
+  // Damages the old and new footprints of every object (and of the text
+  // system) that changed since the last call.
+  void AddObjectDamage();
+
+  // Brings |render_order_| up to date with the foreground objects.
+  void UpdateRenderOrder();
+
   // Gets a platform appropriate surface loaded.
   virtual std::shared_ptr<const Surface> LoadSurfaceFromFile(
       const std::string& short_filename) = 0;
@@ -527,6 +599,10 @@ class GraphicsSystem : public EventListener {
   // The last time |screen_shake_queue_| was modified.
   unsigned int time_at_last_queue_change_;
 
+  // Shared with the mutators, which release their tracks when they're
+  // destroyed.
+  std::shared_ptr<MutatorEngine> mutator_engine_;
+
   // Immutable
   struct GraphicsObjectSettings;
   // Immutable global data that's constructed from the Gameexe.ini file.
@@ -573,22 +649,48 @@ class GraphicsSystem : public EventListener {
   typedef LazyArray<G00ArrayItem> G00ScriptList;
   G00ScriptList preloaded_g00_;
 
-  // LRU cache filled with the last fifteen accessed images.
+  // Cache of recently accessed images, bounded by their decoded and texture
+  // memory. Budgets come from #__IMAGE_CACHE_MB and #__TEXTURE_CACHE_MB.
   //
   // This cache's contents are assumed to be immutable.
-  LRUCache<std::string, std::shared_ptr<const Surface>> image_cache_;
+  SurfaceCache image_cache_;
+
+  // Decodes images off the main thread for PrefetchSurface().
+  std::unique_ptr<ImageDecoder> image_decoder_;
 
   // Possible background script which drives graphics to the screen.
   std::unique_ptr<HIKRenderer> hik_renderer_;
 
-  // Tuple used in RenderObjects(). Causes about a half megabyte of allocator
-  // churn per minute if we try to allocate it every time.
-  //
-  // The tuple is order, layer, depth, objid, GraphicsObject. Tuples are easy
-  // to sort.
-  typedef std::vector<std::tuple<int, int, int, int, GraphicsObject*>>
-      ToRenderVec;
-  ToRenderVec to_render_;
+  // Sort key used in RenderObjects(). The tuple is order, layer, depth,
+  // objid. Tuples are easy to sort.
+  typedef std::tuple<int, int, int, int> RenderKey;
+
+  // What |render_order_| knows about a foreground object.
+  struct RenderSlot {
+    RenderSlot();
+
+    // Whether the object is in |render_order_| under |key|.
+    bool drawn;
+    unsigned int revision;
+    RenderKey key;
+  };
+
+  // Indexed by foreground object number.
+  std::vector<RenderSlot> render_slots_;
+
+  // Keys of every foreground object with something to draw, kept sorted.
+  // Objects almost never change order between frames, so we only move the
+  // entries of objects whose revision() changed instead of sorting again.
+  std::vector<RenderKey> render_order_;
+
+  // Screen area changed since the last RefreshDamagedArea(). The share of the
+  // screen past which we redraw everything comes from
+  // #__PARTIAL_REDRAW_PERCENT.
+  DamageTracker damage_tracker_;
+
+  // Indexed by foreground object number.
+  std::vector<ObjectFootprint> object_footprints_;
+  Rect text_footprint_;
 
   // boost::serialization support
   friend class boost::serialization::access;
@@ -61,8 +61,9 @@ void GraphicsTextObject::UpdateSurface(const GraphicsObject& rp) {
   cached_utf8_str_ = rp.GetTextText();
 
   // Get the correct colour
+  static GameexeIndexedKey color_table("COLOR_TABLE");
   Gameexe& gexe = system_.gameexe();
-  std::vector<int> vec = gexe("COLOR_TABLE", rp.GetTextColour());
+  std::vector<int> vec = color_table(gexe, rp.GetTextColour());
   cached_text_colour_ = rp.GetTextColour();
   RGBColour colour(vec.at(0), vec.at(1), vec.at(2));
 
@@ -70,7 +71,7 @@ void GraphicsTextObject::UpdateSurface(const GraphicsObject& rp) {
   RGBColour shadow_impl;
   cached_shadow_colour_ = rp.GetTextShadowColour();
   if (rp.GetTextShadowColour() != -1) {
-    vec = gexe("COLOR_TABLE", rp.GetTextShadowColour());
+    vec = color_table(gexe, rp.GetTextShadowColour()).ToIntVector();
     shadow_impl = RGBColour(vec.at(0), vec.at(1), vec.at(2));
     shadow = &shadow_impl;
   }
@@ -0,0 +1,325 @@
+// -*- Mode: C++; tab-width:2; indent-tabs-mode: nil; c-basic-offset: 2 -*-
+// vi:tw=80:et:ts=2:sts=2
+//
+// -----------------------------------------------------------------------
+//
+// This file is part of RLVM, a RealLive virtual machine clone.
+//
+// -----------------------------------------------------------------------
+//
+// Copyright (C) 2015 Elliot Glaysher
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA.
+// -----------------------------------------------------------------------
+
+#include "systems/base/image_decoder.h"
+
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstdlib>
+#include <iterator>
+#include <new>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "libreallive/filemap.h"
+#include "systems/base/system_error.h"
+#include "utilities/exception.h"
+#include "xclannad/file.h"
+
+namespace {
+
+// Upper bound on the number of decoding threads.
+const unsigned int kMaxWorkers = 4;
+
+// xclannad's LZ decompressors can write a little past the end of the image
+// on their fast path.
+const size_t kPixelSlack = 1024;
+
+// xclannad's readers fetch whole ints and can read a few bytes past the end
+// of the file, for example for the last 3-byte pixel of a type 0 g00.
+const size_t kReadSlack = 8;
+
+// Whether the bytes just past the end of |file| can be read. A mapping covers
+// whole pages and the rest of its last page reads as zeros, so this only
+// fails when the file ends at (or just before) a page boundary.
+bool HasReadSlack(const libreallive::Mapping& file) {
+  if (!file.is_mapped())
+    return false;
+
+  static const size_t page_size = sysconf(_SC_PAGESIZE);
+  size_t used = file.size() % page_size;
+  return used != 0 && page_size - used >= kReadSlack;
+}
+
+Surface::GrpRect XclannadRegionToGrpRect(const GRPCONV::REGION& region) {
+  Surface::GrpRect rect;
+  rect.rect =
+      Rect(Point(region.x1, region.y1), Point(region.x2 + 1, region.y2 + 1));
+  rect.originX = region.origin_x;
+  rect.originY = region.origin_y;
+  return rect;
+}
+
+// Whether any of the |count| pixels isn't fully opaque.
+bool HasTransparentPixel(const char* pixels, int count) {
+  const unsigned int* d = reinterpret_cast<const unsigned int*>(pixels);
+  for (int i = 0; i < count; i++) {
+    if ((d[i] & 0xff000000) != 0xff000000)
+      return true;
+  }
+  return false;
+}
+
+}  // namespace
+
+// -----------------------------------------------------------------------
+// DecodedImage
+// -----------------------------------------------------------------------
+
+void DecodedImage::FreePixels::operator()(char* pixels) const { free(pixels); }
+
+DecodedImage::DecodedImage() : width(0), height(0), has_alpha(false) {}
+
+DecodedImage::~DecodedImage() {}
+
+// -----------------------------------------------------------------------
+// G00PatternDecoder
+// -----------------------------------------------------------------------
+
+G00PatternDecoder::G00PatternDecoder(const char* data, size_t size)
+    : data_(data, data + size), pattern_count_(0) {
+  data_.resize(size + kReadSlack);
+  conv_.reset(GRPCONV::AssignConverter(data_.data(), size, "???"));
+  if (!conv_ || !conv_->CanReadRegion())
+    throw SystemError("Not a type 2 g00 file.");
+  pattern_count_ = conv_->region_table.size();
+}
+
+G00PatternDecoder::~G00PatternDecoder() {}
+
+// static
+bool G00PatternDecoder::CanDecode(GRPCONV& conv) {
+  if (!conv.CanReadRegion() || conv.region_table.size() < 2)
+    return false;
+
+  std::vector<Rect> rects;
+  for (const GRPCONV::REGION& region : conv.region_table)
+    rects.push_back(XclannadRegionToGrpRect(region).rect);
+  for (size_t i = 0; i < rects.size(); ++i) {
+    for (size_t j = i + 1; j < rects.size(); ++j) {
+      // Rect::Intersects() also counts rects which only touch.
+      if (rects[i].x() < rects[j].x2() && rects[j].x() < rects[i].x2() &&
+          rects[i].y() < rects[j].y2() && rects[j].y() < rects[i].y2())
+        return false;
+    }
+  }
+
+  return true;
+}
+
+DecodedImage::PixelBuffer G00PatternDecoder::DecodePattern(int index,
+                                                           int* width,
+                                                           int* height,
+                                                           bool* has_alpha) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (index < 0 || index >= pattern_count_)
+    throw SystemError("Invalid g00 pattern.");
+
+  Rect rect = XclannadRegionToGrpRect(conv_->region_table[index]).rect;
+  DecodedImage::PixelBuffer mem(static_cast<char*>(
+      malloc(size_t(rect.width()) * rect.height() * 4 + kPixelSlack)));
+  if (!mem)
+    throw std::bad_alloc();
+
+  if (!conv_->ReadRegion(index, mem.get()))
+    throw SystemError("Failure in GRPCONV.");
+
+  *width = rect.width();
+  *height = rect.height();
+  *has_alpha = conv_->IsMask() &&
+               HasTransparentPixel(mem.get(), rect.width() * rect.height());
+  return mem;
+}
+
+// -----------------------------------------------------------------------
+// ImageDecoder
+// -----------------------------------------------------------------------
+
+ImageDecoder::ImageDecoder() : shutdown_(false) {}
+
+ImageDecoder::~ImageDecoder() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    shutdown_ = true;
+  }
+  wakeup_.notify_all();
+
+  for (std::thread& worker : workers_)
+    worker.join();
+}
+
+ImageDecoder::Future ImageDecoder::DecodeAsync(
+    const boost::filesystem::path& path) {
+  std::lock_guard<std::mutex> lock(mutex_);
+
+  std::map<std::string, Future>::iterator it = pending_.find(path.string());
+  if (it != pending_.end())
+    return it->second;
+
+  Task task([path] { return DecodeFile(path); });
+  Future future = task.get_future().share();
+  queue_.push_back(std::move(task));
+
+  pending_.emplace(path.string(), future);
+  pending_order_.push_back(path.string());
+  if (pending_order_.size() > kMaxPendingDecodes) {
+    pending_.erase(pending_order_.front());
+    pending_order_.pop_front();
+  }
+
+  if (workers_.empty())
+    StartWorkers();
+  wakeup_.notify_one();
+
+  return future;
+}
+
+std::shared_ptr<DecodedImage> ImageDecoder::Decode(
+    const boost::filesystem::path& path) {
+  Future future;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::map<std::string, Future>::iterator it = pending_.find(path.string());
+    if (it != pending_.end()) {
+      future = it->second;
+      pending_.erase(it);
+      pending_order_.erase(std::find(
+          pending_order_.begin(), pending_order_.end(), path.string()));
+    }
+  }
+
+  if (future.valid())
+    return future.get();
+
+  return DecodeFile(path);
+}
+
+bool ImageDecoder::HasPendingDecode(const boost::filesystem::path& path) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return pending_.find(path.string()) != pending_.end();
+}
+
+// static
+std::shared_ptr<DecodedImage> ImageDecoder::DecodeFile(
+    const boost::filesystem::path& path) {
+  std::unique_ptr<libreallive::Mapping> file;
+  try {
+    file.reset(new libreallive::Mapping(path.string(), libreallive::Read));
+  } catch (libreallive::Error&) {
+    std::ostringstream oss;
+    oss << "Could not open file: " << path;
+    throw rlvm::Exception(oss.str());
+  }
+
+  // Decode straight from the mapping unless the converter could read off
+  // the end of it.
+  const char* data = file->get();
+  std::vector<char> padded;
+  if (!HasReadSlack(*file)) {
+    padded.assign(data, data + file->size());
+    padded.resize(file->size() + kReadSlack);
+    data = padded.data();
+  }
+
+  // Glue code to allow my stuff to work with Jagarl's loader
+  std::unique_ptr<GRPCONV> conv(
+      GRPCONV::AssignConverter(data, file->size(), "???"));
+  if (conv == 0) {
+    throw SystemError("Failure in GRPCONV.");
+  }
+
+  std::shared_ptr<DecodedImage> image(new DecodedImage);
+  image->width = conv->Width();
+  image->height = conv->Height();
+
+  if (G00PatternDecoder::CanDecode(*conv)) {
+    image->patterns.reset(new G00PatternDecoder(data, file->size()));
+    std::transform(conv->region_table.begin(),
+                   conv->region_table.end(),
+                   std::back_inserter(image->region_table),
+                   XclannadRegionToGrpRect);
+    return image;
+  }
+
+  DecodedImage::PixelBuffer mem(static_cast<char*>(
+      malloc(size_t(conv->Width()) * conv->Height() * 4 + kPixelSlack)));
+  if (!mem)
+    throw std::bad_alloc();
+
+  if (conv->Read(mem.get())) {
+    if (conv->IsMask()) {
+      image->has_alpha =
+          HasTransparentPixel(mem.get(), conv->Width() * conv->Height());
+    }
+
+    image->pixels = std::move(mem);
+  }
+
+  // Grab the Type-2 information out of the converter or create one
+  // default region if none exist
+  if (conv->region_table.size()) {
+    std::transform(conv->region_table.begin(),
+                   conv->region_table.end(),
+                   std::back_inserter(image->region_table),
+                   XclannadRegionToGrpRect);
+  } else {
+    Surface::GrpRect rect;
+    rect.rect = Rect(Point(0, 0), Size(conv->Width(), conv->Height()));
+    rect.originX = 0;
+    rect.originY = 0;
+    image->region_table.push_back(rect);
+  }
+
+  return image;
+}
+
+void ImageDecoder::StartWorkers() {
+  unsigned int count = std::thread::hardware_concurrency();
+  count = std::max(1u, std::min(kMaxWorkers, count > 1 ? count - 1 : 1));
+  for (unsigned int i = 0; i < count; ++i)
+    workers_.emplace_back(&ImageDecoder::WorkerLoop, this);
+}
+
+void ImageDecoder::WorkerLoop() {
+  while (true) {
+    Task task;
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      wakeup_.wait(lock, [&] { return shutdown_ || !queue_.empty(); });
+      if (shutdown_)
+        return;
+
+      task = std::move(queue_.front());
+      queue_.pop_front();
+    }
+
+    // Exceptions thrown by DecodeFile() end up in the task's future.
+    task();
+  }
+}
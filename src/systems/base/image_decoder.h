@@ -0,0 +1,171 @@
+// -*- Mode: C++; tab-width:2; indent-tabs-mode: nil; c-basic-offset: 2 -*-
+// vi:tw=80:et:ts=2:sts=2
+//
+// -----------------------------------------------------------------------
+//
+// This file is part of RLVM, a RealLive virtual machine clone.
+//
+// -----------------------------------------------------------------------
+//
+// Copyright (C) 2015 Elliot Glaysher
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA.
+// -----------------------------------------------------------------------
+
+#ifndef SRC_SYSTEMS_BASE_IMAGE_DECODER_H_
+#define SRC_SYSTEMS_BASE_IMAGE_DECODER_H_
+
+#include <boost/filesystem/path.hpp>
+
+#include <condition_variable>
+#include <deque>
+#include <future>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "systems/base/surface.h"
+
+class G00PatternDecoder;
+class GRPCONV;
+
+// An image file decoded into memory, but not yet turned into a platform
+// Surface.
+struct DecodedImage {
+  // Releases a pixel buffer with free(). The buffer is malloc()ed so that a
+  // platform can adopt it as its surface memory instead of copying it.
+  struct FreePixels {
+    void operator()(char* pixels) const;
+  };
+  typedef std::unique_ptr<char, FreePixels> PixelBuffer;
+
+  DecodedImage();
+  ~DecodedImage();
+
+  int width;
+  int height;
+
+  // width * height 32-bit pixels in the layout GRPCONV produces. NULL if the
+  // converter recognized the file but couldn't read its pixel data, or if the
+  // buffer has been taken by whoever called Decode().
+  PixelBuffer pixels;
+
+  // Whether any pixel in |pixels| isn't fully opaque.
+  bool has_alpha;
+
+  // The type 2 g00 region table. Images without one get a single region
+  // covering the whole image.
+  std::vector<Surface::GrpRect> region_table;
+
+  // Set instead of |pixels| for type 2 g00 files whose patterns don't
+  // overlap. Each entry of |region_table| is then decoded on its own, the
+  // first time someone asks for it.
+  std::shared_ptr<G00PatternDecoder> patterns;
+};
+
+// Decodes the patterns of a type 2 g00 file one at a time into images the
+// size of the pattern, rather than drawing them all onto a canvas the size of
+// the whole file. The region table is read when the file is opened, but the
+// pixel data is only decompressed as far as the patterns asked for so far
+// need. Keeps its own copy of the (compressed) file.
+class G00PatternDecoder {
+ public:
+  G00PatternDecoder(const char* data, size_t size);
+  ~G00PatternDecoder();
+
+  // Whether |conv| is a type 2 g00 that is worth decoding a pattern at a
+  // time: it has more than one pattern and none of them overlap, so drawing
+  // them separately looks the same as drawing them onto one canvas.
+  static bool CanDecode(GRPCONV& conv);
+
+  int pattern_count() const { return pattern_count_; }
+
+  // Decodes pattern |index| into a buffer of width * height 32-bit pixels,
+  // where the size is that of the pattern's rect. Sets |has_alpha| like
+  // DecodedImage::has_alpha. Throws on errors. Thread safe.
+  DecodedImage::PixelBuffer DecodePattern(int index,
+                                          int* width,
+                                          int* height,
+                                          bool* has_alpha);
+
+ private:
+  std::mutex mutex_;
+
+  std::vector<char> data_;
+  std::unique_ptr<GRPCONV> conv_;
+  int pattern_count_;
+};
+
+// Decodes g00/pdt files into DecodedImages. Decode() works synchronously on
+// the calling thread, while DecodeAsync() hands the file to a small pool of
+// worker threads so that disk IO and decompression happen before the image is
+// needed; a later Decode() of the same file picks up that result (waiting for
+// it if it isn't done yet) instead of decoding it again.
+class ImageDecoder {
+ public:
+  typedef std::shared_future<std::shared_ptr<DecodedImage>> Future;
+
+  ImageDecoder();
+  ~ImageDecoder();
+
+  // Queues |path| for decoding on a worker thread. Errors are reported
+  // through the returned future.
+  Future DecodeAsync(const boost::filesystem::path& path);
+
+  // Returns the decoded contents of |path|, using the result of an earlier
+  // DecodeAsync() call if there is one. The caller may move |pixels| out of
+  // the result. Throws on errors.
+  std::shared_ptr<DecodedImage> Decode(
+      const boost::filesystem::path& path);
+
+  // Whether there's a DecodeAsync() result for |path| that hasn't been picked
+  // up by Decode().
+  bool HasPendingDecode(const boost::filesystem::path& path);
+
+  // Does the actual work of reading and decoding |path|. The file is mapped
+  // into memory and decoded from there rather than read into a buffer
+  // first. Thread safe.
+  static std::shared_ptr<DecodedImage> DecodeFile(
+      const boost::filesystem::path& path);
+
+  // Maximum number of results kept around waiting for a Decode(). Prefetched
+  // images which are never asked for are dropped oldest first.
+  static const size_t kMaxPendingDecodes = 16;
+
+ private:
+  typedef std::packaged_task<std::shared_ptr<DecodedImage>()> Task;
+
+  void StartWorkers();
+  void WorkerLoop();
+
+  std::mutex mutex_;
+  std::condition_variable wakeup_;
+
+  // Work not yet picked up by a worker.
+  std::deque<Task> queue_;
+
+  // DecodeAsync() results which haven't been claimed by Decode(), and the
+  // order they were queued in.
+  std::map<std::string, Future> pending_;
+  std::deque<std::string> pending_order_;
+
+  std::vector<std::thread> workers_;
+  bool shutdown_;
+};
+
+#endif  // SRC_SYSTEMS_BASE_IMAGE_DECODER_H_
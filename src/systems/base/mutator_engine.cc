@@ -0,0 +1,125 @@
+// -*- Mode: C++; tab-width:2; indent-tabs-mode: nil; c-basic-offset: 2 -*-
+// vi:tw=80:et:ts=2:sts=2
+//
+// -----------------------------------------------------------------------
+//
+// This file is part of RLVM, a RealLive virtual machine clone.
+//
+// -----------------------------------------------------------------------
+//
+// Copyright (C) 2015 Elliot Glaysher
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA.
+// -----------------------------------------------------------------------
+
+
+#include "systems/base/mutator_engine.h"
+
+#include <cmath>
+
+#include "utilities/exception.h"
+
+MutatorEngine::MutatorEngine()
+    : evaluated_(false), in_frame_(false), ticks_(0) {}
+
+MutatorEngine::~MutatorEngine() {}
+
+int MutatorEngine::Add(unsigned int begin,
+                       int duration,
+                       int start,
+                       int end,
+                       int type) {
+  int track;
+  if (free_.empty()) {
+    track = begin_.size();
+    begin_.push_back(0);
+    duration_.push_back(0);
+    start_.push_back(0);
+    end_.push_back(0);
+    type_.push_back(0);
+    value_.push_back(0);
+    live_.push_back(0);
+    progress_.push_back(0.0);
+  } else {
+    track = free_.back();
+    free_.pop_back();
+  }
+
+  begin_[track] = begin;
+  duration_[track] = duration;
+  start_[track] = start;
+  end_[track] = end;
+  type_[track] = type;
+  value_[track] = start;
+  live_[track] = 1;
+
+  evaluated_ = false;
+  return track;
+}
+
+void MutatorEngine::Release(int track) {
+  live_[track] = 0;
+  free_.push_back(track);
+}
+
+void MutatorEngine::Evaluate(unsigned int ticks) {
+  size_t count = begin_.size();
+  double now = ticks;
+
+  // Progress through each track, with no branches so that it vectorizes.
+  // Tracks that haven't started or have already finished get nonsense here
+  // and are sorted out below.
+  for (size_t i = 0; i < count; ++i)
+    progress_[i] = (now - begin_[i]) / duration_[i];
+
+  for (size_t i = 0; i < count; ++i) {
+    if (!live_[i])
+      continue;
+
+    // The same comparisons, and the same arithmetic, as
+    // ObjectMutator::GetValueForTime() and InterpolateBetween().
+    if (ticks < begin_[i]) {
+      value_[i] = start_[i];
+    } else if (ticks < begin_[i] + duration_[i]) {
+      double percentage = progress_[i];
+      int amount = end_[i] - start_[i];
+      int offset;
+      if (type_[i] == 0) {
+        offset = percentage * amount;
+      } else if (type_[i] == 1) {
+        double log_percentage = std::log(percentage + 1) / std::log(2);
+        offset = amount - ((1 - log_percentage) * amount);
+      } else if (type_[i] == 2) {
+        double log_percentage = std::log(percentage + 1) / std::log(2);
+        offset = log_percentage * amount;
+      } else {
+        throw rlvm::Exception("Invalid mod in Interpolate");
+      }
+      value_[i] = start_[i] + offset;
+    } else {
+      value_[i] = end_[i];
+    }
+  }
+
+  evaluated_ = true;
+  ticks_ = ticks;
+}
+
+void MutatorEngine::BeginFrame(unsigned int ticks) {
+  Evaluate(ticks);
+  in_frame_ = true;
+}
+
+void MutatorEngine::EndFrame() { in_frame_ = false; }
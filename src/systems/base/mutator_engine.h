@@ -0,0 +1,97 @@
+// -*- Mode: C++; tab-width:2; indent-tabs-mode: nil; c-basic-offset: 2 -*-
+// vi:tw=80:et:ts=2:sts=2
+//
+// -----------------------------------------------------------------------
+//
+// This file is part of RLVM, a RealLive virtual machine clone.
+//
+// -----------------------------------------------------------------------
+//
+// Copyright (C) 2015 Elliot Glaysher
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA.
+// -----------------------------------------------------------------------
+
+
+#ifndef SRC_SYSTEMS_BASE_MUTATOR_ENGINE_H_
+#define SRC_SYSTEMS_BASE_MUTATOR_ENGINE_H_
+
+#include <cstdint>
+#include <vector>
+
+// Interpolates the values of every running object tween at once. Each tween
+// is a track: a value going from a start to an end over a duration. Tracks
+// are kept as parallel arrays, and Evaluate() updates all of them in one
+// pass per frame, instead of each ObjectMutator reading the clock and
+// interpolating on its own.
+class MutatorEngine {
+ public:
+  MutatorEngine();
+  ~MutatorEngine();
+
+  // Adds a track going from |start| to |end| over |duration| milliseconds,
+  // starting at |begin|, with interpolation |type| (see Interpolate()).
+  // Returns the track's index, which is valid until Release().
+  int Add(unsigned int begin, int duration, int start, int end, int type);
+
+  void Release(int track);
+
+  // Computes the value of every live track at |ticks|.
+  void Evaluate(unsigned int ticks);
+
+  // Whether the last Evaluate() was at |ticks| and no track was added since.
+  bool IsEvaluatedAt(unsigned int ticks) const {
+    return evaluated_ && ticks_ == ticks;
+  }
+
+  // Evaluates every track at |ticks| and has mutators treat |ticks| as the
+  // current time until EndFrame(), so that every object animates to the same
+  // moment however long the frame takes.
+  void BeginFrame(unsigned int ticks);
+  void EndFrame();
+
+  bool in_frame() const { return in_frame_; }
+
+  // The time of the last Evaluate().
+  unsigned int ticks() const { return ticks_; }
+
+  // The value of |track| as of the last Evaluate().
+  int value(int track) const { return value_[track]; }
+
+  // Number of tracks that haven't been released.
+  int live_count() const { return int(begin_.size() - free_.size()); }
+
+ private:
+  // Indexed by track.
+  std::vector<unsigned int> begin_;
+  std::vector<int> duration_;
+  std::vector<int> start_;
+  std::vector<int> end_;
+  std::vector<int> type_;
+  std::vector<int> value_;
+  std::vector<uint8_t> live_;
+
+  // How far into its duration each track is. Scratch space for Evaluate().
+  std::vector<double> progress_;
+
+  // Released tracks available for reuse.
+  std::vector<int> free_;
+
+  bool evaluated_;
+  bool in_frame_;
+  unsigned int ticks_;
+};
+
+#endif  // SRC_SYSTEMS_BASE_MUTATOR_ENGINE_H_
@@ -31,6 +31,7 @@
 #include "systems/base/graphics_object.h"
 #include "systems/base/graphics_object_data.h"
 #include "systems/base/graphics_system.h"
+#include "systems/base/mutator_engine.h"
 #include "systems/base/parent_graphics_object_data.h"
 #include "systems/base/system.h"
 #include "utilities/math_util.h"
@@ -84,18 +85,80 @@ int ObjectMutator::GetValueForTime(RLMachine& machine, int start, int end) {
 
 // -----------------------------------------------------------------------
 
-OneIntObjectMutator::OneIntObjectMutator(const std::string& name,
-                                         int creation_time,
-                                         int duration_time,
-                                         int delay,
-                                         int type,
-                                         int start_value,
-                                         int target_value,
-                                         Setter setter)
-    : ObjectMutator(-1, name, creation_time, duration_time, delay, type),
-      startval_(start_value),
+TweenObjectMutator::TweenObjectMutator(
+    const std::shared_ptr<MutatorEngine>& engine,
+    int repr,
+    const std::string& name,
+    int creation_time,
+    int duration_time,
+    int delay,
+    int type)
+    : ObjectMutator(repr, name, creation_time, duration_time, delay, type),
+      engine_(engine) {}
+
+TweenObjectMutator::TweenObjectMutator(const TweenObjectMutator& rhs)
+    : ObjectMutator(rhs), engine_(rhs.engine_) {
+  for (const std::pair<int, int>& range : rhs.ranges_)
+    AddTrack(range.first, range.second);
+}
+
+TweenObjectMutator::~TweenObjectMutator() {
+  for (int track : tracks_)
+    engine_->Release(track);
+}
+
+bool TweenObjectMutator::operator()(RLMachine& machine,
+                                    GraphicsObject& object) {
+  // The GraphicsSystem evaluates the engine before running the objects each
+  // frame. Mutators run some other way evaluate it themselves.
+  unsigned int ticks = engine_->in_frame()
+                           ? engine_->ticks()
+                           : machine.system().event().GetTicks();
+  if (!engine_->IsEvaluatedAt(ticks))
+    engine_->Evaluate(ticks);
+
+  unsigned int start = creation_time() + delay();
+  if (ticks > start) {
+    PerformSetting(machine, object);
+    machine.system().graphics().mark_object_state_as_dirty();
+  }
+  return ticks > start + duration_time();
+}
+
+int TweenObjectMutator::AddTrack(int start, int end) {
+  tracks_.push_back(engine_->Add(
+      creation_time() + delay(), duration_time(), start, end, type()));
+  ranges_.emplace_back(start, end);
+  return tracks_.size() - 1;
+}
+
+int TweenObjectMutator::value(int index) const {
+  return engine_->value(tracks_[index]);
+}
+
+// -----------------------------------------------------------------------
+
+OneIntObjectMutator::OneIntObjectMutator(
+    const std::shared_ptr<MutatorEngine>& engine,
+    const std::string& name,
+    int creation_time,
+    int duration_time,
+    int delay,
+    int type,
+    int start_value,
+    int target_value,
+    Setter setter)
+    : TweenObjectMutator(engine,
+                         -1,
+                         name,
+                         creation_time,
+                         duration_time,
+                         delay,
+                         type),
       endval_(target_value),
-      setter_(setter) {}
+      setter_(setter) {
+  AddTrack(start_value, target_value);
+}
 
 OneIntObjectMutator::~OneIntObjectMutator() {}
 
@@ -112,26 +175,34 @@ ObjectMutator* OneIntObjectMutator::Clone() const {
 
 void OneIntObjectMutator::PerformSetting(RLMachine& machine,
                                          GraphicsObject& object) {
-  int value = GetValueForTime(machine, startval_, endval_);
-  (object.*setter_)(value);
+  (object.*setter_)(value(0));
 }
 
 // -----------------------------------------------------------------------
 
-RepnoIntObjectMutator::RepnoIntObjectMutator(const std::string& name,
-                                             int creation_time,
-                                             int duration_time,
-                                             int delay,
-                                             int type,
-                                             int repno,
-                                             int start_value,
-                                             int target_value,
-                                             Setter setter)
-    : ObjectMutator(repno, name, creation_time, duration_time, delay, type),
+RepnoIntObjectMutator::RepnoIntObjectMutator(
+    const std::shared_ptr<MutatorEngine>& engine,
+    const std::string& name,
+    int creation_time,
+    int duration_time,
+    int delay,
+    int type,
+    int repno,
+    int start_value,
+    int target_value,
+    Setter setter)
+    : TweenObjectMutator(engine,
+                         repno,
+                         name,
+                         creation_time,
+                         duration_time,
+                         delay,
+                         type),
       repno_(repno),
-      startval_(start_value),
       endval_(target_value),
-      setter_(setter) {}
+      setter_(setter) {
+  AddTrack(start_value, target_value);
+}
 
 RepnoIntObjectMutator::~RepnoIntObjectMutator() {}
 
@@ -149,30 +220,38 @@ ObjectMutator* RepnoIntObjectMutator::Clone() const {
 
 void RepnoIntObjectMutator::PerformSetting(RLMachine& machine,
                                            GraphicsObject& object) {
-  int value = GetValueForTime(machine, startval_, endval_);
-  (object.*setter_)(repno_, value);
+  (object.*setter_)(repno_, value(0));
 }
 
 // -----------------------------------------------------------------------
 
-TwoIntObjectMutator::TwoIntObjectMutator(const std::string& name,
-                                         int creation_time,
-                                         int duration_time,
-                                         int delay,
-                                         int type,
-                                         int start_one,
-                                         int target_one,
-                                         Setter setter_one,
-                                         int start_two,
-                                         int target_two,
-                                         Setter setter_two)
-    : ObjectMutator(-1, name, creation_time, duration_time, delay, type),
-      startval_one_(start_one),
+TwoIntObjectMutator::TwoIntObjectMutator(
+    const std::shared_ptr<MutatorEngine>& engine,
+    const std::string& name,
+    int creation_time,
+    int duration_time,
+    int delay,
+    int type,
+    int start_one,
+    int target_one,
+    Setter setter_one,
+    int start_two,
+    int target_two,
+    Setter setter_two)
+    : TweenObjectMutator(engine,
+                         -1,
+                         name,
+                         creation_time,
+                         duration_time,
+                         delay,
+                         type),
       endval_one_(target_one),
       setter_one_(setter_one),
-      startval_two_(start_two),
       endval_two_(target_two),
-      setter_two_(setter_two) {}
+      setter_two_(setter_two) {
+  AddTrack(start_one, target_one);
+  AddTrack(start_two, target_two);
+}
 
 TwoIntObjectMutator::~TwoIntObjectMutator() {}
 
@@ -190,9 +269,6 @@ ObjectMutator* TwoIntObjectMutator::Clone() const {
 
 void TwoIntObjectMutator::PerformSetting(RLMachine& machine,
                                          GraphicsObject& object) {
-  int value = GetValueForTime(machine, startval_one_, endval_one_);
-  (object.*setter_one_)(value);
-
-  value = GetValueForTime(machine, startval_two_, endval_two_);
-  (object.*setter_two_)(value);
+  (object.*setter_one_)(value(0));
+  (object.*setter_two_)(value(1));
 }
@@ -27,9 +27,13 @@
 #ifndef SRC_SYSTEMS_BASE_OBJECT_MUTATOR_H_
 #define SRC_SYSTEMS_BASE_OBJECT_MUTATOR_H_
 
+#include <memory>
 #include <string>
+#include <utility>
+#include <vector>
 
 class GraphicsObject;
+class MutatorEngine;
 class RLMachine;
 
 // An object that changes the value of an object parameter over time.
@@ -68,6 +72,11 @@ class ObjectMutator {
   // Template method that actually sets the values.
   virtual void PerformSetting(RLMachine& machine, GraphicsObject& object) = 0;
 
+  int creation_time() const { return creation_time_; }
+  int duration_time() const { return duration_time_; }
+  int delay() const { return delay_; }
+  int type() const { return type_; }
+
  private:
   // An optional paramater to identify object setters that pass additional
   // arguments.
@@ -91,12 +100,56 @@ class ObjectMutator {
 
 // -----------------------------------------------------------------------
 
+// An object mutator whose values are tracks in a MutatorEngine, so they're
+// interpolated together with every other running tween in one pass per
+// frame. Subclasses add a track per value in their constructor and write the
+// interpolated values to the object in PerformSetting().
+class TweenObjectMutator : public ObjectMutator {
+ public:
+  virtual ~TweenObjectMutator();
+
+  virtual bool operator()(RLMachine& machine, GraphicsObject& object) override;
+
+ protected:
+  TweenObjectMutator(const std::shared_ptr<MutatorEngine>& engine,
+                     int repr,
+                     const std::string& name,
+                     int creation_time,
+                     int duration_time,
+                     int delay,
+                     int type);
+
+  // Copies get tracks of their own.
+  TweenObjectMutator(const TweenObjectMutator& rhs);
+
+  // Adds a track going from |start| to |end|. Returns the index to pass to
+  // value().
+  int AddTrack(int start, int end);
+
+  // The value of the |index|th track at the current time.
+  int value(int index) const;
+
+ private:
+  TweenObjectMutator& operator=(const TweenObjectMutator&) = delete;
+
+  std::shared_ptr<MutatorEngine> engine_;
+
+  // Our tracks in |engine_|, in the order they were added.
+  std::vector<int> tracks_;
+
+  // The start and end of each track, for copying.
+  std::vector<std::pair<int, int>> ranges_;
+};
+
+// -----------------------------------------------------------------------
+
 // An object mutator that takes a single integer.
-class OneIntObjectMutator : public ObjectMutator {
+class OneIntObjectMutator : public TweenObjectMutator {
  public:
   typedef void (GraphicsObject::*Setter)(const int);
 
-  OneIntObjectMutator(const std::string& name,
+  OneIntObjectMutator(const std::shared_ptr<MutatorEngine>& engine,
+                      const std::string& name,
                       int creation_time,
                       int duration_time,
                       int delay,
@@ -114,7 +167,6 @@ class OneIntObjectMutator : public ObjectMutator {
   virtual void PerformSetting(RLMachine& machine,
                               GraphicsObject& object) override;
 
-  int startval_;
   int endval_;
   Setter setter_;
 };
@@ -122,11 +174,12 @@ class OneIntObjectMutator : public ObjectMutator {
 // -----------------------------------------------------------------------
 
 // An object mutator that takes a repno and an integer.
-class RepnoIntObjectMutator : public ObjectMutator {
+class RepnoIntObjectMutator : public TweenObjectMutator {
  public:
   typedef void (GraphicsObject::*Setter)(const int, const int);
 
-  RepnoIntObjectMutator(const std::string& name,
+  RepnoIntObjectMutator(const std::shared_ptr<MutatorEngine>& engine,
+                        const std::string& name,
                         int creation_time,
                         int duration_time,
                         int delay,
@@ -146,7 +199,6 @@ class RepnoIntObjectMutator : public ObjectMutator {
                               GraphicsObject& object) override;
 
   int repno_;
-  int startval_;
   int endval_;
   Setter setter_;
 };
@@ -154,11 +206,12 @@ class RepnoIntObjectMutator : public ObjectMutator {
 // -----------------------------------------------------------------------
 
 // An object mutator that varies two integers.
-class TwoIntObjectMutator : public ObjectMutator {
+class TwoIntObjectMutator : public TweenObjectMutator {
  public:
   typedef void (GraphicsObject::*Setter)(const int);
 
-  TwoIntObjectMutator(const std::string& name,
+  TwoIntObjectMutator(const std::shared_ptr<MutatorEngine>& engine,
+                      const std::string& name,
                       int creation_time,
                       int duration_time,
                       int delay,
@@ -179,11 +232,9 @@ class TwoIntObjectMutator : public ObjectMutator {
   virtual void PerformSetting(RLMachine& machine,
                               GraphicsObject& object) override;
 
-  int startval_one_;
   int endval_one_;
   Setter setter_one_;
 
-  int startval_two_;
   int endval_two_;
   Setter setter_two_;
 };
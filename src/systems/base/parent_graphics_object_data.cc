@@ -97,6 +97,12 @@ void ParentGraphicsObjectData::PlaySet(int set) {
   // Deliberately empty.
 }
 
+bool ParentGraphicsObjectData::GetScreenFootprint(const GraphicsObject& go,
+                                                  Rect* footprint) {
+  // Children can be scattered anywhere relative to us.
+  return false;
+}
+
 std::shared_ptr<const Surface> ParentGraphicsObjectData::CurrentSurface(
     const GraphicsObject& rp) {
   return std::shared_ptr<const Surface>();
@@ -57,6 +57,8 @@ class ParentGraphicsObjectData : public GraphicsObjectData {
   virtual void Execute(RLMachine& machine) override;
   virtual bool IsAnimation() const override;
   virtual void PlaySet(int set) override;
+  virtual bool GetScreenFootprint(const GraphicsObject& go,
+                                  Rect* footprint) override;
 
   virtual bool IsParentLayer() const override { return true; }
 
@@ -0,0 +1,162 @@
+// -*- Mode: C++; tab-width:2; indent-tabs-mode: nil; c-basic-offset: 2 -*-
+// vi:tw=80:et:ts=2:sts=2
+//
+// -----------------------------------------------------------------------
+//
+// This file is part of RLVM, a RealLive virtual machine clone.
+//
+// -----------------------------------------------------------------------
+//
+// Copyright (C) 2015 Elliot Glaysher
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA.
+// -----------------------------------------------------------------------
+
+
+#include "systems/base/rect_packer.h"
+
+#include <algorithm>
+
+RectPacker::RectPacker(const Size& size)
+    : size_(size), live_count_(0), used_area_(0) {}
+
+RectPacker::~RectPacker() {}
+
+bool RectPacker::Allocate(const Size& size, Rect* out) {
+  if (size.width() <= 0 || size.height() <= 0 ||
+      size.width() > size_.width() || size.height() > size_.height())
+    return false;
+
+  // Try the existing shelves tall enough for this rectangle, least wasted
+  // height first.
+  std::vector<Shelf*> candidates;
+  for (Shelf& shelf : shelves_) {
+    if (shelf.height >= size.height())
+      candidates.push_back(&shelf);
+  }
+  std::stable_sort(candidates.begin(),
+                   candidates.end(),
+                   [](const Shelf* lhs, const Shelf* rhs) {
+    return lhs->height < rhs->height;
+  });
+
+  int top = shelves_.empty() ? 0 : shelves_.back().y + shelves_.back().height;
+  bool can_open_shelf = top + size.height() <= size_.height();
+
+  for (Shelf* shelf : candidates) {
+    // Don't let short images claim space on a much taller shelf while there
+    // is still room to open a new one; that wastes the rest of the strip.
+    // Once the page is full, any shelf will do.
+    if (can_open_shelf && shelf->height > size.height() * 2)
+      continue;
+
+    if (AllocateOnShelf(*shelf, size, out))
+      return true;
+  }
+
+  // Open a new shelf along the bottom of the used area.
+  if (!can_open_shelf)
+    return false;
+
+  Shelf shelf;
+  shelf.y = top;
+  shelf.height = size.height();
+  shelf.x_end = 0;
+  shelf.live_count = 0;
+  shelves_.push_back(shelf);
+  return AllocateOnShelf(shelves_.back(), size, out);
+}
+
+void RectPacker::Release(const Rect& rect) {
+  std::vector<Shelf>::iterator it =
+      std::find_if(shelves_.begin(), shelves_.end(), [&](const Shelf& shelf) {
+        return shelf.y == rect.y();
+      });
+  if (it == shelves_.end() || it->live_count == 0)
+    return;
+
+  Shelf& shelf = *it;
+  shelf.live_count--;
+  live_count_--;
+  used_area_ -= rect.width() * rect.height();
+
+  if (shelf.live_count == 0) {
+    shelf.x_end = 0;
+    shelf.free_spans.clear();
+  } else if (rect.x() + rect.width() == shelf.x_end) {
+    // Pull the end of the shelf back, swallowing any free span that now
+    // touches it.
+    shelf.x_end = rect.x();
+    while (!shelf.free_spans.empty() &&
+           shelf.free_spans.back().x + shelf.free_spans.back().width ==
+               shelf.x_end) {
+      shelf.x_end = shelf.free_spans.back().x;
+      shelf.free_spans.pop_back();
+    }
+  } else {
+    Span span = {rect.x(), rect.width()};
+    std::vector<Span>::iterator pos = std::lower_bound(
+        shelf.free_spans.begin(),
+        shelf.free_spans.end(),
+        span,
+        [](const Span& lhs, const Span& rhs) { return lhs.x < rhs.x; });
+    pos = shelf.free_spans.insert(pos, span);
+
+    // Coalesce with the neighbouring spans.
+    if (pos + 1 != shelf.free_spans.end() &&
+        pos->x + pos->width == (pos + 1)->x) {
+      pos->width += (pos + 1)->width;
+      shelf.free_spans.erase(pos + 1);
+    }
+    if (pos != shelf.free_spans.begin() &&
+        (pos - 1)->x + (pos - 1)->width == pos->x) {
+      (pos - 1)->width += pos->width;
+      shelf.free_spans.erase(pos);
+    }
+  }
+
+  // Give empty shelves at the bottom of the used area back to the page.
+  while (!shelves_.empty() && shelves_.back().live_count == 0)
+    shelves_.pop_back();
+}
+
+bool RectPacker::AllocateOnShelf(Shelf& shelf, const Size& size, Rect* out) {
+  for (std::vector<Span>::iterator it = shelf.free_spans.begin();
+       it != shelf.free_spans.end();
+       ++it) {
+    if (it->width >= size.width()) {
+      *out = Rect::REC(it->x, shelf.y, size.width(), size.height());
+      it->x += size.width();
+      it->width -= size.width();
+      if (it->width == 0)
+        shelf.free_spans.erase(it);
+
+      shelf.live_count++;
+      live_count_++;
+      used_area_ += size.width() * size.height();
+      return true;
+    }
+  }
+
+  if (shelf.x_end + size.width() > size_.width())
+    return false;
+
+  *out = Rect::REC(shelf.x_end, shelf.y, size.width(), size.height());
+  shelf.x_end += size.width();
+  shelf.live_count++;
+  live_count_++;
+  used_area_ += size.width() * size.height();
+  return true;
+}
@@ -0,0 +1,97 @@
+// -*- Mode: C++; tab-width:2; indent-tabs-mode: nil; c-basic-offset: 2 -*-
+// vi:tw=80:et:ts=2:sts=2
+//
+// -----------------------------------------------------------------------
+//
+// This file is part of RLVM, a RealLive virtual machine clone.
+//
+// -----------------------------------------------------------------------
+//
+// Copyright (C) 2015 Elliot Glaysher
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA.
+// -----------------------------------------------------------------------
+
+
+#ifndef SRC_SYSTEMS_BASE_RECT_PACKER_H_
+#define SRC_SYSTEMS_BASE_RECT_PACKER_H_
+
+#include <vector>
+
+#include "systems/base/rect.h"
+
+// Packs rectangles into a fixed size page using horizontal shelves. Used
+// to place many small images into one shared texture.
+//
+// Each shelf is a horizontal strip as tall as the first rectangle placed
+// in it. Later rectangles go onto the shelf that wastes the least height,
+// reusing space released by earlier rectangles before growing the shelf to
+// the right. Empty shelves keep their height, except for the trailing
+// (lowest) ones, which are given back so that a differently sized shelf can
+// take their place.
+class RectPacker {
+ public:
+  explicit RectPacker(const Size& size);
+  ~RectPacker();
+
+  // Reserves a |size| area of the page. Returns true and writes the
+  // location to |out| on success, or false if there's no room.
+  bool Allocate(const Size& size, Rect* out);
+
+  // Returns a rectangle previously handed out by Allocate().
+  void Release(const Rect& rect);
+
+  const Size& size() const { return size_; }
+
+  // Whether there are no live allocations.
+  bool empty() const { return live_count_ == 0; }
+
+  // Number of pixels covered by live allocations.
+  int used_area() const { return used_area_; }
+
+ private:
+  // A run of free pixels on a shelf, [x, x + width).
+  struct Span {
+    int x;
+    int width;
+  };
+
+  struct Shelf {
+    int y;
+    int height;
+
+    // The first column past the rightmost allocation.
+    int x_end;
+
+    // Number of live allocations on this shelf.
+    int live_count;
+
+    // Released runs to the left of |x_end|, sorted by x.
+    std::vector<Span> free_spans;
+  };
+
+  // Tries to place a |size| rectangle on |shelf|.
+  bool AllocateOnShelf(Shelf& shelf, const Size& size, Rect* out);
+
+  Size size_;
+
+  // Ordered from top to bottom.
+  std::vector<Shelf> shelves_;
+
+  int live_count_;
+  int used_area_;
+};
+
+#endif  // SRC_SYSTEMS_BASE_RECT_PACKER_H_
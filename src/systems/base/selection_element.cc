@@ -68,7 +68,10 @@ void SelectionElement::SetMousePosition(const Point& pos) {
   is_highlighted_ = IsHighlighted(pos);
 
   if (start_value != is_highlighted_) {
-    system_.graphics().MarkScreenAsDirty(GUT_TEXTSYS);
+    system_.graphics().MarkScreenAreaAsDirty(
+        GUT_TEXTSYS,
+        Rect(pos_, normal_image_->GetSize())
+            .RectUnion(Rect(pos_, highlighted_image_->GetSize())));
     if (is_highlighted_ && system_.sound().HasSe(0))
       system_.sound().PlaySe(0);
   }
@@ -43,6 +43,16 @@
 #include "systems/base/system.h"
 #include "libreallive/gameexe.h"
 
+namespace {
+
+const size_t kMegabyte = 1024 * 1024;
+
+// Default size of the decoded voice cache. A few seconds of 44.1kHz stereo is
+// about a megabyte.
+const int kDefaultVoiceCacheMB = 16;
+
+}  // namespace
+
 // -----------------------------------------------------------------------
 // SoundSystemGlobals
 // -----------------------------------------------------------------------
@@ -129,6 +139,10 @@ SoundSystem::SoundSystem(System& system)
 
   std::fill_n(channel_volume_, NUM_TOTAL_CHANNELS, 255);
 
+  voice_cache_.SetBudget(
+      gexe("__VOICE_CACHE_MB").ToNonNegativeInt(kDefaultVoiceCacheMB) *
+      kMegabyte);
+
   // Read the \#SE.xxx entries from the Gameexe
   GameexeFilteringIterator se = gexe.filtering_begin("SE.");
   GameexeFilteringIterator end = gexe.filtering_end();
@@ -375,6 +389,11 @@ void SoundSystem::KoePlay(int id, int charid) {
   }
 }
 
+void SoundSystem::PrefetchKoe(int id) {
+  if (is_koe_enabled() && !system_.ShouldFastForward())
+    voice_cache_.Prefetch(id);
+}
+
 void SoundSystem::Reset() {
   // empty
 }
@@ -349,6 +349,10 @@ class SoundSystem {
   void KoePlay(int id);
   void KoePlay(int id, int charid);
 
+  // Starts decoding voice |id| in the background because the script is about
+  // to play it.
+  void PrefetchKoe(int id);
+
   virtual bool KoePlaying() const = 0;
   virtual void KoeStop() = 0;
 
@@ -356,6 +360,8 @@ class SoundSystem {
 
   System& system() { return system_; }
 
+  VoiceCache& voice_cache() { return voice_cache_; }
+
  protected:
   SeTable& se_table() { return se_table_; }
   const DSTable& ds_table() { return ds_tracks_; }
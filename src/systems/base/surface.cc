@@ -43,6 +43,13 @@ Rect Surface::GetRect() const { return Rect(Point(0, 0), GetSize()); }
 
 // -----------------------------------------------------------------------
 
+size_t Surface::GetDecodedMemoryUsage() const {
+  Size size = GetSize();
+  return size_t(size.width()) * size.height() * 4;
+}
+
+// -----------------------------------------------------------------------
+
 void Surface::Dump() {
   throw rlvm::Exception("Unimplemented function Surface::Dump()");
 }
@@ -28,6 +28,7 @@
 #ifndef SRC_SYSTEMS_BASE_SURFACE_H_
 #define SRC_SYSTEMS_BASE_SURFACE_H_
 
+#include <cstddef>
 #include <memory>
 
 #include "systems/base/rect.h"
@@ -58,6 +59,14 @@ class Surface : public std::enable_shared_from_this<Surface> {
   // uploading.
   virtual void EnsureUploaded() const {}
 
+  // Returns how many bytes of texture memory this surface currently holds on
+  // the graphics card.
+  virtual size_t GetTextureMemoryUsage() const { return 0; }
+
+  // Returns how many bytes of decoded pixels this surface currently holds in
+  // main memory. Defaults to four bytes for every pixel of GetSize().
+  virtual size_t GetDecodedMemoryUsage() const;
+
   // ------------------------------------------------- [ Drawing functions ]
 
   // Fills the surface with |colour|.
@@ -0,0 +1,130 @@
+// -*- Mode: C++; tab-width:2; indent-tabs-mode: nil; c-basic-offset: 2 -*-
+// vi:tw=80:et:ts=2:sts=2
+//
+// -----------------------------------------------------------------------
+//
+// This file is part of RLVM, a RealLive virtual machine clone.
+//
+// -----------------------------------------------------------------------
+//
+// Copyright (C) 2015 Elliot Glaysher
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA.
+// -----------------------------------------------------------------------
+
+#include "systems/base/surface_cache.h"
+
+#include <string>
+
+#include "systems/base/rect.h"
+#include "systems/base/surface.h"
+
+namespace {
+
+size_t DecodedBytes(const std::shared_ptr<const Surface>& surface) {
+  if (!surface)
+    return 0;
+
+  return surface->GetDecodedMemoryUsage();
+}
+
+size_t TextureBytes(const std::shared_ptr<const Surface>& surface) {
+  if (!surface)
+    return 0;
+
+  return surface->GetTextureMemoryUsage();
+}
+
+}  // namespace
+
+// -----------------------------------------------------------------------
+// SurfaceCache::Stats
+// -----------------------------------------------------------------------
+
+SurfaceCache::Stats::Stats()
+    : hits(0),
+      misses(0),
+      evictions(0),
+      entries(0),
+      decoded_bytes(0),
+      texture_bytes(0) {}
+
+// -----------------------------------------------------------------------
+// SurfaceCache
+// -----------------------------------------------------------------------
+
+SurfaceCache::SurfaceCache(size_t decoded_budget, size_t texture_budget)
+    : decoded_budget_(decoded_budget), texture_budget_(texture_budget) {}
+
+SurfaceCache::~SurfaceCache() {}
+
+std::shared_ptr<const Surface> SurfaceCache::Fetch(const std::string& name) {
+  std::shared_ptr<const Surface>* surface = entries_.Fetch(name);
+  if (!surface)
+    return std::shared_ptr<const Surface>();
+
+  // Surfaces which decode their patterns lazily grow after insertion.
+  entries_.SetBytes(name, DecodedBytes(*surface));
+  return *surface;
+}
+
+bool SurfaceCache::Contains(const std::string& name) const {
+  return entries_.Contains(name);
+}
+
+void SurfaceCache::Insert(const std::string& name,
+                          const std::shared_ptr<const Surface>& surface) {
+  entries_.Insert(name, surface, DecodedBytes(surface));
+  Trim();
+}
+
+void SurfaceCache::Clear() { entries_.Clear(); }
+
+void SurfaceCache::SetBudgets(size_t decoded_budget, size_t texture_budget) {
+  decoded_budget_ = decoded_budget;
+  texture_budget_ = texture_budget;
+  Trim();
+}
+
+SurfaceCache::Stats SurfaceCache::GetStats() const {
+  Stats stats;
+  stats.hits = entries_.hits();
+  stats.misses = entries_.misses();
+  stats.evictions = entries_.evictions();
+  stats.entries = entries_.size();
+  stats.decoded_bytes = entries_.bytes();
+  stats.texture_bytes = CurrentTextureBytes();
+  return stats;
+}
+
+size_t SurfaceCache::CurrentTextureBytes() const {
+  size_t bytes = 0;
+  entries_.ForEach([&bytes](const std::shared_ptr<const Surface>& surface) {
+    bytes += TextureBytes(surface);
+  });
+  return bytes;
+}
+
+void SurfaceCache::Trim() {
+  size_t texture_bytes = CurrentTextureBytes();
+  while (entries_.bytes() > decoded_budget_ ||
+         texture_bytes > texture_budget_) {
+    size_t victim_texture_bytes = TextureBytes(entries_.oldest());
+    if (!entries_.EvictOldest())
+      break;
+
+    texture_bytes -= victim_texture_bytes;
+  }
+}
@@ -0,0 +1,96 @@
+// -*- Mode: C++; tab-width:2; indent-tabs-mode: nil; c-basic-offset: 2 -*-
+// vi:tw=80:et:ts=2:sts=2
+//
+// -----------------------------------------------------------------------
+//
+// This file is part of RLVM, a RealLive virtual machine clone.
+//
+// -----------------------------------------------------------------------
+//
+// Copyright (C) 2015 Elliot Glaysher
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA.
+// -----------------------------------------------------------------------
+
+#ifndef SRC_SYSTEMS_BASE_SURFACE_CACHE_H_
+#define SRC_SYSTEMS_BASE_SURFACE_CACHE_H_
+
+#include <cstddef>
+#include <memory>
+#include <string>
+
+#include "utilities/sized_lru_cache.h"
+
+class Surface;
+
+// Cache of recently loaded image Surfaces, which are assumed to be
+// immutable. Instead of holding a fixed number of entries, it evicts the least
+// recently used surfaces once either the decoded pixel data or the texture
+// memory of everything cached goes over budget, so a full screen CG weighs as
+// much as the many small button images it would take to fill the same memory.
+class SurfaceCache {
+ public:
+  struct Stats {
+    Stats();
+
+    int hits;
+    int misses;
+    int evictions;
+
+    size_t entries;
+    size_t decoded_bytes;
+    size_t texture_bytes;
+  };
+
+  SurfaceCache(size_t decoded_budget, size_t texture_budget);
+  ~SurfaceCache();
+
+  // Returns the surface cached under |name| and marks it as the most recently
+  // used, or returns NULL. Counts as a hit or a miss.
+  std::shared_ptr<const Surface> Fetch(const std::string& name);
+
+  // Whether |name| is cached. Doesn't touch the stats or the LRU order.
+  bool Contains(const std::string& name) const;
+
+  // Caches |surface| under |name|, then evicts least recently used entries
+  // until we're back under budget. The entry just inserted is never evicted,
+  // even if it alone is over budget.
+  void Insert(const std::string& name,
+              const std::shared_ptr<const Surface>& surface);
+
+  void Clear();
+
+  // Budgets are in bytes.
+  void SetBudgets(size_t decoded_budget, size_t texture_budget);
+  size_t decoded_budget() const { return decoded_budget_; }
+  size_t texture_budget() const { return texture_budget_; }
+
+  // Surfaces upload their textures lazily, so texture usage is recomputed
+  // here rather than tracked on insertion.
+  Stats GetStats() const;
+
+ private:
+  size_t CurrentTextureBytes() const;
+
+  void Trim();
+
+  // Weighed by decoded bytes; texture bytes are summed when needed.
+  SizedLRUCache<std::string, std::shared_ptr<const Surface>> entries_;
+
+  size_t decoded_budget_;
+  size_t texture_budget_;
+};
+
+#endif  // SRC_SYSTEMS_BASE_SURFACE_CACHE_H_
@@ -72,7 +72,7 @@ void TextKeyCursor::Execute() {
   if (cursor_image_ && last_time_frame_incremented_ + frame_speed_ < cur_time) {
     last_time_frame_incremented_ = cur_time;
 
-    system_.graphics().MarkScreenAsDirty(GUT_TEXTSYS);
+    system_.graphics().MarkScreenAreaAsDirty(GUT_TEXTSYS, last_rendered_rect_);
 
     current_frame_++;
     if (current_frame_ >= frame_count_)
@@ -86,10 +86,11 @@ void TextKeyCursor::Render(TextWindow& text_window, std::ostream* tree) {
   if (cursor_image_) {
     // Get the location to render from text_window
     Point keycur = text_window.KeycursorPosition(frame_size_);
+    last_rendered_rect_ = Rect(keycur, frame_size_);
 
     cursor_image_->RenderToScreen(
         Rect(Point(current_frame_ * frame_size_.width(), 0), frame_size_),
-        Rect(keycur, frame_size_),
+        last_rendered_rect_,
         255);
 
     if (tree) {
@@ -102,6 +103,15 @@ void TextKeyCursor::Render(TextWindow& text_window, std::ostream* tree) {
 
 // -----------------------------------------------------------------------
 
+Rect TextKeyCursor::GetScreenRect(const TextWindow& text_window) const {
+  if (!cursor_image_)
+    return Rect();
+
+  return Rect(text_window.KeycursorPosition(frame_size_), frame_size_);
+}
+
+// -----------------------------------------------------------------------
+
 void TextKeyCursor::SetCursorImage(System& system, const std::string& name) {
   if (name != "") {
     cursor_image_ = system.graphics().GetSurfaceNamed(name);
@@ -57,6 +57,9 @@ class TextKeyCursor {
   // positional information.
   void Render(TextWindow& text_window, std::ostream* tree);
 
+  // Where Render() would draw the cursor in |text_window|.
+  Rect GetScreenRect(const TextWindow& text_window) const;
+
   // Returns which cursor we are.
   int cursor_number() const { return cursor_number_; }
 
@@ -80,6 +83,10 @@ class TextKeyCursor {
   // The size of the cursor
   Size frame_size_;
 
+  // Where the cursor was last drawn, which is what needs redrawing when we
+  // advance a frame.
+  Rect last_rendered_rect_;
+
   // Number of frames in this cursor
   int frame_count_;
 
@@ -461,8 +461,9 @@ void TextPage::RunTextPageCommand(const Command& command,
       break;
     case TYPE_FONT_COLOUR:
       if (is_active_page) {
+        static GameexeIndexedKey color_table("COLOR_TABLE");
         window->SetFontColor(
-            system_->gameexe()("COLOR_TABLE", command.font_colour));
+            color_table(system_->gameexe(), command.font_colour));
       }
       break;
     case TYPE_DEFAULT_FONT_SIZE:
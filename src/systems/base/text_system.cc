@@ -202,6 +202,36 @@ void TextSystem::Render(std::ostream* tree) {
   }
 }
 
+Rect TextSystem::GetScreenFootprint() {
+  Rect footprint;
+  if (!system_visible())
+    return footprint;
+
+  for (WindowMap::iterator it = text_window_.begin();
+       it != text_window_.end();
+       ++it) {
+    if (ShowWindow(it->first) && it->second->is_visible() &&
+        it->second->GetTextSurface()) {
+      footprint = footprint.RectUnion(it->second->GetScreenFootprint());
+    }
+  }
+
+  if (ShowWindow(active_window_)) {
+    WindowMap::iterator it = text_window_.find(active_window_);
+
+    if (it != text_window_.end() && it->second->is_visible() &&
+        in_pause_state_ && !IsReadingBacklog()) {
+      if (!text_key_cursor_)
+        SetKeyCursor(0);
+
+      footprint =
+          footprint.RectUnion(text_key_cursor_->GetScreenRect(*it->second));
+    }
+  }
+
+  return footprint;
+}
+
 void TextSystem::HideTextWindow(int win_number) {
   WindowMap::iterator it = text_window_.find(win_number);
   if (it != text_window_.end()) {
@@ -690,8 +720,8 @@ std::shared_ptr<Surface> TextSystem::RenderText(const std::string& utf8str,
           // Consume an integer. Or don't.
           int val;
           if (parseInteger(cur_end, strend, val)) {
-            Gameexe& gexe = system().gameexe();
-            current_colour = RGBColour(gexe("COLOR_TABLE", val));
+            static GameexeIndexedKey color_table("COLOR_TABLE");
+            current_colour = RGBColour(color_table(system().gameexe(), val));
           } else {
             current_colour = colour;
           }
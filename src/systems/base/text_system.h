@@ -44,6 +44,7 @@
 class Gameexe;
 class Memory;
 class Point;
+class Rect;
 class RGBColour;
 class RLMachine;
 class Size;
@@ -103,6 +104,11 @@ class TextSystem : public EventListener {
   void ExecuteTextSystem();
 
   void Render(std::ostream* tree);
+
+  // A rectangle containing everything Render() draws, for damage tracking.
+  // Empty when nothing is drawn.
+  Rect GetScreenFootprint();
+
   void HideTextWindow(int win_number);
   void HideAllTextWindows();
   void HideAllTextWindowsExcept(int i);
@@ -358,6 +358,30 @@ Size TextWindow::GetNameboxTextArea() const {
       vertical_namebox_padding_ + name_size_);
 }
 
+Rect TextWindow::GetScreenFootprint() {
+  Rect footprint = GetWindowRect();
+
+  std::shared_ptr<Surface> text_surface = GetTextSurface();
+  if (text_surface) {
+    footprint = footprint.RectUnion(
+        Rect(GetTextSurfaceRect().origin(), text_surface->GetSize()));
+  }
+
+  if (namebox_waku_ && GetNameSurface())
+    footprint = footprint.RectUnion(GetNameboxWakuRect());
+
+  for (int i = 0; i < kNumFaceSlots; ++i) {
+    if (face_slot_[i] && face_slot_[i]->face_surface) {
+      footprint = footprint.RectUnion(
+          Rect(GetWindowRect().x() + face_slot_[i]->x,
+               GetWindowRect().y() + face_slot_[i]->y,
+               face_slot_[i]->face_surface->GetSize()));
+    }
+  }
+
+  return footprint;
+}
+
 void TextWindow::SetNameSpacingBetweenCharacters(
     const std::vector<int>& pos_data) {
   name_x_spacing_ = pos_data.at(0);
@@ -602,7 +626,8 @@ bool TextWindow::DisplayCharacter(const std::string& current,
   // When we aren't rendering a piece of text with a ruby gloss, mark
   // the screen as dirty so that this character renders.
   if (ruby_begin_point_ == -1) {
-    system_.graphics().MarkScreenAsDirty(GUT_TEXTSYS);
+    system_.graphics().MarkScreenAreaAsDirty(GUT_TEXTSYS,
+                                             GetScreenFootprint());
   }
 
   last_token_was_name_ = false;
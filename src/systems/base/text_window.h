@@ -126,6 +126,9 @@ class TextWindow {
   // The size of the writable text area.
   Size GetNameboxTextArea() const;
 
+  // A rectangle containing everything Render() draws, for damage tracking.
+  Rect GetScreenFootprint();
+
   // TODO(erg): What's SetMousePosition and how does it differ from mouse
   // listeners?
   void SetMousePosition(const Point& pos);
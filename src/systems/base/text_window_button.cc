@@ -135,7 +135,7 @@ void TextWindowButton::SetMousePosition(TextWindow& window, const Point& pos) {
       state_ = BUTTONSTATE_NORMAL;
 
     if (orig_state != state_)
-      system_.graphics().MarkScreenAsDirty(GUT_TEXTSYS);
+      system_.graphics().MarkScreenAreaAsDirty(GUT_TEXTSYS, Location(window));
   }
 }
 
@@ -159,7 +159,7 @@ bool TextWindowButton::HandleMouseClick(RLMachine& machine,
         ButtonReleased(machine);
       }
 
-      system_.graphics().MarkScreenAsDirty(GUT_TEXTSYS);
+      system_.graphics().MarkScreenAreaAsDirty(GUT_TEXTSYS, Location(window));
 
       return true;
     }
@@ -28,6 +28,8 @@
 
 #include <boost/algorithm/string.hpp>
 #include <boost/filesystem/path.hpp>
+#include <algorithm>
+#include <exception>
 #include <iomanip>
 #include <sstream>
 #include <string>
@@ -48,10 +50,44 @@ using std::string;
 
 namespace fs = boost::filesystem;
 
+// -----------------------------------------------------------------------
+// DecodedVoice
+// -----------------------------------------------------------------------
+
+DecodedVoice::DecodedVoice(char* data, int length)
+    : data(data), length(length) {}
+
+DecodedVoice::~DecodedVoice() {}
+
+// -----------------------------------------------------------------------
+// VoiceCache::Stats
+// -----------------------------------------------------------------------
+
+VoiceCache::Stats::Stats()
+    : hits(0), misses(0), prefetches(0), evictions(0), entries(0), bytes(0) {}
+
+// -----------------------------------------------------------------------
+// VoiceCache
+// -----------------------------------------------------------------------
+
 VoiceCache::VoiceCache(SoundSystem& sound_system)
-    : sound_system_(sound_system), file_cache_(7) {}
+    : sound_system_(sound_system),
+      file_cache_(7),
+      bytes_(0),
+      budget_(0),
+      decoding_id_(-1),
+      shutdown_(false) {}
+
+VoiceCache::~VoiceCache() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    shutdown_ = true;
+  }
+  wakeup_.notify_all();
 
-VoiceCache::~VoiceCache() {}
+  if (worker_.joinable())
+    worker_.join();
+}
 
 std::shared_ptr<VoiceSample> VoiceCache::Find(int id) {
   int file_no = id / ID_RADIX;
@@ -80,6 +116,94 @@ std::shared_ptr<VoiceSample> VoiceCache::Find(int id) {
   }
 }
 
+std::shared_ptr<const DecodedVoice> VoiceCache::FindDecoded(int id) {
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+
+    // If the worker hasn't gotten to |id| yet, it's quicker to decode it here
+    // than to wait behind whatever else is queued.
+    queue_.erase(std::remove_if(queue_.begin(),
+                                queue_.end(),
+                                [id](const Job& job) { return job.first == id; }),
+                 queue_.end());
+    decoded_.wait(lock, [&] { return decoding_id_ != id; });
+
+    std::shared_ptr<const DecodedVoice> voice = LookupLocked(id);
+    if (voice) {
+      stats_.hits++;
+      return voice;
+    }
+    stats_.misses++;
+  }
+
+  std::shared_ptr<VoiceSample> sample = Find(id);
+  if (!sample) {
+    std::ostringstream oss;
+    oss << "No sample for " << id;
+    throw rlvm::Exception(oss.str());
+  }
+
+  std::shared_ptr<const DecodedVoice> voice = DecodeSample(*sample);
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  InsertLocked(id, voice);
+  return voice;
+}
+
+void VoiceCache::Prefetch(int id) {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (index_.count(id) || decoding_id_ == id ||
+        std::any_of(queue_.begin(), queue_.end(), [id](const Job& job) {
+          return job.first == id;
+        })) {
+      return;
+    }
+  }
+
+  // Locating the sample touches |file_cache_| and the file system cache, so
+  // it happens here instead of on the worker.
+  std::shared_ptr<VoiceSample> sample;
+  try {
+    sample = Find(id);
+  } catch (std::exception& e) {
+    return;
+  }
+  if (!sample)
+    return;
+
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    queue_.push_back(Job(id, sample));
+    if (queue_.size() > kMaxQueuedPrefetches)
+      queue_.pop_front();
+    stats_.prefetches++;
+
+    if (!worker_.joinable())
+      worker_ = std::thread(&VoiceCache::WorkerLoop, this);
+  }
+  wakeup_.notify_one();
+}
+
+bool VoiceCache::IsCached(int id) const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return index_.count(id) != 0;
+}
+
+void VoiceCache::SetBudget(size_t bytes) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  budget_ = bytes;
+  TrimLocked();
+}
+
+VoiceCache::Stats VoiceCache::GetStats() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  Stats stats = stats_;
+  stats.entries = voices_.size();
+  stats.bytes = bytes_;
+  return stats;
+}
+
 std::shared_ptr<VoiceArchive> VoiceCache::FindArchive(int file_no) const {
   std::ostringstream oss;
   oss << "z" << std::setw(4) << std::setfill('0') << file_no;
@@ -121,3 +245,89 @@ std::shared_ptr<VoiceSample> VoiceCache::FindUnpackedSample(int file_no,
 
   return std::shared_ptr<VoiceSample>();
 }
+
+std::shared_ptr<const DecodedVoice> VoiceCache::DecodeSample(
+    VoiceSample& sample) const {
+  int length = 0;
+  char* data = sample.Decode(&length);
+  if (!data)
+    throw rlvm::Exception("Couldn't decode voice sample");
+
+  if (converter_) {
+    char* converted = converter_(data, &length);
+    if (converted != data) {
+      delete[] data;
+      data = converted;
+    }
+  }
+
+  return std::make_shared<DecodedVoice>(data, length);
+}
+
+std::shared_ptr<const DecodedVoice> VoiceCache::LookupLocked(int id) {
+  std::unordered_map<int, std::list<Entry>::iterator>::iterator it =
+      index_.find(id);
+  if (it == index_.end())
+    return std::shared_ptr<const DecodedVoice>();
+
+  voices_.splice(voices_.begin(), voices_, it->second);
+  return it->second->second;
+}
+
+void VoiceCache::InsertLocked(
+    int id,
+    const std::shared_ptr<const DecodedVoice>& voice) {
+  std::unordered_map<int, std::list<Entry>::iterator>::iterator it =
+      index_.find(id);
+  if (it != index_.end()) {
+    bytes_ -= it->second->second->length;
+    voices_.erase(it->second);
+    index_.erase(it);
+  }
+
+  voices_.push_front(Entry(id, voice));
+  index_[id] = voices_.begin();
+  bytes_ += voice->length;
+  TrimLocked();
+}
+
+void VoiceCache::TrimLocked() {
+  while (voices_.size() > 1 && bytes_ > budget_) {
+    const Entry& oldest = voices_.back();
+    bytes_ -= oldest.second->length;
+    index_.erase(oldest.first);
+    voices_.pop_back();
+    stats_.evictions++;
+  }
+}
+
+void VoiceCache::WorkerLoop() {
+  while (true) {
+    Job job;
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      wakeup_.wait(lock, [&] { return shutdown_ || !queue_.empty(); });
+      if (shutdown_)
+        return;
+
+      job = queue_.front();
+      queue_.pop_front();
+      decoding_id_ = job.first;
+    }
+
+    std::shared_ptr<const DecodedVoice> voice;
+    try {
+      voice = DecodeSample(*job.second);
+    } catch (std::exception& e) {
+      // Reported by FindDecoded() if the script ever plays this voice.
+    }
+
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      if (voice)
+        InsertLocked(job.first, voice);
+      decoding_id_ = -1;
+    }
+    decoded_.notify_all();
+  }
+}
@@ -27,7 +27,16 @@
 #ifndef SRC_SYSTEMS_BASE_VOICE_CACHE_H_
 #define SRC_SYSTEMS_BASE_VOICE_CACHE_H_
 
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <list>
 #include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <utility>
 
 #include "lru_cache.hpp"
 
@@ -35,14 +44,79 @@ class SoundSystem;
 class VoiceArchive;
 class VoiceSample;
 
+// A voice sample decoded into a WAV image in memory, ready to be handed to the
+// mixer.
+struct DecodedVoice {
+  DecodedVoice(char* data, int length);
+  ~DecodedVoice();
+
+  std::unique_ptr<char[]> data;
+
+  // The length of |data| as reported by VoiceSample::Decode().
+  int length;
+};
+
+// Finds voice samples by koe id, and keeps recently decoded voices around
+// within a byte budget. Prefetch() decodes a voice on a worker thread so that
+// by the time the script plays it, FindDecoded() can hand it straight to the
+// mixer.
+//
+// Find(), FindDecoded() and Prefetch() must all be called from the
+// interpreter's thread; only decoding happens on the worker.
 class VoiceCache {
  public:
+  // Turns the output of VoiceSample::Decode() into what the platform plays,
+  // returning either |data| or a new[]ed replacement for it. Runs on the
+  // worker thread for prefetched voices.
+  typedef std::function<char*(char* data, int* length)> Converter;
+
+  struct Stats {
+    Stats();
+
+    int hits;
+    int misses;
+    int prefetches;
+    int evictions;
+
+    size_t entries;
+    size_t bytes;
+  };
+
   explicit VoiceCache(SoundSystem& sound_system);
   ~VoiceCache();
 
   std::shared_ptr<VoiceSample> Find(int id);
 
+  // Returns voice |id| decoded and converted, from the cache if possible.
+  // Waits for the worker if it's decoding |id| right now. Throws if there's
+  // no such voice.
+  std::shared_ptr<const DecodedVoice> FindDecoded(int id);
+
+  // Queues voice |id| for decoding on the worker thread. Voices which don't
+  // exist are silently ignored; FindDecoded() reports them if they are ever
+  // played.
+  void Prefetch(int id);
+
+  // Whether voice |id| has been decoded and is in the cache.
+  bool IsCached(int id) const;
+
+  void set_converter(const Converter& converter) { converter_ = converter; }
+
+  // Sets the number of bytes of decoded voices to keep around. The most
+  // recently decoded voice is always kept, however large.
+  void SetBudget(size_t bytes);
+  size_t budget() const { return budget_; }
+
+  Stats GetStats() const;
+
+  // Maximum number of voices waiting for the worker. The oldest requests are
+  // dropped first, since the script has probably moved past them.
+  static const size_t kMaxQueuedPrefetches = 8;
+
  private:
+  typedef std::pair<int, std::shared_ptr<VoiceSample>> Job;
+  typedef std::pair<int, std::shared_ptr<const DecodedVoice>> Entry;
+
   // Searches for a file archive of voices.
   std::shared_ptr<VoiceArchive> FindArchive(int file_no) const;
 
@@ -50,10 +124,43 @@ class VoiceCache {
   std::shared_ptr<VoiceSample> FindUnpackedSample(int file_no,
                                                     int index) const;
 
+  // Decodes and converts |sample|. Throws if the sample can't be decoded.
+  std::shared_ptr<const DecodedVoice> DecodeSample(VoiceSample& sample) const;
+
+  // These require |mutex_| to be held.
+  std::shared_ptr<const DecodedVoice> LookupLocked(int id);
+  void InsertLocked(int id, const std::shared_ptr<const DecodedVoice>& voice);
+  void TrimLocked();
+
+  void WorkerLoop();
+
   SoundSystem& sound_system_;
 
   // A mapping between a file id number and the underlying file object.
   LRUCache<int, std::shared_ptr<VoiceArchive>> file_cache_;
+
+  Converter converter_;
+
+  // Guards everything below.
+  mutable std::mutex mutex_;
+  std::condition_variable wakeup_;
+  std::condition_variable decoded_;
+
+  // Decoded voices, most recently used first.
+  std::list<Entry> voices_;
+  std::unordered_map<int, std::list<Entry>::iterator> index_;
+  size_t bytes_;
+  size_t budget_;
+
+  // Voices waiting for the worker, and the one it's decoding right now (or
+  // -1).
+  std::deque<Job> queue_;
+  int decoding_id_;
+
+  Stats stats_;
+
+  std::thread worker_;
+  bool shutdown_;
 };  // class VoiceCache
 
 #endif  // SRC_SYSTEMS_BASE_VOICE_CACHE_H_
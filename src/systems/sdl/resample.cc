@@ -24,64 +24,233 @@
 // Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA.
 //
 // -----------------------------------------------------------------------
-//
-// Every library that I've seen that isn't tied to some sort of mixer library
-// in itself seems to either require you to do conversions, bring in its own
-// preferred file reading code, and/or pass in raw file descriptors for
-// input/output.
-//
-// If I had any idea about audio programming (and wasn't facing a hard one
-// week deadline), I could do a better job of this, but since I don't, write
-// and read from tempfiles. This file is glue code to zresample.
-//
-// Patches welcome.
 
 #include "systems/sdl/resample.h"
 
-#include <stdlib.h>
-#include <unistd.h>
-#include <iostream>
+#include <SDL/SDL_mixer.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <utility>
+
+#include "xclannad/endian.hpp"
+#include "xclannad/wavfile.h"
+
+namespace {
+
+// Half-length of zita-resampler's filter, in samples.
+const unsigned int kFilterSize = 96;
+
+const int kWavHeaderSize = 0x2c;
+
+// zita-resampler only handles rates in this range.
+bool IsSupportedRate(int rate) { return rate >= 8000 && rate <= 192000; }
+
+int16_t FloatToSample(float value) {
+  float scaled = std::round(value * 32768.0f);
+  return static_cast<int16_t>(std::max(-32768.0f, std::min(32767.0f, scaled)));
+}
+
+// Streams a WAVFILE through a StreamingResampler.
+class ResamplingWAVFILE : public WAVFILE {
+ public:
+  ResamplingWAVFILE(WAVFILE* original,
+                    std::unique_ptr<StreamingResampler> resampler);
+  virtual ~ResamplingWAVFILE();
 
-#include "systems/sdl/zresample.h"
-#include "vendor/xclannad/wavfile.h"
+  // Overridden from WAVFILE:
+  virtual int Read(char* buf, int blksize, int blklen) override;
+  virtual void Seek(int count) override;
 
-char* EnsureDataIsCorrectBitrate(char* incoming_data, int* length) {
-  // TODO(erg): Fast path by just returning incoming_data if the bitrate is the
-  // same as the desired rate.
+ private:
+  std::unique_ptr<WAVFILE> original_;
+  std::unique_ptr<StreamingResampler> resampler_;
+};
 
-  // Write |incoming_data| to a file.
-  char dir_template[] = "/tmp/rlvm-temp-XXXXXX";
-  char* tmp_dirname = mkdtemp(dir_template);
-  if (tmp_dirname == nullptr) {
-    std::cerr << "Warning! Failed to make temp dir for audio conversion."
-              << std::endl;
-    return incoming_data;
+ResamplingWAVFILE::ResamplingWAVFILE(
+    WAVFILE* original,
+    std::unique_ptr<StreamingResampler> resampler)
+    : original_(original), resampler_(std::move(resampler)) {
+  wavinfo.SamplingRate = WAVFILE::freq;
+  wavinfo.Channels = resampler_->channels();
+  wavinfo.DataBits = 16;
+}
+
+ResamplingWAVFILE::~ResamplingWAVFILE() {}
+
+int ResamplingWAVFILE::Read(char* buf, int blksize, int blklen) {
+  int frame_size = resampler_->channels() * 2;
+  int frames = resampler_->Read(reinterpret_cast<int16_t*>(buf),
+                                blksize * blklen / frame_size);
+  return frames * frame_size / blksize;
+}
+
+void ResamplingWAVFILE::Seek(int count) {
+  original_->Seek(count);
+  resampler_->Reset();
+}
+
+}  // namespace
+
+// -----------------------------------------------------------------------
+// StreamingResampler
+// -----------------------------------------------------------------------
+
+// static
+std::unique_ptr<StreamingResampler> StreamingResampler::Create(
+    int in_rate,
+    int out_rate,
+    int channels,
+    const Source& source) {
+  if (!IsSupportedRate(in_rate) || !IsSupportedRate(out_rate) ||
+      channels <= 0) {
+    return nullptr;
   }
 
-  std::string infile_name = tmp_dirname;
-  infile_name += "/input.wav";
-  std::string outfile_name = tmp_dirname;
-  outfile_name += "/output.wav";
+  std::unique_ptr<StreamingResampler> resampler(
+      new StreamingResampler(channels, source));
+  if (resampler->resampler_.setup(in_rate, out_rate, channels, kFilterSize))
+    return nullptr;
 
-  FILE* infile = fopen(infile_name.c_str(), "wb");
-  fwrite(incoming_data, *length, 1, infile);
-  fclose(infile);
+  resampler->Reset();
+  return resampler;
+}
 
-  zresample_main(infile_name.c_str(), outfile_name.c_str(), WAVFILE::freq);
+StreamingResampler::StreamingResampler(int channels, const Source& source)
+    : source_(source),
+      channels_(channels),
+      state_(STREAMING),
+      source_block_(kBlockFrames * channels),
+      input_(kBlockFrames * channels),
+      output_(kBlockFrames * channels) {}
 
-  FILE* f = fopen(outfile_name.c_str(), "rb");
-  fseek(f, 0, SEEK_END);
-  long fsize = ftell(f);
-  *length = fsize;
-  fseek(f, 0, SEEK_SET);
+StreamingResampler::~StreamingResampler() {}
 
-  char* outdata = new char[fsize];
-  fread(outdata, fsize, 1, f);
-  fclose(f);
+int StreamingResampler::Read(int16_t* out, int max_frames) {
+  int written = 0;
+  while (written < max_frames && state_ != FINISHED) {
+    int block = std::min(max_frames - written, kBlockFrames);
+    resampler_.out_count = block;
+    resampler_.out_data = output_.data();
 
-  unlink(infile_name.c_str());
-  unlink(outfile_name.c_str());
-  rmdir(tmp_dirname);
+    while (resampler_.out_count > 0) {
+      if (resampler_.inp_count == 0) {
+        FeedInput();
+        if (state_ == FINISHED)
+          break;
+      }
+      resampler_.process();
+    }
+
+    int produced = block - resampler_.out_count;
+    std::transform(output_.begin(),
+                   output_.begin() + produced * channels_,
+                   out + written * channels_,
+                   FloatToSample);
+    written += produced;
+  }
+
+  return written;
+}
+
+void StreamingResampler::Reset() {
+  resampler_.reset();
+  state_ = STREAMING;
+
+  // Prime the filter with zeros so that the output lines up with the input
+  // instead of lagging by half the filter length.
+  resampler_.inp_count = resampler_.inpsize() / 2 - 1;
+  resampler_.inp_data = nullptr;
+}
+
+void StreamingResampler::FeedInput() {
+  if (state_ == DRAINING) {
+    state_ = FINISHED;
+    return;
+  }
+
+  int frames = source_(source_block_.data(), kBlockFrames);
+  if (frames > 0) {
+    std::transform(source_block_.begin(),
+                   source_block_.begin() + frames * channels_,
+                   input_.begin(),
+                   [](int16_t sample) { return sample / 32768.0f; });
+    resampler_.inp_count = frames;
+    resampler_.inp_data = input_.data();
+  } else {
+    // Push the last of the real input out through the filter.
+    resampler_.inp_count = resampler_.inpsize() / 2;
+    resampler_.inp_data = nullptr;
+    state_ = DRAINING;
+  }
+}
+
+// -----------------------------------------------------------------------
+
+char* ResampleWavToOutputRate(char* data, int* length) {
+  int rate = read_little_endian_int(data + 0x18);
+  int channels = read_little_endian_short(data + 0x16);
+  int bits = read_little_endian_short(data + 0x22);
+  if (rate == WAVFILE::freq || bits != 16 || channels <= 0)
+    return data;
+
+  // The decoders don't agree on whether |length| or the header's data size is
+  // the exact one, so believe whichever is smaller.
+  int data_bytes =
+      std::min(*length, read_little_endian_int(data + 0x28));
+  int in_frames = std::max(data_bytes, 0) / (channels * 2);
+
+  const int16_t* in = reinterpret_cast<const int16_t*>(data + kWavHeaderSize);
+  int consumed = 0;
+  std::unique_ptr<StreamingResampler> resampler = StreamingResampler::Create(
+      rate,
+      WAVFILE::freq,
+      channels,
+      [&](int16_t* frames, int max_frames) {
+        int count = std::min(max_frames, in_frames - consumed);
+        memcpy(frames, in + consumed * channels, count * channels * 2);
+        consumed += count;
+        return count;
+      });
+  if (!resampler)
+    return data;
+
+  // Leave room for rounding; Read() tells us how much was actually produced.
+  int out_frames = static_cast<int>(
+      static_cast<int64_t>(in_frames) * WAVFILE::freq / rate) + 1;
+  char* out = new char[kWavHeaderSize + out_frames * channels * 2];
+  int16_t* out_samples = reinterpret_cast<int16_t*>(out + kWavHeaderSize);
+  out_frames = resampler->Read(out_samples, out_frames);
+
+  int out_bytes = out_frames * channels * 2;
+  memcpy(out, data, kWavHeaderSize);
+  write_little_endian_int(out + 0x04, kWavHeaderSize + out_bytes - 8);
+  write_little_endian_int(out + 0x18, WAVFILE::freq);
+  write_little_endian_int(out + 0x1c, WAVFILE::freq * channels * 2);
+  write_little_endian_int(out + 0x28, out_bytes);
+
+  *length = out_bytes;
+  return out;
+}
+
+WAVFILE* MakeResamplingReader(WAVFILE* reader) {
+  int channels = reader->wavinfo.Channels;
+  if (reader->wavinfo.SamplingRate != static_cast<unsigned>(WAVFILE::freq) &&
+      reader->wavinfo.DataBits == 16 && channels == WAVFILE::channels &&
+      WAVFILE::format == AUDIO_S16) {
+    std::unique_ptr<StreamingResampler> resampler = StreamingResampler::Create(
+        reader->wavinfo.SamplingRate,
+        WAVFILE::freq,
+        channels,
+        [reader, channels](int16_t* frames, int max_frames) {
+          int count = reader->Read(
+              reinterpret_cast<char*>(frames), channels * 2, max_frames);
+          return std::max(count, 0);
+        });
+    if (resampler)
+      return new ResamplingWAVFILE(reader, std::move(resampler));
+  }
 
-  return outdata;
+  return WAVFILE::MakeConverter(reader);
 }
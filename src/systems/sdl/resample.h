@@ -28,17 +28,75 @@
 #ifndef SRC_SYSTEMS_SDL_RESAMPLE_H_
 #define SRC_SYSTEMS_SDL_RESAMPLE_H_
 
-#include <cstddef>
+#include <zita-resampler/resampler.h>
 
-// Ensures that the wav file with PCM data |incoming_data| is of the same
-// bitrate as our output device. This function takes ownership of
-// |incoming_data|. |length| is modified to refer to the size of the return
-// value.
-//
-// Caller takes ownership of return value.
-//
-// TODO(erg): Hopefully, this is a temporary hack. See comments in
-// sdl_sound_system.cc.
-char* EnsureDataIsCorrectBitrate(char* incoming_data, int* length);
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <vector>
+
+struct WAVFILE;
+
+// Converts interleaved 16-bit PCM from one sample rate to another with
+// zita-resampler. Input is pulled from a Source and converted a block at a
+// time as output is asked for, so memory use is bounded no matter how long
+// the stream is.
+class StreamingResampler {
+ public:
+  // Fills |frames| with up to |max_frames| frames of input and returns how
+  // many were written. Returning 0 ends the stream.
+  typedef std::function<int(int16_t* frames, int max_frames)> Source;
+
+  // Returns NULL if zita-resampler can't convert between the two rates.
+  static std::unique_ptr<StreamingResampler> Create(int in_rate,
+                                                    int out_rate,
+                                                    int channels,
+                                                    const Source& source);
+  ~StreamingResampler();
+
+  // Writes up to |max_frames| converted frames to |out|. Returns fewer than
+  // |max_frames| only once the source has ended and the filter has been
+  // drained.
+  int Read(int16_t* out, int max_frames);
+
+  // Throws away buffered input and filter state, for when the source seeks.
+  void Reset();
+
+  int channels() const { return channels_; }
+
+  // Number of frames converted per step, which bounds the buffers we keep.
+  static const int kBlockFrames = 4096;
+
+ private:
+  enum State { STREAMING, DRAINING, FINISHED };
+
+  StreamingResampler(int channels, const Source& source);
+
+  // Refills the resampler's input once it has consumed what it was given.
+  void FeedInput();
+
+  Resampler resampler_;
+  Source source_;
+  int channels_;
+  State state_;
+
+  std::vector<int16_t> source_block_;
+  std::vector<float> input_;
+  std::vector<float> output_;
+};
+
+// Resamples the in memory WAV file |data| to the output device's rate, for
+// sound chunks. Returns |data| untouched when it's already at that rate or
+// isn't 16-bit PCM (SDL_mixer converts those itself); otherwise returns a
+// new[]ed WAV and leaves deleting |data| to the caller. |length| is the
+// number of bytes after the 0x2c byte header, and is updated to match the
+// return value.
+char* ResampleWavToOutputRate(char* data, int* length);
+
+// Wraps |reader| so that it produces audio in the output device's format,
+// streaming it through a StreamingResampler when only the sample rate
+// differs and falling back to WAVFILE::MakeConverter() otherwise. Takes
+// ownership of |reader|.
+WAVFILE* MakeResamplingReader(WAVFILE* reader);
 
 #endif  // SRC_SYSTEMS_SDL_RESAMPLE_H_
@@ -32,6 +32,7 @@
 #include "systems/base/graphics_object.h"
 #include "systems/sdl/sdl_utils.h"
 #include "systems/sdl/shaders.h"
+#include "systems/sdl/sprite_batch.h"
 #include "systems/sdl/texture.h"
 
 SDLColourFilter::SDLColourFilter()
@@ -45,6 +46,10 @@ SDLColourFilter::~SDLColourFilter() {
 void SDLColourFilter::Fill(const GraphicsObject& go,
                            const Rect& screen_rect,
                            const RGBAColour& colour) {
+  // The filter reads back what's on screen, so everything under it has to
+  // have been drawn.
+  SpriteBatch::FlushCurrent();
+
   if (GLEW_ARB_fragment_shader && GLEW_ARB_multitexture) {
     if (back_texture_id_ == 0) {
       glGenTextures(1, &back_texture_id_);
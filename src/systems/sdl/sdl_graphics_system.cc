@@ -44,6 +44,7 @@
 #include <set>
 #include <sstream>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include "base/notification_source.h"
@@ -53,6 +54,7 @@
 #include "systems/base/colour.h"
 #include "systems/base/event_system.h"
 #include "systems/base/graphics_object.h"
+#include "systems/base/image_decoder.h"
 #include "systems/base/mouse_cursor.h"
 #include "systems/base/renderable.h"
 #include "systems/base/system.h"
@@ -70,7 +72,6 @@
 #include "utilities/graphics.h"
 #include "utilities/lazy_array.h"
 #include "utilities/string_utilities.h"
-#include "xclannad/file.h"
 
 // -----------------------------------------------------------------------
 // Private Interface
@@ -126,20 +127,13 @@ void SDLGraphicsSystem::EndFrame() {
     (*it)->Render(NULL);
   }
 
-  if (screen_update_mode() == SCREENUPDATEMODE_MANUAL) {
+  if (screen_update_mode() == SCREENUPDATEMODE_MANUAL ||
+      is_responsible_for_update()) {
     // Copy the area behind the cursor to the temporary buffer (drivers differ:
     // the contents of the back buffer is undefined after SDL_GL_SwapBuffers()
     // and I've just been lucky that the Intel i810 and whatever my Mac machine
     // has have been doing things that way.)
-    glBindTexture(GL_TEXTURE_2D, screen_contents_texture_);
-    glCopyTexSubImage2D(GL_TEXTURE_2D,
-                        0,
-                        0,
-                        0,
-                        0,
-                        0,
-                        screen_size().width(),
-                        screen_size().height());
+    CopyToScreenContents(screen_rect());
     screen_contents_texture_valid_ = true;
   } else {
     screen_contents_texture_valid_ = false;
@@ -160,28 +154,7 @@ void SDLGraphicsSystem::RedrawLastFrame() {
   // DrawManual() mode.
   if (screen_contents_texture_valid_) {
     // Redraw the screen
-    glBindTexture(GL_TEXTURE_2D, screen_contents_texture_);
-    glBegin(GL_QUADS);
-    {
-      int dx1 = 0;
-      int dx2 = screen_size().width();
-      int dy1 = 0;
-      int dy2 = screen_size().height();
-
-      float x_cord = dx2 / float(screen_tex_width_);
-      float y_cord = dy2 / float(screen_tex_height_);
-
-      glColor4ub(255, 255, 255, 255);
-      glTexCoord2f(0, y_cord);
-      glVertex2i(dx1, dy1);
-      glTexCoord2f(x_cord, y_cord);
-      glVertex2i(dx2, dy1);
-      glTexCoord2f(x_cord, 0);
-      glVertex2i(dx2, dy2);
-      glTexCoord2f(0, 0);
-      glVertex2i(dx1, dy2);
-    }
-    glEnd();
+    DrawScreenContents();
 
     DrawCursor();
 
@@ -193,6 +166,78 @@ void SDLGraphicsSystem::RedrawLastFrame() {
   }
 }
 
+bool SDLGraphicsSystem::BeginPartialFrame(const Rect& area) {
+  if (!screen_contents_texture_valid_)
+    return false;
+
+  BeginFrame();
+  DrawScreenContents();
+
+  // Everything else is clipped to |area|, which starts out black like the
+  // rest of a full frame does.
+  glEnable(GL_SCISSOR_TEST);
+  glScissor(area.x(),
+            screen_size().height() - area.y2(),
+            area.width(),
+            area.height());
+  glClear(GL_COLOR_BUFFER_BIT);
+  DebugShowGLErrors();
+
+  return true;
+}
+
+void SDLGraphicsSystem::EndPartialFrame(const Rect& area) {
+  glDisable(GL_SCISSOR_TEST);
+
+  if (area.width() > 0 && area.height() > 0)
+    CopyToScreenContents(area);
+
+  DrawCursor();
+
+  glFlush();
+  SDL_GL_SwapBuffers();
+  ShowGLErrors();
+}
+
+void SDLGraphicsSystem::DrawScreenContents() {
+  glBindTexture(GL_TEXTURE_2D, screen_contents_texture_);
+  glBegin(GL_QUADS);
+  {
+    int dx1 = 0;
+    int dx2 = screen_size().width();
+    int dy1 = 0;
+    int dy2 = screen_size().height();
+
+    float x_cord = dx2 / float(screen_tex_width_);
+    float y_cord = dy2 / float(screen_tex_height_);
+
+    glColor4ub(255, 255, 255, 255);
+    glTexCoord2f(0, y_cord);
+    glVertex2i(dx1, dy1);
+    glTexCoord2f(x_cord, y_cord);
+    glVertex2i(dx2, dy1);
+    glTexCoord2f(x_cord, 0);
+    glVertex2i(dx2, dy2);
+    glTexCoord2f(0, 0);
+    glVertex2i(dx1, dy2);
+  }
+  glEnd();
+}
+
+void SDLGraphicsSystem::CopyToScreenContents(const Rect& area) {
+  // The texture is stored bottom up, like the back buffer.
+  int y = screen_size().height() - area.y2();
+  glBindTexture(GL_TEXTURE_2D, screen_contents_texture_);
+  glCopyTexSubImage2D(GL_TEXTURE_2D,
+                      0,
+                      area.x(),
+                      y,
+                      area.x(),
+                      y,
+                      area.width(),
+                      area.height());
+}
+
 void SDLGraphicsSystem::DrawCursor() {
   if (ShouldUseCustomCursor()) {
     std::shared_ptr<MouseCursor> cursor;
@@ -350,6 +395,7 @@ void SDLGraphicsSystem::SetupVideo() {
   // Create a small 32x32 texture for storing what's behind the mouse
   // cursor.
   glGenTextures(1, &screen_contents_texture_);
+  screen_contents_texture_valid_ = false;
   glBindTexture(GL_TEXTURE_2D, screen_contents_texture_);
   glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
   glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
@@ -374,7 +420,7 @@ void SDLGraphicsSystem::ExecuteGraphicsSystem(RLMachine& machine) {
   // For now, nothing, but later, we need to put all code each cycle
   // here.
   if (is_responsible_for_update() && screen_needs_refresh()) {
-    Refresh(NULL);
+    RefreshDamagedArea();
     OnScreenRefreshed();
     redraw_last_frame_ = false;
   } else if (is_responsible_for_update() && redraw_last_frame_) {
@@ -424,6 +470,7 @@ void SDLGraphicsSystem::Observe(NotificationType type,
                                 const NotificationSource& source,
                                 const NotificationDetails& details) {
   Shaders::Reset();
+  texture_atlas_.Reset();
 }
 
 void SDLGraphicsSystem::SetWindowSubtitle(const std::string& cp932str,
@@ -514,61 +561,6 @@ void SDLGraphicsSystem::VerifySurfaceExists(int dc, const std::string& caller) {
 
 // -----------------------------------------------------------------------
 
-typedef enum { NO_MASK, ALPHA_MASK, COLOR_MASK } MaskType;
-
-// Note to self: These describe the byte order IN THE RAW G00 DATA!
-// These should NOT be switched to native byte order.
-#define DefaultRmask 0xff0000
-#define DefaultGmask 0xff00
-#define DefaultBmask 0xff
-#define DefaultAmask 0xff000000
-#define DefaultBpp 32
-
-static SDL_Surface* newSurfaceFromRGBAData(int w,
-                                           int h,
-                                           char* data,
-                                           MaskType with_mask) {
-  int amask = (with_mask == ALPHA_MASK) ? DefaultAmask : 0;
-  SDL_Surface* tmp = SDL_CreateRGBSurfaceFrom(data,
-                                              w,
-                                              h,
-                                              DefaultBpp,
-                                              w * 4,
-                                              DefaultRmask,
-                                              DefaultGmask,
-                                              DefaultBmask,
-                                              amask);
-
-  // We now need to convert this surface to a format suitable for use across
-  // the rest of the program. We can't (regretfully) rely on
-  // SDL_DisplayFormat[Alpha] to decide on a format that we can send to OpenGL
-  // (see some Intel macs) so use convert surface to a pixel order our data
-  // correctly while still using the appropriate alpha flags. So use the above
-  // format with only the flags that would have been set by
-  // SDL_DisplayFormat[Alpha].
-  Uint32 flags;
-  if (with_mask == ALPHA_MASK) {
-    flags = tmp->flags & (SDL_SRCALPHA | SDL_RLEACCELOK);
-  } else {
-    flags = tmp->flags & (SDL_SRCCOLORKEY | SDL_SRCALPHA | SDL_RLEACCELOK);
-  }
-
-  SDL_Surface* surf = SDL_ConvertSurface(tmp, tmp->format, flags);
-  SDL_FreeSurface(tmp);
-  return surf;
-}
-
-// Helper function for load_surface_from_file; invoked in a stl loop.
-static SDLSurface::GrpRect xclannadRegionToGrpRect(
-    const GRPCONV::REGION& region) {
-  SDLSurface::GrpRect rect;
-  rect.rect =
-      Rect(Point(region.x1, region.y1), Point(region.x2 + 1, region.y2 + 1));
-  rect.originX = region.origin_x;
-  rect.originY = region.origin_y;
-  return rect;
-}
-
 std::shared_ptr<const Surface> SDLGraphicsSystem::LoadSurfaceFromFile(
     const std::string& short_filename) {
   boost::filesystem::path filename =
@@ -579,67 +571,29 @@ std::shared_ptr<const Surface> SDLGraphicsSystem::LoadSurfaceFromFile(
     throw rlvm::Exception(oss.str());
   }
 
-  // Glue code to allow my stuff to work with Jagarl's loader
-  FILE* file = fopen(filename.string().c_str(), "rb");
-  if (!file) {
-    std::ostringstream oss;
-    oss << "Could not open file: " << filename;
-    throw rlvm::Exception(oss.str());
-  }
+  // Reading and decompressing the file may already have been done on one of
+  // the decoder's threads if this image was prefetched.
+  std::shared_ptr<DecodedImage> image = image_decoder().Decode(filename);
 
-  fseek(file, 0, SEEK_END);
-  size_t size = ftell(file);
-  std::unique_ptr<char[]> d(new char[size + 1]);
-  fseek(file, 0, SEEK_SET);
-  fread(d.get(), size, 1, file);
-  fclose(file);
-
-  std::unique_ptr<GRPCONV> conv(
-      GRPCONV::AssignConverter(d.get(), size, "???"));
-  if (conv == 0) {
-    throw SystemError("Failure in GRPCONV.");
-  }
-  // do not free until SDL_FreeSurface() is called on the surface using it
-  char* mem = (char*)malloc(conv->Width() * conv->Height() * 4 + 1024);
-  SDL_Surface* s = 0;
-  if (conv->Read(mem)) {
-    MaskType is_mask = conv->IsMask() ? ALPHA_MASK : NO_MASK;
-    if (is_mask == ALPHA_MASK) {
-      int len = conv->Width() * conv->Height();
-      unsigned int* d = (unsigned int*)mem;
-      int i;
-      for (i = 0; i < len; i++) {
-        if ((*d & 0xff000000) != 0xff000000)
-          break;
-        d++;
-      }
-      if (i == len) {
-        is_mask = NO_MASK;
-      }
+  std::shared_ptr<Surface> surface_to_ret;
+  if (image->patterns) {
+    surface_to_ret.reset(new SDLSurface(this,
+                                        image->patterns,
+                                        Size(image->width, image->height),
+                                        image->region_table));
+  } else {
+    SDL_Surface* s = 0;
+    if (image->pixels) {
+      s = newSurfaceFromRGBAData(Size(image->width, image->height),
+                                 image->pixels.get(),
+                                 image->has_alpha);
+      if (s)
+        image->pixels.release();
     }
 
-    s = newSurfaceFromRGBAData(conv->Width(), conv->Height(), mem, is_mask);
-  }
-  free(mem);
-
-  // Grab the Type-2 information out of the converter or create one
-  // default region if none exist
-  std::vector<SDLSurface::GrpRect> region_table;
-  if (conv->region_table.size()) {
-    std::transform(conv->region_table.begin(),
-                   conv->region_table.end(),
-                   std::back_inserter(region_table),
-                   xclannadRegionToGrpRect);
-  } else {
-    SDLSurface::GrpRect rect;
-    rect.rect = Rect(Point(0, 0), Size(conv->Width(), conv->Height()));
-    rect.originX = 0;
-    rect.originY = 0;
-    region_table.push_back(rect);
+    surface_to_ret.reset(new SDLSurface(this, s, image->region_table));
   }
 
-  std::shared_ptr<Surface> surface_to_ret(
-      new SDLSurface(this, s, region_table));
   // handle tone curve effect loading
   if (short_filename.find("?") != short_filename.npos) {
     std::string effect_no_str =
@@ -655,12 +609,16 @@ std::shared_ptr<const Surface> SDLGraphicsSystem::LoadSurfaceFromFile(
     }
     surface_to_ret.get()->ToneCurve(
         globals().tone_curves.GetEffect(effect_no / 10 - 1),
-        Rect(Point(0, 0), Size(conv->Width(), conv->Height())));
+        Rect(Point(0, 0), Size(image->width, image->height)));
   }
 
   return surface_to_ret;
 }
 
+void SDLGraphicsSystem::BeginRenderingObjects() { sprite_batch_.Begin(); }
+
+void SDLGraphicsSystem::EndRenderingObjects() { sprite_batch_.End(); }
+
 std::shared_ptr<Surface> SDLGraphicsSystem::GetHaikei() {
   if (haikei_->rawSurface() == NULL) {
     haikei_->allocate(screen_size(), true);
@@ -37,6 +37,8 @@
 #include "base/notification_observer.h"
 #include "base/notification_registrar.h"
 #include "systems/base/graphics_system.h"
+#include "systems/sdl/sprite_batch.h"
+#include "systems/sdl/texture_atlas.h"
 
 struct SDL_Surface;
 
@@ -99,6 +101,12 @@ class SDLGraphicsSystem : public GraphicsSystem, public NotificationObserver {
   // game.
   virtual void Reset() override;
 
+ protected:
+  virtual void BeginRenderingObjects() override;
+  virtual void EndRenderingObjects() override;
+  virtual bool BeginPartialFrame(const Rect& area) override;
+  virtual void EndPartialFrame(const Rect& area) override;
+
  private:
   void SetupVideo();
 
@@ -110,6 +118,12 @@ class SDLGraphicsSystem : public GraphicsSystem, public NotificationObserver {
 
   void SetWindowTitle();
 
+  // Draws |screen_contents_texture_| over the whole screen.
+  void DrawScreenContents();
+
+  // Copies |area| of the back buffer into |screen_contents_texture_|.
+  void CopyToScreenContents(const Rect& area);
+
   // NotificationObserver:
   virtual void Observe(NotificationType type,
                        const NotificationSource& source,
@@ -146,9 +160,10 @@ class SDLGraphicsSystem : public GraphicsSystem, public NotificationObserver {
   // memory leak in PulseAudio.
   std::string currently_set_title_;
 
-  // Texture used to store the contents of the screen while in DrawManual()
-  // mode. The stored image is then used if we need to redraw in the
-  // intervening time (expose events, mouse cursor moves, etc).
+  // Texture used to store the contents of the last frame we drew, without the
+  // cursor. The stored image is used if we need to redraw in the intervening
+  // time in DrawManual() mode (expose events, mouse cursor moves, etc), and
+  // as the base that partial frames are drawn on top of.
   GLuint screen_contents_texture_;
 
   // Whether |screen_contents_texture_| is valid to use.
@@ -160,6 +175,12 @@ class SDLGraphicsSystem : public GraphicsSystem, public NotificationObserver {
   int screen_tex_width_;
   int screen_tex_height_;
 
+  // Collects the quads of graphics objects during RenderObjects().
+  SpriteBatch sprite_batch_;
+
+  // Shared textures that small surfaces are packed into.
+  TextureAtlas texture_atlas_;
+
   NotificationRegistrar registrar_;
 };
 
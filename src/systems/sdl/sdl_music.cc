@@ -39,6 +39,7 @@
 #include <vector>
 
 #include "systems/base/system.h"
+#include "systems/sdl/resample.h"
 #include "systems/sdl/sdl_audio_locker.h"
 #include "utilities/exception.h"
 
@@ -197,7 +198,7 @@ void SDLMusic::MixMusic(void* udata, Uint8* stream, int len) {
 
 template <typename TYPE>
 WAVFILE* BuildMusicImplementation(FILE* file, int size) {
-  return WAVFILE::MakeConverter(new TYPE(file, size));
+  return MakeResamplingReader(new TYPE(file, size));
 }
 
 std::shared_ptr<SDLMusic> SDLMusic::CreateMusic(
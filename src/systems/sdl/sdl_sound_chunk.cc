@@ -29,9 +29,14 @@
 
 #include <SDL/SDL_mixer.h>
 #include <boost/algorithm/string.hpp>
+#include <memory>
 #include <string>
 
+#include "libreallive/filemap.h"
 #include "systems/base/sound_system.h"
+#include "systems/base/voice_archive.h"
+#include "systems/base/voice_cache.h"
+#include "systems/sdl/resample.h"
 #include "systems/sdl/sdl_audio_locker.h"
 #include "xclannad/wavfile.h"
 
@@ -40,13 +45,15 @@ SDLSoundChunk::PlayingTable SDLSoundChunk::s_playing_table;
 SDLSoundChunk::SDLSoundChunk(const boost::filesystem::path& path)
     : sample_(LoadSample(path)) {}
 
-SDLSoundChunk::SDLSoundChunk(char* data, int length)
-    : sample_(Mix_LoadWAV_RW(SDL_RWFromMem(data, length + 0x2c), 1)),
-      data_(data) {}
+SDLSoundChunk::SDLSoundChunk(std::shared_ptr<const DecodedVoice> voice)
+    : sample_(Mix_LoadWAV_RW(
+          SDL_RWFromConstMem(voice->data.get(), voice->length + 0x2c),
+          1)),
+      voice_(voice) {}
 
 SDLSoundChunk::~SDLSoundChunk() {
   Mix_FreeChunk(sample_);
-  data_.reset();
+  voice_.reset();
 }
 
 Mix_Chunk* SDLSoundChunk::LoadSample(const boost::filesystem::path& path) {
@@ -60,13 +67,33 @@ Mix_Chunk* SDLSoundChunk::LoadSample(const boost::filesystem::path& path) {
     int size = 0;
     char* data = NWAFILE::ReadAll(f, size);
     fclose(f);
+    if (!data)
+      return NULL;
+
+    int length = size - WAV_HEADER_SIZE;
+    char* resampled = ResampleWavToOutputRate(data, &length);
+    if (resampled != data) {
+      delete[] data;
+      data = resampled;
+    }
 
-    Mix_Chunk* chunk = Mix_LoadWAV_RW(SDL_RWFromMem(data, size), 1);
+    Mix_Chunk* chunk =
+        Mix_LoadWAV_RW(SDL_RWFromMem(data, length + WAV_HEADER_SIZE), 1);
     delete[] data;
 
     return chunk;
   } else {
-    return Mix_LoadWAV(path.native().c_str());
+    // Let SDL_mixer decode straight out of a mapping of the file instead of
+    // going through stdio. The mapping only needs to outlive the load, since
+    // the chunk holds its own decoded samples.
+    std::unique_ptr<libreallive::Mapping> file;
+    try {
+      file.reset(new libreallive::Mapping(path.string(), libreallive::Read));
+    } catch (libreallive::Error&) {
+      return NULL;
+    }
+
+    return Mix_LoadWAV_RW(SDL_RWFromConstMem(file->get(), file->size()), 1);
   }
 }
 
@@ -35,6 +35,8 @@
 #include <map>
 #include <memory>
 
+struct DecodedVoice;
+
 // -----------------------------------------------------------------------
 
 // Encapsulates a Mix_Chunk object. We do this so we can refcounting
@@ -44,8 +46,8 @@ class SDLSoundChunk : public std::enable_shared_from_this<SDLSoundChunk> {
   // Builds a Mix_Chunk from a file.
   explicit SDLSoundChunk(const boost::filesystem::path& path);
 
-  // Builds a Mix_Chunk from a chunk of memory.
-  SDLSoundChunk(char* data, int length);
+  // Builds a Mix_Chunk from a decoded voice.
+  explicit SDLSoundChunk(std::shared_ptr<const DecodedVoice> voice);
 
   virtual ~SDLSoundChunk();
 
@@ -86,9 +88,10 @@ class SDLSoundChunk : public std::enable_shared_from_this<SDLSoundChunk> {
   // Wrapped chunk
   Mix_Chunk* sample_;
 
-  // If this object was created from a memory chunk instead of a file, we have
-  // to own the data that we pass to Mix_LoadWAV_RW(SDL_RWFromMem(...)).
-  std::unique_ptr<char[]> data_;
+  // If this object was created from a decoded voice instead of a file, we
+  // have to keep alive the data that we pass to
+  // Mix_LoadWAV_RW(SDL_RWFromConstMem(...)).
+  std::shared_ptr<const DecodedVoice> voice_;
 };
 
 // -----------------------------------------------------------------------
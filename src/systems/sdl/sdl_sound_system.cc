@@ -87,9 +87,9 @@ SDLSoundSystem::SDLSoundChunkPtr SDLSoundSystem::GetSoundChunk(
   return sample;
 }
 
-SDLSoundSystem::SDLSoundChunkPtr SDLSoundSystem::BuildKoeChunk(char* data,
-                                                               int length) {
-  return SDLSoundChunkPtr(new SDLSoundChunk(data, length));
+SDLSoundSystem::SDLSoundChunkPtr SDLSoundSystem::BuildKoeChunk(
+    std::shared_ptr<const DecodedVoice> voice) {
+  return SDLSoundChunkPtr(new SDLSoundChunk(voice));
 }
 
 void SDLSoundSystem::WavPlayImpl(const std::string& wav_file,
@@ -164,6 +164,10 @@ SDLSoundSystem::SDLSoundSystem(System& system)
 
   Mix_ChannelFinished(&SDLSoundChunk::SoundChunkFinishedPlayback);
 
+  // SDL_mixer's own rate conversion is poor enough that 48k -> 44.1k is at best
+  // tone shifted and at worst pure static, so resample voices ourselves.
+  voice_cache_.set_converter(&ResampleWavToOutputRate);
+
   SetMusicHook(NULL);
 }
 
@@ -387,29 +391,10 @@ void SDLSoundSystem::KoePlayImpl(int id) {
     return;
   }
 
-  // Get the VoiceSample.
-  std::shared_ptr<VoiceSample> sample = voice_cache_.Find(id);
-  if (!sample) {
-    std::ostringstream oss;
-    oss << "No sample for " << id;
-    throw std::runtime_error(oss.str());
-  }
+  // Usually already decoded and resampled by a prefetch.
+  std::shared_ptr<const DecodedVoice> voice = voice_cache_.FindDecoded(id);
 
-  int length;
-  char* data = sample->Decode(&length);
-
-  // TODO(erg): SDL is supposed to have a real resampler, but doesn't, so for
-  // example, 48k -> 41k is at best tone shifted, and at worst, is a pure
-  // static. So we have to do our own manual resampling.
-  //
-  // The correct way to deal with this is to move off SDL's audio subsystem
-  // entirely or to contribute upstream to SDL so that its default behaviour is
-  // sane. There's no time left to do either of those, as there's a fairly
-  // hard deadline of 9/11 for the birthday release, and this is the last
-  // blocker.
-  data = EnsureDataIsCorrectBitrate(data, &length);
-
-  SDLSoundChunkPtr koe = BuildKoeChunk(data, length);
+  SDLSoundChunkPtr koe = BuildKoeChunk(voice);
   SetChannelVolumeImpl(KOE_CHANNEL);
   koe->PlayChunkOn(KOE_CHANNEL, 0);
 }
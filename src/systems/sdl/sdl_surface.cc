@@ -28,6 +28,10 @@
 #include "systems/sdl/sdl_surface.h"
 
 #include <SDL/SDL.h>
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
 #include <iostream>
 #include <sstream>
 #include <vector>
@@ -37,6 +41,7 @@
 #include "systems/base/colour.h"
 #include "systems/base/graphics_object.h"
 #include "systems/base/graphics_object_data.h"
+#include "systems/base/image_decoder.h"
 #include "systems/base/system_error.h"
 #include "systems/sdl/sdl_graphics_system.h"
 #include "systems/sdl/sdl_utils.h"
@@ -195,6 +200,53 @@ SDL_Surface* buildNewSurface(const Size& size) {
   return tmp;
 }
 
+SDL_Surface* newSurfaceFromRGBAData(const Size& size,
+                                    char* pixels,
+                                    bool with_alpha) {
+  // The decoded pixels are already in the format we use across the rest of
+  // the program, so wrap them in a surface instead of converting them into a
+  // copy. (We can't rely on SDL_DisplayFormat[Alpha] to pick a format that we
+  // can send to OpenGL; see some Intel macs.)
+  int amask = with_alpha ? DefaultAmask : 0;
+#if defined(HAVE_FREE)
+  // SDL_free() is the C library's free() in this build, so the surface can
+  // adopt the pixels: without SDL_PREALLOC, SDL_FreeSurface() releases them.
+  SDL_Surface* surf = SDL_CreateRGBSurfaceFrom(pixels,
+                                               size.width(),
+                                               size.height(),
+                                               DefaultBpp,
+                                               size.width() * 4,
+                                               DefaultRmask,
+                                               DefaultGmask,
+                                               DefaultBmask,
+                                               amask);
+  if (surf)
+    surf->flags &= ~SDL_PREALLOC;
+#else
+  // SDL has its own allocator, so SDL_FreeSurface() mustn't be handed memory
+  // from malloc(). Copy the pixels into a surface SDL allocated instead.
+  SDL_Surface* surf = SDL_CreateRGBSurface(SDL_SWSURFACE,
+                                           size.width(),
+                                           size.height(),
+                                           DefaultBpp,
+                                           DefaultRmask,
+                                           DefaultGmask,
+                                           DefaultBmask,
+                                           amask);
+  if (surf) {
+    size_t row_bytes = size_t(size.width()) * 4;
+    for (int y = 0; y < size.height(); ++y) {
+      memcpy(static_cast<char*>(surf->pixels) + y * surf->pitch,
+             pixels + y * row_bytes,
+             row_bytes);
+    }
+    free(pixels);
+  }
+#endif
+
+  return surf;
+}
+
 // -----------------------------------------------------------------------
 // SDLSurface::TextureRecord
 // -----------------------------------------------------------------------
@@ -305,11 +357,58 @@ SDLSurface::SDLSurface(SDLGraphicsSystem* system, const Size& size)
 
 // -----------------------------------------------------------------------
 
+SDLSurface::SDLSurface(SDLGraphicsSystem* system,
+                       const std::shared_ptr<G00PatternDecoder>& patterns,
+                       const Size& size,
+                       const std::vector<SDLSurface::GrpRect>& region_table)
+    : surface_(NULL),
+      pattern_decoder_(patterns),
+      lazy_size_(size),
+      patterns_(region_table.size()),
+      region_table_(region_table),
+      texture_is_valid_(false),
+      is_dc0_(false),
+      graphics_system_(system),
+      is_mask_(false) {
+  registerForNotification(system);
+}
+
+// -----------------------------------------------------------------------
+
 void SDLSurface::EnsureUploaded() const {
+  // Patterns decoded on demand are uploaded when they're first drawn.
+  if (pattern_decoder_)
+    return;
+
   // TODO(erg): Style fix this entire file and make this implementation:
   uploadTextureIfNeeded();
 }
 
+size_t SDLSurface::GetTextureMemoryUsage() const {
+  size_t bytes = 0;
+  for (const TextureRecord& record : textures_) {
+    if (record.texture)
+      bytes += record.texture->GetMemoryUsage();
+  }
+  for (const std::unique_ptr<SDLSurface>& pattern : patterns_) {
+    if (pattern)
+      bytes += pattern->GetTextureMemoryUsage();
+  }
+  return bytes;
+}
+
+size_t SDLSurface::GetDecodedMemoryUsage() const {
+  if (!pattern_decoder_)
+    return Surface::GetDecodedMemoryUsage();
+
+  size_t bytes = 0;
+  for (const std::unique_ptr<SDLSurface>& pattern : patterns_) {
+    if (pattern)
+      bytes += pattern->GetDecodedMemoryUsage();
+  }
+  return bytes;
+}
+
 // -----------------------------------------------------------------------
 
 void SDLSurface::registerForNotification(GraphicsSystem* system) {
@@ -340,6 +439,9 @@ SDLSurface::~SDLSurface() { deallocate(); }
 // -----------------------------------------------------------------------
 
 Size SDLSurface::GetSize() const {
+  if (pattern_decoder_)
+    return lazy_size_;
+
   assert(surface_);
   return Size(surface_->w, surface_->h);
 }
@@ -351,7 +453,7 @@ void SDLSurface::Dump() {
   std::ostringstream ss;
   ss << "dump_" << count << ".bmp";
   count++;
-  SDL_SaveBMP(surface_, ss.str().c_str());
+  SDL_SaveBMP(rawSurface(), ss.str().c_str());
 }
 
 // -----------------------------------------------------------------------
@@ -375,6 +477,8 @@ void SDLSurface::allocate(const Size& size, bool is_dc0) {
 
 void SDLSurface::deallocate() {
   textures_.clear();
+  patterns_.clear();
+  pattern_decoder_.reset();
   if (surface_) {
     SDL_FreeSurface(surface_);
     surface_ = NULL;
@@ -388,6 +492,13 @@ void SDLSurface::BlitToSurface(Surface& dest_surface,
                                const Rect& dst,
                                int alpha,
                                bool use_src_alpha) const {
+  Rect pattern_src = src;
+  if (const SDLSurface* pattern = PatternSurfaceFor(&pattern_src)) {
+    pattern->BlitToSurface(dest_surface, pattern_src, dst, alpha,
+                           use_src_alpha);
+    return;
+  }
+
   SDLSurface& sdl_dest_surface = dynamic_cast<SDLSurface&>(dest_surface);
 
   SDL_Rect src_rect, dest_rect;
@@ -441,6 +552,8 @@ void SDLSurface::blitFROMSurface(SDL_Surface* src_surface,
                                  const Rect& dst,
                                  int alpha,
                                  bool use_src_alpha) {
+  MaterializeCanvas();
+
   SDL_Rect src_rect, dest_rect;
   RectToSDLRect(src, &src_rect);
   RectToSDLRect(dst, &dest_rect);
@@ -520,6 +633,8 @@ static void determineProperties(SDL_Surface* surface,
 // -----------------------------------------------------------------------
 
 void SDLSurface::uploadTextureIfNeeded() const {
+  MaterializeCanvas();
+
   if (!texture_is_valid_) {
     if (textures_.size() == 0) {
       GLenum bytes_per_pixel;
@@ -573,6 +688,12 @@ void SDLSurface::uploadTextureIfNeeded() const {
 void SDLSurface::RenderToScreen(const Rect& src,
                                 const Rect& dst,
                                 int alpha) const {
+  Rect pattern_src = src;
+  if (const SDLSurface* pattern = PatternSurfaceFor(&pattern_src)) {
+    pattern->RenderToScreen(pattern_src, dst, alpha);
+    return;
+  }
+
   uploadTextureIfNeeded();
 
   for (std::vector<TextureRecord>::iterator it = textures_.begin();
@@ -588,6 +709,12 @@ void SDLSurface::RenderToScreenAsColorMask(const Rect& src,
                                            const Rect& dst,
                                            const RGBAColour& rgba,
                                            int filter) const {
+  Rect pattern_src = src;
+  if (const SDLSurface* pattern = PatternSurfaceFor(&pattern_src)) {
+    pattern->RenderToScreenAsColorMask(pattern_src, dst, rgba, filter);
+    return;
+  }
+
   uploadTextureIfNeeded();
 
   for (std::vector<TextureRecord>::iterator it = textures_.begin();
@@ -602,6 +729,12 @@ void SDLSurface::RenderToScreenAsColorMask(const Rect& src,
 void SDLSurface::RenderToScreen(const Rect& src,
                                 const Rect& dst,
                                 const int opacity[4]) const {
+  Rect pattern_src = src;
+  if (const SDLSurface* pattern = PatternSurfaceFor(&pattern_src)) {
+    pattern->RenderToScreen(pattern_src, dst, opacity);
+    return;
+  }
+
   uploadTextureIfNeeded();
 
   for (std::vector<TextureRecord>::iterator it = textures_.begin();
@@ -617,6 +750,12 @@ void SDLSurface::RenderToScreenAsObject(const GraphicsObject& rp,
                                         const Rect& src,
                                         const Rect& dst,
                                         int alpha) const {
+  Rect pattern_src = src;
+  if (const SDLSurface* pattern = PatternSurfaceFor(&pattern_src)) {
+    pattern->RenderToScreenAsObject(rp, pattern_src, dst, alpha);
+    return;
+  }
+
   uploadTextureIfNeeded();
 
   for (std::vector<TextureRecord>::iterator it = textures_.begin();
@@ -629,6 +768,8 @@ void SDLSurface::RenderToScreenAsObject(const GraphicsObject& rp,
 // -----------------------------------------------------------------------
 
 void SDLSurface::Fill(const RGBAColour& colour) {
+  MaterializeCanvas();
+
   // Fill the entire surface with the incoming colour
   Uint32 sdl_colour = MapRGBA(surface_->format, colour);
 
@@ -642,6 +783,8 @@ void SDLSurface::Fill(const RGBAColour& colour) {
 // -----------------------------------------------------------------------
 
 void SDLSurface::Fill(const RGBAColour& colour, const Rect& area) {
+  MaterializeCanvas();
+
   // Fill the entire surface with the incoming colour
   Uint32 sdl_colour = MapRGBA(surface_->format, colour);
 
@@ -699,6 +842,15 @@ const SDLSurface::GrpRect& SDLSurface::GetPattern(int patt_no) const {
 // -----------------------------------------------------------------------
 
 Surface* SDLSurface::Clone() const {
+  // Copies of an image that's still decoded a pattern at a time share its
+  // decoder.
+  if (pattern_decoder_) {
+    SDLSurface* clone = new SDLSurface(
+        graphics_system_, pattern_decoder_, lazy_size_, region_table_);
+    clone->SetIsMask(is_mask_);
+    return clone;
+  }
+
   SDL_Surface* tmp_surface =
       SDL_CreateRGBSurface(surface_->flags,
                            surface_->w,
@@ -752,6 +904,12 @@ std::vector<int> SDLSurface::segmentPicture(int size_remainging) {
 // -----------------------------------------------------------------------
 
 void SDLSurface::GetDCPixel(const Point& pos, int& r, int& g, int& b) const {
+  Rect pattern_src(pos, Size(1, 1));
+  if (const SDLSurface* pattern = PatternSurfaceFor(&pattern_src)) {
+    pattern->GetDCPixel(pattern_src.origin(), r, g, b);
+    return;
+  }
+
   SDL_Color colour;
   Uint32 col = 0;
 
@@ -782,6 +940,7 @@ std::shared_ptr<Surface> SDLSurface::ClipAsColorMask(const Rect& clip_rect,
                                                        int g,
                                                        int b) const {
   const char* function_name = "SDLGraphicsSystem::ClipAsColorMask()";
+  MaterializeCanvas();
 
   // TODO(erg): This needs to be made exception safe and so does the rest
   // of this file.
@@ -814,6 +973,85 @@ std::shared_ptr<Surface> SDLSurface::ClipAsColorMask(const Rect& clip_rect,
 
 // -----------------------------------------------------------------------
 
+void SDLSurface::SetIsMask(const bool is) {
+  is_mask_ = is;
+  for (const std::unique_ptr<SDLSurface>& pattern : patterns_) {
+    if (pattern)
+      pattern->SetIsMask(is);
+  }
+}
+
+// -----------------------------------------------------------------------
+
+const SDLSurface* SDLSurface::PatternSurfaceFor(Rect* src) const {
+  if (!pattern_decoder_)
+    return NULL;
+
+  for (size_t i = 0; i < region_table_.size(); ++i) {
+    const Rect& rect = region_table_[i].rect;
+    if (src->x() < rect.x() || src->y() < rect.y() ||
+        src->x2() > rect.x2() || src->y2() > rect.y2())
+      continue;
+
+    if (!patterns_[i]) {
+      int width, height;
+      bool has_alpha;
+      DecodedImage::PixelBuffer pixels =
+          pattern_decoder_->DecodePattern(i, &width, &height, &has_alpha);
+      SDL_Surface* surface = newSurfaceFromRGBAData(
+          Size(width, height), pixels.get(), has_alpha);
+      if (!surface)
+        reportSDLError("SDL_CreateRGBSurfaceFrom", "PatternSurfaceFor()");
+      pixels.release();
+
+      patterns_[i].reset(new SDLSurface(graphics_system_, surface));
+      patterns_[i]->SetIsMask(is_mask_);
+    }
+
+    *src = Rect(Point(src->x() - rect.x(), src->y() - rect.y()), src->size());
+    return patterns_[i].get();
+  }
+
+  MaterializeCanvas();
+  return NULL;
+}
+
+// -----------------------------------------------------------------------
+
+void SDLSurface::MaterializeCanvas() const {
+  if (!pattern_decoder_)
+    return;
+
+  // Like G00CONV::Read(), start from a transparent canvas and copy each
+  // pattern to its place on it. The patterns don't overlap.
+  SDL_Surface* canvas = buildNewSurface(lazy_size_);
+  SDL_FillRect(canvas, NULL, 0);
+  for (size_t i = 0; i < region_table_.size(); ++i) {
+    int width, height;
+    bool has_alpha;
+    DecodedImage::PixelBuffer pixels =
+        pattern_decoder_->DecodePattern(i, &width, &height, &has_alpha);
+
+    const Rect& rect = region_table_[i].rect;
+    int columns = std::min(width, canvas->w - rect.x());
+    if (columns <= 0)
+      continue;
+    for (int y = 0; y < height && rect.y() + y < canvas->h; ++y) {
+      memcpy(static_cast<char*>(canvas->pixels) +
+                 (rect.y() + y) * canvas->pitch + rect.x() * 4,
+             pixels.get() + y * width * 4,
+             columns * 4);
+    }
+  }
+
+  surface_ = canvas;
+  patterns_.clear();
+  pattern_decoder_.reset();
+  texture_is_valid_ = false;
+}
+
+// -----------------------------------------------------------------------
+
 void SDLSurface::markWrittenTo(const Rect& written_rect) {
   // If we are marked as dc0, alert the SDLGraphicsSystem.
   if (is_dc0_ && graphics_system_) {
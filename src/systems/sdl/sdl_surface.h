@@ -28,6 +28,7 @@
 #ifndef SRC_SYSTEMS_SDL_SDL_SURFACE_H_
 #define SRC_SYSTEMS_SDL_SDL_SURFACE_H_
 
+#include <memory>
 #include <vector>
 
 #include "base/notification_observer.h"
@@ -36,6 +37,7 @@
 #include "systems/base/tone_curve.h"
 
 struct SDL_Surface;
+class G00PatternDecoder;
 class Texture;
 class GraphicsSystem;
 class SDLGraphicsSystem;
@@ -44,6 +46,13 @@ class GraphicsObject;
 // Helper function. Used throughout the SDL system.
 SDL_Surface* buildNewSurface(const Size& size);
 
+// Wraps |pixels|, malloc()ed in the layout ImageDecoder produces, in a
+// surface. On success, |pixels| belongs to the surface (or has already been
+// freed) and the caller must not free it.
+SDL_Surface* newSurfaceFromRGBAData(const Size& size,
+                                    char* pixels,
+                                    bool with_alpha);
+
 // Wrapper around an OpenGL texture; meant to be passed out of the
 // graphics system.
 //
@@ -65,16 +74,27 @@ class SDLSurface : public Surface, public NotificationObserver {
 
   // Surface created with a specified width and height
   SDLSurface(SDLGraphicsSystem* system, const Size& size);
+
+  // Surface of |size| for a type 2 g00 whose patterns are decoded on
+  // demand. Each pattern gets its own small surface the first time it's
+  // drawn; the full canvas is only built when something needs more than one
+  // pattern at once.
+  SDLSurface(SDLGraphicsSystem* system,
+             const std::shared_ptr<G00PatternDecoder>& patterns,
+             const Size& size,
+             const std::vector<SDLSurface::GrpRect>& region_table);
   ~SDLSurface();
 
   virtual void EnsureUploaded() const override;
+  virtual size_t GetTextureMemoryUsage() const override;
+  virtual size_t GetDecodedMemoryUsage() const override;
 
   void registerForNotification(GraphicsSystem* system);
 
   // Whether we have an underlying allocated surface.
   bool allocated() { return surface_; }
 
-  virtual void SetIsMask(const bool is) override { is_mask_ = is; }
+  virtual void SetIsMask(const bool is) override;
 
   void buildRegionTable(const Size& size);
 
@@ -84,9 +104,12 @@ class SDLSurface : public Surface, public NotificationObserver {
   void allocate(const Size& size, bool is_dc0);
   void deallocate();
 
-  operator SDL_Surface*() { return surface_; }
+  operator SDL_Surface*() { return rawSurface(); }
 
-  SDL_Surface* rawSurface() { return surface_; }
+  SDL_Surface* rawSurface() {
+    MaterializeCanvas();
+    return surface_;
+  }
 
   virtual void BlitToSurface(Surface& dest_surface,
                              const Rect& src,
@@ -135,7 +158,7 @@ class SDLSurface : public Surface, public NotificationObserver {
   virtual void Mono(const Rect& area) override;
   virtual void ApplyColour(const RGBColour& colour, const Rect& area) override;
 
-  SDL_Surface* surface() { return surface_; }
+  SDL_Surface* surface() { return rawSurface(); }
 
   virtual void GetDCPixel(const Point& pos, int& r, int& g, int& b) const override;
   virtual std::shared_ptr<Surface> ClipAsColorMask(const Rect& clip_rect,
@@ -195,8 +218,26 @@ class SDLSurface : public Surface, public NotificationObserver {
 
   static std::vector<int> segmentPicture(int size_remainging);
 
-  // The SDL_Surface that contains the software version of the bitmap.
-  SDL_Surface* surface_;
+  // For surfaces whose patterns are decoded on demand, returns the surface
+  // of the one pattern that contains |src|, decoding it if needed, and moves
+  // |src| into that surface's coordinates. Otherwise returns NULL; if |src|
+  // didn't fit in a single pattern, the full canvas has been built.
+  const SDLSurface* PatternSurfaceFor(Rect* src) const;
+
+  // Draws every pattern onto a full sized |surface_| and stops decoding
+  // patterns separately. Does nothing for ordinary surfaces.
+  void MaterializeCanvas() const;
+
+  // The SDL_Surface that contains the software version of the
+  // bitmap. Mutable because surfaces which decode their patterns on demand
+  // build it the first time a const method needs the whole canvas.
+  mutable SDL_Surface* surface_;
+
+  // Set while this surface decodes its patterns on demand; |surface_| is
+  // NULL until then, and |patterns_| holds the ones decoded so far.
+  mutable std::shared_ptr<G00PatternDecoder> pattern_decoder_;
+  Size lazy_size_;
+  mutable std::vector<std::unique_ptr<SDLSurface>> patterns_;
 
   // The region table
   std::vector<GrpRect> region_table_;
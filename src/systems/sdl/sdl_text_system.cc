@@ -29,10 +29,12 @@
 
 #include <SDL/SDL_ttf.h>
 
+#include <algorithm>
 #include <iostream>
 #include <sstream>
 #include <stdexcept>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include "systems/base/graphics_system.h"
@@ -47,8 +49,61 @@
 #include "utilities/find_font_file.h"
 #include "libreallive/gameexe.h"
 
+namespace {
+
+const size_t kMegabyte = 1024 * 1024;
+
+// Enough for several thousand glyphs at message window sizes.
+const int kDefaultGlyphCacheMB = 4;
+
+// The format TTF_RenderUTF8_Blended() produces: 32 bit ARGB with the glyph's
+// coverage in the alpha channel.
+SDL_Surface* CreateTextSurface(int width, int height) {
+  SDL_Surface* surface = SDL_CreateRGBSurface(SDL_SWSURFACE | SDL_SRCALPHA,
+                                              width,
+                                              height,
+                                              32,
+                                              0x00FF0000,
+                                              0x0000FF00,
+                                              0x000000FF,
+                                              0xFF000000);
+  if (!surface)
+    reportSDLError("SDL_CreateRGBSurface", "CreateTextSurface()");
+  return surface;
+}
+
+// Writes |glyph| in |colour| into the top left corner of |surface|, which
+// must be at least as large as the glyph and in CreateTextSurface()'s format.
+void FillTextSurface(const Glyph& glyph,
+                     const RGBColour& colour,
+                     SDL_Surface* surface) {
+  Uint32 rgb = (colour.r() << 16) | (colour.g() << 8) | colour.b();
+  int width = glyph.size.width();
+
+  if (SDL_MUSTLOCK(surface))
+    SDL_LockSurface(surface);
+
+  const uint8_t* coverage = glyph.coverage.data();
+  for (int y = 0; y < glyph.size.height(); ++y) {
+    Uint32* row = reinterpret_cast<Uint32*>(
+        static_cast<Uint8*>(surface->pixels) + y * surface->pitch);
+    for (int x = 0; x < width; ++x)
+      row[x] = rgb | (Uint32(coverage[x]) << 24);
+    coverage += width;
+  }
+
+  if (SDL_MUSTLOCK(surface))
+    SDL_UnlockSurface(surface);
+}
+
+}  // namespace
+
 SDLTextSystem::SDLTextSystem(SDLSystem& system, Gameexe& gameexe)
-    : TextSystem(system, gameexe), sdl_system_(system) {
+    : TextSystem(system, gameexe),
+      glyph_cache_(
+          gameexe("__GLYPH_CACHE_MB").ToNonNegativeInt(kDefaultGlyphCacheMB) *
+          kMegabyte),
+      sdl_system_(system) {
   if (TTF_Init() == -1) {
     std::ostringstream oss;
     oss << "Error initializing SDL_ttf: " << TTF_GetError();
@@ -83,19 +138,8 @@ Size SDLTextSystem::RenderGlyphOnto(
     const std::shared_ptr<Surface>& destination) {
   SDLSurface* sdl_surface = static_cast<SDLSurface*>(destination.get());
 
-  std::shared_ptr<TTF_Font> font = GetFontOfSize(font_size);
-
-  if (italic) {
-    TTF_SetFontStyle(font.get(), TTF_STYLE_ITALIC);
-  }
-
-  SDL_Color sdl_colour;
-  RGBColourToSDLColor(font_colour, &sdl_colour);
-  std::shared_ptr<SDL_Surface> character(
-      TTF_RenderUTF8_Blended(font.get(), current.c_str(), sdl_colour),
-      SDL_FreeSurface);
-
-  if (character == NULL) {
+  const Glyph* glyph = GetGlyph(current, font_size, italic);
+  if (glyph == NULL) {
     // Bug during Kyou's path. The string is printed "". Regression in parser?
     std::cerr << "WARNING. TTF_RenderUTF8_Blended didn't render the "
               << "character \"" << current << "\". Hopefully continuing..."
@@ -103,34 +147,13 @@ Size SDLTextSystem::RenderGlyphOnto(
     return Size(0, 0);
   }
 
-  std::shared_ptr<SDL_Surface> shadow;
-  if (shadow_colour && sdl_system_.text().font_shadow()) {
-    SDL_Color sdl_shadow_colour;
-    RGBColourToSDLColor(*shadow_colour, &sdl_shadow_colour);
-
-    shadow.reset(
-        TTF_RenderUTF8_Blended(font.get(), current.c_str(), sdl_shadow_colour),
-        SDL_FreeSurface);
-  }
-
-  if (italic) {
-    TTF_SetFontStyle(font.get(), TTF_STYLE_NORMAL);
-  }
-
   Point insertion(insertion_point_x, insertion_point_y);
 
-  if (shadow) {
-    Size offset(shadow->w, shadow->h);
-    sdl_surface->blitFROMSurface(shadow.get(),
-                                 Rect(Point(0, 0), offset),
-                                 Rect(insertion + Point(2, 2), offset),
-                                 255);
-  }
+  if (shadow_colour && sdl_system_.text().font_shadow())
+    DrawGlyph(*glyph, *shadow_colour, insertion + Point(2, 2), sdl_surface);
 
-  Size size(character->w, character->h);
-  sdl_surface->blitFROMSurface(
-      character.get(), Rect(Point(0, 0), size), Rect(insertion, size), 255);
-  return size;
+  DrawGlyph(*glyph, font_colour, insertion, sdl_surface);
+  return glyph->size;
 }
 
 int SDLTextSystem::GetCharWidth(int size, uint16_t codepoint) {
@@ -173,6 +196,80 @@ std::shared_ptr<TTF_Font> SDLTextSystem::GetFontOfSize(int size) {
   }
 }
 
+const Glyph* SDLTextSystem::GetGlyph(const std::string& utf8str,
+                                     int size,
+                                     bool italic) {
+  int style = italic ? TTF_STYLE_ITALIC : TTF_STYLE_NORMAL;
+  const Glyph* cached = glyph_cache_.Fetch(utf8str, size, style);
+  if (cached)
+    return cached;
+
+  std::shared_ptr<TTF_Font> font = GetFontOfSize(size);
+  if (italic)
+    TTF_SetFontStyle(font.get(), TTF_STYLE_ITALIC);
+
+  // Render in white; only the coverage in the alpha channel is kept.
+  SDL_Color white = {255, 255, 255, 0};
+  std::shared_ptr<SDL_Surface> rendered(
+      TTF_RenderUTF8_Blended(font.get(), utf8str.c_str(), white),
+      SDL_FreeSurface);
+
+  if (italic)
+    TTF_SetFontStyle(font.get(), TTF_STYLE_NORMAL);
+
+  if (rendered == NULL)
+    return NULL;
+
+  Glyph glyph;
+  glyph.size = Size(rendered->w, rendered->h);
+  glyph.coverage.resize(size_t(rendered->w) * rendered->h);
+
+  if (SDL_MUSTLOCK(rendered.get()))
+    SDL_LockSurface(rendered.get());
+
+  SDL_PixelFormat* format = rendered->format;
+  uint8_t* coverage = glyph.coverage.data();
+  for (int y = 0; y < rendered->h; ++y) {
+    const Uint32* row = reinterpret_cast<const Uint32*>(
+        static_cast<const Uint8*>(rendered->pixels) + y * rendered->pitch);
+    for (int x = 0; x < rendered->w; ++x)
+      *coverage++ = (row[x] & format->Amask) >> format->Ashift;
+  }
+
+  if (SDL_MUSTLOCK(rendered.get()))
+    SDL_UnlockSurface(rendered.get());
+
+  return glyph_cache_.Insert(utf8str, size, style, std::move(glyph));
+}
+
+void SDLTextSystem::DrawGlyph(const Glyph& glyph,
+                              const RGBColour& colour,
+                              const Point& position,
+                              SDLSurface* destination) {
+  const Size& size = glyph.size;
+  if (size.width() <= 0 || size.height() <= 0)
+    return;
+
+  if (!scratch_ || scratch_->w < size.width() || scratch_->h < size.height()) {
+    int width = scratch_ ? std::max(scratch_->w, size.width()) : size.width();
+    int height =
+        scratch_ ? std::max(scratch_->h, size.height()) : size.height();
+    scratch_.reset(CreateTextSurface(width, height), SDL_FreeSurface);
+  }
+
+  FillTextSurface(glyph, colour, scratch_.get());
+  destination->blitFROMSurface(
+      scratch_.get(), Rect(Point(0, 0), size), Rect(position, size), 255);
+}
+
+SDL_Surface* SDLTextSystem::CreateGlyphSurface(const Glyph& glyph,
+                                               const RGBColour& colour) {
+  SDL_Surface* surface =
+      CreateTextSurface(glyph.size.width(), glyph.size.height());
+  FillTextSurface(glyph, colour, surface);
+  return surface;
+}
+
 bool SDLTextSystem::FontIsMonospaced() {
   return is_monospace_ ? *is_monospace_ : false;
 }
@@ -31,12 +31,15 @@
 #include <SDL/SDL_ttf.h>
 
 #include <map>
+#include <memory>
 #include <string>
 
+#include "systems/base/glyph_cache.h"
 #include "systems/base/text_system.h"
 
 class Point;
 class RLMachine;
+class SDLSurface;
 class SDLSystem;
 class SDLTextWindow;
 class TextWindow;
@@ -62,11 +65,34 @@ class SDLTextSystem : public TextSystem {
   // Returns (and caches) a SDL_ttf font object for a font of |size|.
   std::shared_ptr<TTF_Font> GetFontOfSize(int size);
 
+  // Returns the rasterization of |utf8str| at |size|, rasterizing it only if
+  // it isn't already in the glyph cache. Returns NULL if the font can't
+  // render it. The pointer is only valid until the next call.
+  const Glyph* GetGlyph(const std::string& utf8str, int size, bool italic);
+
+  // Draws |glyph| in |colour| onto |destination| with its top left corner at
+  // |position|.
+  void DrawGlyph(const Glyph& glyph,
+                 const RGBColour& colour,
+                 const Point& position,
+                 SDLSurface* destination);
+
+  // Returns a new surface, owned by the caller, holding |glyph| in |colour|.
+  SDL_Surface* CreateGlyphSurface(const Glyph& glyph, const RGBColour& colour);
+
+  const GlyphCache& glyph_cache() const { return glyph_cache_; }
+
  private:
   // Font storage.
   typedef std::map<int, std::shared_ptr<TTF_Font>> FontSizeMap;
   FontSizeMap map_;
 
+  GlyphCache glyph_cache_;
+
+  // Reused by DrawGlyph() to colour glyphs before blitting them, so drawing
+  // a cached glyph doesn't allocate. Grows to fit the largest glyph drawn.
+  std::shared_ptr<SDL_Surface> scratch_;
+
   SDLSystem& sdl_system_;
 
   std::unique_ptr<bool> is_monospace_;
@@ -28,7 +28,6 @@
 #include "systems/sdl/sdl_text_window.h"
 
 #include <SDL/SDL_opengl.h>
-#include <SDL/SDL_ttf.h>
 
 #include <string>
 #include <vector>
@@ -79,15 +78,13 @@ void SDLTextWindow::RenderNameInBox(const std::string& utf8str) {
 
 void SDLTextWindow::AddSelectionItem(const std::string& utf8str,
                                      int selection_id) {
-  std::shared_ptr<TTF_Font> font =
-      sdl_system_.text().GetFontOfSize(font_size_in_pixels());
-
   // Render the incoming string for both selected and not-selected.
-  SDL_Color colour;
-  RGBColourToSDLColor(font_colour_, &colour);
-
-  SDL_Surface* normal =
-      TTF_RenderUTF8_Blended(font.get(), utf8str.c_str(), colour);
+  SDLTextSystem& text_system = sdl_system_.text();
+  const Glyph* glyph =
+      text_system.GetGlyph(utf8str, font_size_in_pixels(), false);
+  if (!glyph)
+    throw SystemError("Couldn't render selection \"" + utf8str + "\"");
+  SDL_Surface* normal = text_system.CreateGlyphSurface(*glyph, font_colour_);
 
   // Copy and invert the surface for whatever.
   SDL_Surface* inverted = AlphaInvert(normal);
@@ -112,8 +109,6 @@ void SDLTextWindow::AddSelectionItem(const std::string& utf8str,
 
 void SDLTextWindow::DisplayRubyText(const std::string& utf8str) {
   if (ruby_begin_point_ != -1) {
-    std::shared_ptr<TTF_Font> font =
-        sdl_system_.text().GetFontOfSize(ruby_text_size());
     int end_point = text_insertion_point_x_ - x_spacing_;
 
     if (ruby_begin_point_ > end_point) {
@@ -121,26 +116,23 @@ void SDLTextWindow::DisplayRubyText(const std::string& utf8str) {
       throw rlvm::Exception("We don't handle ruby across line breaks yet!");
     }
 
-    SDL_Color colour;
-    RGBColourToSDLColor(font_colour_, &colour);
-    SDL_Surface* tmp =
-        TTF_RenderUTF8_Blended(font.get(), utf8str.c_str(), colour);
-
     // Render glyph to surface
-    int w = tmp->w;
-    int h = tmp->h;
-    int height_location = text_insertion_point_y_ - ruby_text_size();
-    int width_start =
-        int(ruby_begin_point_ + ((end_point - ruby_begin_point_) * 0.5f) -
-            (w * 0.5f));
-    surface_->blitFROMSurface(
-        tmp,
-        Rect(Point(0, 0), Size(w, h)),
-        Rect(Point(width_start, height_location), Size(w, h)),
-        255);
-    SDL_FreeSurface(tmp);
-
-    system_.graphics().MarkScreenAsDirty(GUT_TEXTSYS);
+    SDLTextSystem& text_system = sdl_system_.text();
+    const Glyph* glyph = text_system.GetGlyph(utf8str, ruby_text_size(), false);
+    if (glyph) {
+      int w = glyph->size.width();
+      int height_location = text_insertion_point_y_ - ruby_text_size();
+      int width_start =
+          int(ruby_begin_point_ + ((end_point - ruby_begin_point_) * 0.5f) -
+              (w * 0.5f));
+      text_system.DrawGlyph(*glyph,
+                            font_colour_,
+                            Point(width_start, height_location),
+                            surface_.get());
+    }
+
+    system_.graphics().MarkScreenAreaAsDirty(GUT_TEXTSYS,
+                                             GetScreenFootprint());
 
     ruby_begin_point_ = -1;
   }
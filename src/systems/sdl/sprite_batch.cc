@@ -0,0 +1,129 @@
+// -*- Mode: C++; tab-width:2; indent-tabs-mode: nil; c-basic-offset: 2 -*-
+// vi:tw=80:et:ts=2:sts=2
+//
+// -----------------------------------------------------------------------
+//
+// This file is part of RLVM, a RealLive virtual machine clone.
+//
+// -----------------------------------------------------------------------
+//
+// Copyright (C) 2015 Elliot Glaysher
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA.
+//
+// -----------------------------------------------------------------------
+
+#include "GL/glew.h"
+
+#include "systems/sdl/sprite_batch.h"
+
+#include <sstream>
+
+#include "systems/base/system_error.h"
+#include "systems/sdl/sdl_utils.h"
+
+SpriteBatch* SpriteBatch::s_current_ = NULL;
+
+SpriteBatch::SpriteBatch()
+    : texture_(0), composite_mode_(0), quad_count_(0), draw_call_count_(0) {}
+
+SpriteBatch::~SpriteBatch() {
+  if (s_current_ == this)
+    s_current_ = NULL;
+}
+
+void SpriteBatch::Begin() {
+  vertices_.clear();
+  quad_count_ = 0;
+  draw_call_count_ = 0;
+  s_current_ = this;
+}
+
+void SpriteBatch::End() {
+  Flush();
+  if (s_current_ == this)
+    s_current_ = NULL;
+}
+
+void SpriteBatch::AddQuad(GLuint texture,
+                          int composite_mode,
+                          const Vertex quad[4]) {
+  if (composite_mode < 0 || composite_mode > 2) {
+    std::ostringstream oss;
+    oss << "Invalid composite_mode in render: " << composite_mode;
+    throw SystemError(oss.str());
+  }
+
+  if (!vertices_.empty() &&
+      (texture != texture_ || composite_mode != composite_mode_)) {
+    Flush();
+  }
+
+  texture_ = texture;
+  composite_mode_ = composite_mode;
+  vertices_.insert(vertices_.end(), quad, quad + 4);
+  quad_count_++;
+}
+
+void SpriteBatch::Flush() {
+  if (vertices_.empty())
+    return;
+
+  glBindTexture(GL_TEXTURE_2D, texture_);
+
+  // Make this so that when we have composite 1, we're doing a pure
+  // additive blend, (ignoring the alpha channel?)
+  switch (composite_mode_) {
+    case 0:
+      glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+      break;
+    case 1:
+      glBlendFunc(GL_SRC_ALPHA, GL_ONE);
+      break;
+    case 2:
+      glBlendFunc(GL_SRC_ALPHA, GL_ONE);
+      glBlendEquation(GL_FUNC_REVERSE_SUBTRACT);
+      break;
+  }
+
+  glEnableClientState(GL_VERTEX_ARRAY);
+  glEnableClientState(GL_TEXTURE_COORD_ARRAY);
+  glEnableClientState(GL_COLOR_ARRAY);
+  glVertexPointer(2, GL_FLOAT, sizeof(Vertex), &vertices_[0].x);
+  glTexCoordPointer(2, GL_FLOAT, sizeof(Vertex), &vertices_[0].u);
+  glColorPointer(4, GL_UNSIGNED_BYTE, sizeof(Vertex), &vertices_[0].r);
+
+  glDrawArrays(GL_QUADS, 0, vertices_.size());
+
+  glDisableClientState(GL_COLOR_ARRAY);
+  glDisableClientState(GL_TEXTURE_COORD_ARRAY);
+  glDisableClientState(GL_VERTEX_ARRAY);
+
+  // The current colour is undefined after drawing from a colour array.
+  glColor4ub(255, 255, 255, 255);
+  glBlendEquation(GL_FUNC_ADD);
+  glBlendFunc(GL_ONE, GL_ZERO);
+
+  vertices_.clear();
+  draw_call_count_++;
+
+  DebugShowGLErrors();
+}
+
+// static
+void SpriteBatch::FlushCurrent() {
+  if (s_current_)
+    s_current_->Flush();
+}
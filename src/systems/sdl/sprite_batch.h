@@ -0,0 +1,89 @@
+// -*- Mode: C++; tab-width:2; indent-tabs-mode: nil; c-basic-offset: 2 -*-
+// vi:tw=80:et:ts=2:sts=2
+//
+// -----------------------------------------------------------------------
+//
+// This file is part of RLVM, a RealLive virtual machine clone.
+//
+// -----------------------------------------------------------------------
+//
+// Copyright (C) 2015 Elliot Glaysher
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA.
+//
+// -----------------------------------------------------------------------
+
+#ifndef SRC_SYSTEMS_SDL_SPRITE_BATCH_H_
+#define SRC_SYSTEMS_SDL_SPRITE_BATCH_H_
+
+#include <SDL/SDL_opengl.h>
+
+#include <vector>
+
+// Collects the textured quads of graphics objects so that runs of objects
+// sharing a texture and composite mode are drawn with one glDrawArrays()
+// instead of a glBegin()/glEnd() pair and a round of state changes each.
+//
+// Quads are drawn in the order they were added, and a batch is flushed
+// whenever the texture or composite mode changes, so z-order is unaffected.
+// Anything that draws with OpenGL directly while a batch is active must call
+// FlushCurrent() first.
+class SpriteBatch {
+ public:
+  struct Vertex {
+    GLfloat x, y;
+    GLfloat u, v;
+    GLubyte r, g, b, a;
+  };
+
+  SpriteBatch();
+  ~SpriteBatch();
+
+  // Makes this the batch that Texture::RenderToScreenAsObject() adds to.
+  void Begin();
+
+  // Draws whatever is queued and stops batching.
+  void End();
+
+  // Queues a quad, given as its four corners in drawing order.
+  void AddQuad(GLuint texture, int composite_mode, const Vertex quad[4]);
+
+  // Draws everything queued so far.
+  void Flush();
+
+  // Number of quads and draw calls since the last Begin().
+  int quad_count() const { return quad_count_; }
+  int draw_call_count() const { return draw_call_count_; }
+
+  // The batch between Begin() and End(), or NULL.
+  static SpriteBatch* current() { return s_current_; }
+
+  // Flushes the current batch, if any.
+  static void FlushCurrent();
+
+ private:
+  std::vector<Vertex> vertices_;
+
+  // State shared by everything in |vertices_|.
+  GLuint texture_;
+  int composite_mode_;
+
+  int quad_count_;
+  int draw_call_count_;
+
+  static SpriteBatch* s_current_;
+};
+
+#endif  // SRC_SYSTEMS_SDL_SPRITE_BATCH_H_
@@ -48,7 +48,9 @@
 #include "systems/sdl/sdl_surface.h"
 #include "systems/sdl/sdl_utils.h"
 #include "systems/sdl/shaders.h"
+#include "systems/sdl/sprite_batch.h"
 #include "systems/sdl/texture.h"
+#include "systems/sdl/texture_atlas.h"
 
 unsigned int Texture::s_screen_width = 0;
 unsigned int Texture::s_screen_height = 0;
@@ -85,7 +87,39 @@ Texture::Texture(SDL_Surface* surface,
       texture_width_(SafeSize(logical_width_)),
       texture_height_(SafeSize(logical_height_)),
       back_texture_id_(0),
+      atlas_x_(0),
+      atlas_y_(0),
       is_upside_down_(false) {
+  // Small, whole images share a page of the texture atlas.
+  TextureAtlas* atlas = TextureAtlas::current();
+  if (atlas && w == total_width_ && h == total_height_) {
+    atlas_allocation_ =
+        atlas->Allocate(Size(w, h), bytes_per_pixel, byte_order, byte_type);
+  }
+
+  if (atlas_allocation_) {
+    texture_id_ = atlas_allocation_->texture_id();
+    texture_width_ = atlas_allocation_->page_size().width();
+    texture_height_ = atlas_allocation_->page_size().height();
+    atlas_x_ = atlas_allocation_->rect().x();
+    atlas_y_ = atlas_allocation_->rect().y();
+
+    glBindTexture(GL_TEXTURE_2D, texture_id_);
+    SDL_LockSurface(surface);
+    glTexSubImage2D(GL_TEXTURE_2D,
+                    0,
+                    atlas_x_,
+                    atlas_y_,
+                    surface->w,
+                    surface->h,
+                    byte_order,
+                    byte_type,
+                    surface->pixels);
+    DebugShowGLErrors();
+    SDL_UnlockSurface(surface);
+    return;
+  }
+
   glGenTextures(1, &texture_id_);
   glBindTexture(GL_TEXTURE_2D, texture_id_);
   DebugShowGLErrors();
@@ -109,8 +143,8 @@ Texture::Texture(SDL_Surface* surface,
 
     glTexSubImage2D(GL_TEXTURE_2D,
                     0,
-                    0,
-                    0,
+                    atlas_x_,
+                    atlas_y_,
                     surface->w,
                     surface->h,
                     byte_order,
@@ -169,6 +203,8 @@ Texture::Texture(render_to_texture, int width, int height)
       texture_height_(0),
       texture_id_(0),
       back_texture_id_(0),
+      atlas_x_(0),
+      atlas_y_(0),
       is_upside_down_(true) {
   glGenTextures(1, &texture_id_);
   glBindTexture(GL_TEXTURE_2D, texture_id_);
@@ -201,7 +237,12 @@ Texture::Texture(render_to_texture, int width, int height)
 // -----------------------------------------------------------------------
 
 Texture::~Texture() {
-  glDeleteTextures(1, &texture_id_);
+  SpriteBatch::FlushCurrent();
+
+  // Atlas pages are owned by the atlas; dropping |atlas_allocation_| frees
+  // our region of it.
+  if (!atlas_allocation_)
+    glDeleteTextures(1, &texture_id_);
 
   if (back_texture_id_)
     glDeleteTextures(1, &back_texture_id_);
@@ -232,6 +273,8 @@ void Texture::reupload(SDL_Surface* surface,
                        unsigned int bytes_per_pixel,
                        int byte_order,
                        int byte_type) {
+  SpriteBatch::FlushCurrent();
+
   glBindTexture(GL_TEXTURE_2D, texture_id_);
 
   if (w == total_width_ && h == total_height_) {
@@ -239,8 +282,8 @@ void Texture::reupload(SDL_Surface* surface,
 
     glTexSubImage2D(GL_TEXTURE_2D,
                     0,
-                    0,
-                    0,
+                    atlas_x_,
+                    atlas_y_,
                     surface->w,
                     surface->h,
                     byte_order,
@@ -271,8 +314,8 @@ void Texture::reupload(SDL_Surface* surface,
 
     glTexSubImage2D(GL_TEXTURE_2D,
                     0,
-                    offset_x,
-                    offset_y,
+                    atlas_x_ + offset_x,
+                    atlas_y_ + offset_y,
                     w,
                     h,
                     byte_order,
@@ -305,6 +348,8 @@ std::string readTextFile(const std::string& file) {
 
 // This is really broken and brain dead.
 void Texture::RenderToScreen(const Rect& src, const Rect& dst, int opacity) {
+  SpriteBatch::FlushCurrent();
+
   int x1 = src.x(), y1 = src.y(), x2 = src.x2(), y2 = src.y2();
   int fdx1 = dst.x(), fdy1 = dst.y(), fdx2 = dst.x2(), fdy2 = dst.y2();
   if (!filterCoords(x1, y1, x2, y2, fdx1, fdy1, fdx2, fdy2))
@@ -312,10 +357,10 @@ void Texture::RenderToScreen(const Rect& src, const Rect& dst, int opacity) {
 
   // For the time being, we are dumb and assume that it's one texture
 
-  float thisx1 = float(x1) / texture_width_;
-  float thisy1 = float(y1) / texture_height_;
-  float thisx2 = float(x2) / texture_width_;
-  float thisy2 = float(y2) / texture_height_;
+  float thisx1 = float(x1 + atlas_x_) / texture_width_;
+  float thisy1 = float(y1 + atlas_y_) / texture_height_;
+  float thisx2 = float(x2 + atlas_x_) / texture_width_;
+  float thisy2 = float(y2 + atlas_y_) / texture_height_;
 
   if (is_upside_down_) {
     thisy1 = float(logical_height_ - y1) / texture_height_;
@@ -349,6 +394,8 @@ void Texture::RenderToScreenAsColorMask(const Rect& src,
                                         const Rect& dst,
                                         const RGBAColour& rgba,
                                         int filter) {
+  SpriteBatch::FlushCurrent();
+
   if (filter == 0) {
     if (GLEW_ARB_fragment_shader && GLEW_ARB_multitexture) {
       render_to_screen_as_colour_mask_subtractive_glsl(src, dst, rgba);
@@ -371,16 +418,29 @@ void Texture::render_to_screen_as_colour_mask_subtractive_glsl(
   if (!filterCoords(x1, y1, x2, y2, fdx1, fdy1, fdx2, fdy2))
     return;
 
-  float thisx1 = float(x1) / texture_width_;
-  float thisy1 = float(y1) / texture_height_;
-  float thisx2 = float(x2) / texture_width_;
-  float thisy2 = float(y2) / texture_height_;
+  float thisx1 = float(x1 + atlas_x_) / texture_width_;
+  float thisy1 = float(y1 + atlas_y_) / texture_height_;
+  float thisx2 = float(x2 + atlas_x_) / texture_width_;
+  float thisy2 = float(y2 + atlas_y_) / texture_height_;
 
   if (is_upside_down_) {
     thisy1 = float(logical_height_ - y1) / texture_height_;
     thisy2 = float(logical_height_ - y2) / texture_height_;
   }
 
+  // The back texture only covers this image, even when the image itself
+  // lives in a larger atlas page, so it gets its own coordinates.
+  int back_width = SafeSize(logical_width_);
+  int back_height = SafeSize(logical_height_);
+  float backx1 = float(x1) / back_width;
+  float backy1 = float(y1) / back_height;
+  float backx2 = float(x2) / back_width;
+  float backy2 = float(y2) / back_height;
+  if (is_upside_down_) {
+    backy1 = float(logical_height_ - y1) / back_height;
+    backy2 = float(logical_height_ - y2) / back_height;
+  }
+
   // If we haven't already, allocate video memory for the back
   // texture.
   //
@@ -396,8 +456,8 @@ void Texture::render_to_screen_as_colour_mask_subtractive_glsl(
     glTexImage2D(GL_TEXTURE_2D,
                  0,
                  GL_RGBA,
-                 texture_width_,
-                 texture_height_,
+                 back_width,
+                 back_height,
                  0,
                  GL_RGB,
                  GL_UNSIGNED_BYTE,
@@ -411,7 +471,7 @@ void Texture::render_to_screen_as_colour_mask_subtractive_glsl(
   int ystart = int(s_screen_height - fdy1 - (fdy2 - fdy1));
   int idx1 = int(fdx1);
   glCopyTexSubImage2D(
-      GL_TEXTURE_2D, 0, 0, 0, idx1, ystart, texture_width_, texture_height_);
+      GL_TEXTURE_2D, 0, 0, 0, idx1, ystart, back_width, back_height);
   DebugShowGLErrors();
 
   glUseProgramObjectARB(Shaders::getColorMaskProgram());
@@ -435,16 +495,16 @@ void Texture::render_to_screen_as_colour_mask_subtractive_glsl(
   glBegin(GL_QUADS);
   {
     glColorRGBA(rgba);
-    glMultiTexCoord2fARB(GL_TEXTURE0_ARB, thisx1, thisy2);
+    glMultiTexCoord2fARB(GL_TEXTURE0_ARB, backx1, backy2);
     glMultiTexCoord2fARB(GL_TEXTURE1_ARB, thisx1, thisy1);
     glVertex2i(fdx1, fdy1);
-    glMultiTexCoord2fARB(GL_TEXTURE0_ARB, thisx2, thisy2);
+    glMultiTexCoord2fARB(GL_TEXTURE0_ARB, backx2, backy2);
     glMultiTexCoord2fARB(GL_TEXTURE1_ARB, thisx2, thisy1);
     glVertex2i(fdx2, fdy1);
-    glMultiTexCoord2fARB(GL_TEXTURE0_ARB, thisx2, thisy1);
+    glMultiTexCoord2fARB(GL_TEXTURE0_ARB, backx2, backy1);
     glMultiTexCoord2fARB(GL_TEXTURE1_ARB, thisx2, thisy2);
     glVertex2i(fdx2, fdy2);
-    glMultiTexCoord2fARB(GL_TEXTURE0_ARB, thisx1, thisy1);
+    glMultiTexCoord2fARB(GL_TEXTURE0_ARB, backx1, backy1);
     glMultiTexCoord2fARB(GL_TEXTURE1_ARB, thisx1, thisy2);
     glVertex2i(fdx1, fdy2);
   }
@@ -476,10 +536,10 @@ void Texture::render_to_screen_as_colour_mask_subtractive_fallback(
   if (!filterCoords(x1, y1, x2, y2, fdx1, fdy1, fdx2, fdy2))
     return;
 
-  float thisx1 = float(x1) / texture_width_;
-  float thisy1 = float(y1) / texture_height_;
-  float thisx2 = float(x2) / texture_width_;
-  float thisy2 = float(y2) / texture_height_;
+  float thisx1 = float(x1 + atlas_x_) / texture_width_;
+  float thisy1 = float(y1 + atlas_y_) / texture_height_;
+  float thisx2 = float(x2 + atlas_x_) / texture_width_;
+  float thisy2 = float(y2 + atlas_y_) / texture_height_;
 
   if (is_upside_down_) {
     thisy1 = float(logical_height_ - y1) / texture_height_;
@@ -522,10 +582,10 @@ void Texture::render_to_screen_as_colour_mask_additive(const Rect& src,
   if (!filterCoords(x1, y1, x2, y2, fdx1, fdy1, fdx2, fdy2))
     return;
 
-  float thisx1 = float(x1) / texture_width_;
-  float thisy1 = float(y1) / texture_height_;
-  float thisx2 = float(x2) / texture_width_;
-  float thisy2 = float(y2) / texture_height_;
+  float thisx1 = float(x1 + atlas_x_) / texture_width_;
+  float thisy1 = float(y1 + atlas_y_) / texture_height_;
+  float thisx2 = float(x2 + atlas_x_) / texture_width_;
+  float thisy2 = float(y2 + atlas_y_) / texture_height_;
 
   if (is_upside_down_) {
     thisy1 = float(logical_height_ - y1) / texture_height_;
@@ -558,16 +618,18 @@ void Texture::render_to_screen_as_colour_mask_additive(const Rect& src,
 void Texture::RenderToScreen(const Rect& src,
                              const Rect& dst,
                              const int opacity[4]) {
+  SpriteBatch::FlushCurrent();
+
   // For the time being, we are dumb and assume that it's one texture
   int x1 = src.x(), y1 = src.y(), x2 = src.x2(), y2 = src.y2();
   int fdx1 = dst.x(), fdy1 = dst.y(), fdx2 = dst.x2(), fdy2 = dst.y2();
   if (!filterCoords(x1, y1, x2, y2, fdx1, fdy1, fdx2, fdy2))
     return;
 
-  float thisx1 = float(x1) / texture_width_;
-  float thisy1 = float(y1) / texture_height_;
-  float thisx2 = float(x2) / texture_width_;
-  float thisy2 = float(y2) / texture_height_;
+  float thisx1 = float(x1 + atlas_x_) / texture_width_;
+  float thisy1 = float(y1 + atlas_y_) / texture_height_;
+  float thisx2 = float(x2 + atlas_x_) / texture_width_;
+  float thisy2 = float(y2 + atlas_y_) / texture_height_;
 
   glBindTexture(GL_TEXTURE_2D, texture_id_);
 
@@ -620,11 +682,55 @@ void Texture::RenderToScreenAsObject(const GraphicsObject& go,
   }
 
   // Convert the pixel coordinates into [0,1) texture coordinates
-  float thisx1 = float(xSrc1) / texture_width_;
-  float thisy1 = float(ySrc1) / texture_height_;
-  float thisx2 = float(xSrc2) / texture_width_;
-  float thisy2 = float(ySrc2) / texture_height_;
+  float thisx1 = float(xSrc1 + atlas_x_) / texture_width_;
+  float thisy1 = float(ySrc1 + atlas_y_) / texture_height_;
+  float thisx2 = float(xSrc2 + atlas_x_) / texture_width_;
+  float thisy2 = float(ySrc2 + atlas_y_) / texture_height_;
+
+  int width = fdx2 - fdx1;
+  int height = fdy2 - fdy1;
+
+  // Rotate the texture around the point (origin + position + reporigin)
+  float x_rep = (width / 2.0f) + go.rep_origin_x();
+  float y_rep = (height / 2.0f) + go.rep_origin_y();
+
+  // RealLive has its own complex shading/tinting system which we implement
+  // in a shader if available. It's costly enough that we make sure we need
+  // to use it.
+  bool needs_shader =
+      (go.light() || go.tint() != RGBColour::Black() ||
+       go.colour() != RGBAColour::Clear() || go.mono() || go.invert()) &&
+      GLEW_ARB_fragment_shader && GLEW_ARB_multitexture;
+
+  // Objects that don't need the shader only differ in geometry and alpha, so
+  // do the transform here and let the batch draw runs of them at once.
+  SpriteBatch* batch = SpriteBatch::current();
+  if (batch && !needs_shader) {
+    float radians = go.rotation() / 10.0f * M_PI / 180.0f;
+    float cos_r = std::cos(radians);
+    float sin_r = std::sin(radians);
+
+    const float corners[4][4] = {{0, 0, thisx1, thisy1},
+                                 {float(width), 0, thisx2, thisy1},
+                                 {float(width), float(height), thisx2, thisy2},
+                                 {0, float(height), thisx1, thisy2}};
+    SpriteBatch::Vertex quad[4];
+    for (int i = 0; i < 4; ++i) {
+      float x = corners[i][0] - x_rep;
+      float y = corners[i][1] - y_rep;
+      quad[i].x = fdx1 + x_rep + x * cos_r - y * sin_r;
+      quad[i].y = fdy1 + y_rep + x * sin_r + y * cos_r;
+      quad[i].u = corners[i][2];
+      quad[i].v = corners[i][3];
+      quad[i].r = quad[i].g = quad[i].b = 255;
+      quad[i].a = alpha;
+    }
 
+    batch->AddQuad(texture_id_, go.composite_mode(), quad);
+    return;
+  }
+
+  SpriteBatch::FlushCurrent();
   glBindTexture(GL_TEXTURE_2D, texture_id_);
 
   glPushMatrix();
@@ -632,24 +738,12 @@ void Texture::RenderToScreenAsObject(const GraphicsObject& go,
     // Translate to where the object starts.
     glTranslatef(fdx1, fdy1, 0);
 
-    int width = fdx2 - fdx1;
-    int height = fdy2 - fdy1;
-
-    // Rotate the texture around the point (origin + position + reporigin)
-    float x_rep = (width / 2.0f) + go.rep_origin_x();
-    float y_rep = (height / 2.0f) + go.rep_origin_y();
-
     glTranslatef(x_rep, y_rep, 0);
     glRotatef(float(go.rotation()) / 10, 0, 0, 1);
     glTranslatef(-x_rep, -y_rep, 0);
 
-    // RealLive has its own complex shading/tinting system which we implement
-    // in a shader if available. It's costly enough that we make sure we need
-    // to use it.
     bool using_shader = false;
-    if ((go.light() || go.tint() != RGBColour::Black() ||
-         go.colour() != RGBAColour::Clear() || go.mono() || go.invert()) &&
-        GLEW_ARB_fragment_shader && GLEW_ARB_multitexture) {
+    if (needs_shader) {
       // Image
       glActiveTexture(GL_TEXTURE0_ARB);
       glEnable(GL_TEXTURE_2D);
@@ -33,6 +33,8 @@
 #include <memory>
 #include <string>
 
+#include "systems/sdl/texture_atlas.h"
+
 struct SDL_Surface;
 class SDLSurface;
 class GraphicsObject;
@@ -80,6 +82,14 @@ class Texture {
   int height() { return logical_height_; }
   GLuint textureId() { return texture_id_; }
 
+  // Bytes of video memory used by the RGBA texture. Images stored in the
+  // texture atlas only account for their own region of the shared page.
+  size_t GetMemoryUsage() const {
+    if (atlas_allocation_)
+      return size_t(logical_width_) * logical_height_ * 4;
+    return size_t(texture_width_) * texture_height_ * 4;
+  }
+
   void RenderToScreenAsObject(const GraphicsObject& go,
                               const SDLSurface& surface,
                               const Rect& srcRect,
@@ -139,6 +149,14 @@ class Texture {
 
   GLuint back_texture_id_;
 
+  // When this image was small enough to go into the TextureAtlas, the region
+  // of the shared page it occupies. |texture_id_| and |texture_width_| /
+  // |texture_height_| then refer to the page, and |atlas_x_| / |atlas_y_| are
+  // the image's offset within it.
+  std::unique_ptr<TextureAtlas::Allocation> atlas_allocation_;
+  int atlas_x_;
+  int atlas_y_;
+
   // Is this texture upside down? (Because it's a screenshot, etc.)
   bool is_upside_down_;
 
@@ -0,0 +1,194 @@
+// -*- Mode: C++; tab-width:2; indent-tabs-mode: nil; c-basic-offset: 2 -*-
+// vi:tw=80:et:ts=2:sts=2
+//
+// -----------------------------------------------------------------------
+//
+// This file is part of RLVM, a RealLive virtual machine clone.
+//
+// -----------------------------------------------------------------------
+//
+// Copyright (C) 2015 Elliot Glaysher
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA.
+// -----------------------------------------------------------------------
+
+
+#include "GL/glew.h"
+
+#include "systems/sdl/texture_atlas.h"
+
+#include <algorithm>
+#include <vector>
+
+#include "systems/sdl/sdl_utils.h"
+
+TextureAtlas* TextureAtlas::s_current_ = NULL;
+
+// -----------------------------------------------------------------------
+// TextureAtlas::Page
+// -----------------------------------------------------------------------
+
+TextureAtlas::Page::Page(const Size& size,
+                         GLenum internal_format,
+                         GLint byte_order,
+                         GLint byte_type)
+    : texture_id(0),
+      internal_format(internal_format),
+      byte_order(byte_order),
+      byte_type(byte_type),
+      packer(size) {
+  glGenTextures(1, &texture_id);
+  glBindTexture(GL_TEXTURE_2D, texture_id);
+  DebugShowGLErrors();
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+  // Contents are undefined until each allocation clears its own region.
+  glTexImage2D(GL_TEXTURE_2D,
+               0,
+               internal_format,
+               size.width(),
+               size.height(),
+               0,
+               byte_order,
+               byte_type,
+               NULL);
+  DebugShowGLErrors();
+}
+
+TextureAtlas::Page::~Page() {
+  if (texture_id)
+    glDeleteTextures(1, &texture_id);
+}
+
+// -----------------------------------------------------------------------
+// TextureAtlas::Allocation
+// -----------------------------------------------------------------------
+
+TextureAtlas::Allocation::Allocation(const std::shared_ptr<Page>& page,
+                                     const Rect& padded_rect,
+                                     const Rect& rect)
+    : page_(page), padded_rect_(padded_rect), rect_(rect) {}
+
+TextureAtlas::Allocation::~Allocation() { page_->packer.Release(padded_rect_); }
+
+GLuint TextureAtlas::Allocation::texture_id() const {
+  return page_->texture_id;
+}
+
+const Size& TextureAtlas::Allocation::page_size() const {
+  return page_->packer.size();
+}
+
+// -----------------------------------------------------------------------
+// TextureAtlas
+// -----------------------------------------------------------------------
+
+TextureAtlas::TextureAtlas() { s_current_ = this; }
+
+TextureAtlas::~TextureAtlas() {
+  if (s_current_ == this)
+    s_current_ = NULL;
+}
+
+std::unique_ptr<TextureAtlas::Allocation> TextureAtlas::Allocate(
+    const Size& size,
+    GLenum internal_format,
+    GLint byte_order,
+    GLint byte_type) {
+  if (size.width() > kMaxImageSize || size.height() > kMaxImageSize)
+    return nullptr;
+
+  TrimEmptyPages();
+
+  Size padded_size = size + Size(kPadding * 2, kPadding * 2);
+  std::shared_ptr<Page> page;
+  Rect padded_rect;
+  for (const std::shared_ptr<Page>& candidate : pages_) {
+    if (candidate->internal_format == internal_format &&
+        candidate->byte_order == byte_order &&
+        candidate->byte_type == byte_type &&
+        candidate->packer.Allocate(padded_size, &padded_rect)) {
+      page = candidate;
+      break;
+    }
+  }
+
+  if (!page) {
+    if (static_cast<int>(pages_.size()) >= kMaxPages)
+      return nullptr;
+
+    int page_size = GetMaxTextureSize();
+    if (page_size > kPageSize)
+      page_size = kPageSize;
+    page = std::make_shared<Page>(
+        Size(page_size, page_size), internal_format, byte_order, byte_type);
+    if (!page->packer.Allocate(padded_size, &padded_rect))
+      return nullptr;
+    pages_.push_back(page);
+  }
+
+  // Clear the region, gutter included, since it may hold an old image.
+  // Every format we upload with is four bytes per pixel.
+  std::vector<char> zeros(padded_size.width() * padded_size.height() * 4, 0);
+  glBindTexture(GL_TEXTURE_2D, page->texture_id);
+  glTexSubImage2D(GL_TEXTURE_2D,
+                  0,
+                  padded_rect.x(),
+                  padded_rect.y(),
+                  padded_rect.width(),
+                  padded_rect.height(),
+                  byte_order,
+                  byte_type,
+                  zeros.data());
+  DebugShowGLErrors();
+
+  Rect rect = Rect::REC(padded_rect.x() + kPadding,
+                        padded_rect.y() + kPadding,
+                        size.width(),
+                        size.height());
+  return std::unique_ptr<Allocation>(new Allocation(page, padded_rect, rect));
+}
+
+void TextureAtlas::Reset() {
+  for (const std::shared_ptr<Page>& page : pages_)
+    page->texture_id = 0;
+  pages_.clear();
+}
+
+size_t TextureAtlas::GetMemoryUsage() const {
+  size_t bytes = 0;
+  for (const std::shared_ptr<Page>& page : pages_) {
+    bytes += size_t(page->packer.size().width()) *
+             page->packer.size().height() * 4;
+  }
+  return bytes;
+}
+
+void TextureAtlas::TrimEmptyPages() {
+  bool kept_one = false;
+  pages_.erase(std::remove_if(pages_.begin(),
+                              pages_.end(),
+                              [&](const std::shared_ptr<Page>& page) {
+                                if (!page->packer.empty())
+                                  return false;
+                                if (!kept_one) {
+                                  kept_one = true;
+                                  return false;
+                                }
+                                return true;
+                              }),
+               pages_.end());
+}
@@ -0,0 +1,134 @@
+// -*- Mode: C++; tab-width:2; indent-tabs-mode: nil; c-basic-offset: 2 -*-
+// vi:tw=80:et:ts=2:sts=2
+//
+// -----------------------------------------------------------------------
+//
+// This file is part of RLVM, a RealLive virtual machine clone.
+//
+// -----------------------------------------------------------------------
+//
+// Copyright (C) 2015 Elliot Glaysher
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA.
+// -----------------------------------------------------------------------
+
+
+#ifndef SRC_SYSTEMS_SDL_TEXTURE_ATLAS_H_
+#define SRC_SYSTEMS_SDL_TEXTURE_ATLAS_H_
+
+#include <SDL/SDL_opengl.h>
+
+#include <memory>
+#include <vector>
+
+#include "systems/base/rect.h"
+#include "systems/base/rect_packer.h"
+
+// Packs small images (buttons, digit sprites, text window buttons, etc.)
+// into shared OpenGL textures, so that a screen full of them costs a handful
+// of textures and binds instead of one each.
+//
+// Each image is surrounded by a transparent gutter so linear filtering
+// doesn't bleed its neighbours into it. Space is given back when the
+// Allocation is destroyed, and pages with nothing left on them are freed
+// the next time the atlas needs room.
+class TextureAtlas {
+ private:
+  struct Page;
+
+ public:
+  // Images larger than this in either dimension get their own texture.
+  static const int kMaxImageSize = 256;
+
+  // Width and height of each page, if the driver allows it.
+  static const int kPageSize = 1024;
+
+  // Transparent pixels around each image.
+  static const int kPadding = 1;
+
+  // Upper limit on the number of pages; once reached, new images get their
+  // own texture until space is freed.
+  static const int kMaxPages = 8;
+
+  // A region of a page, owned by a single Texture.
+  class Allocation {
+   public:
+    ~Allocation();
+
+    GLuint texture_id() const;
+
+    // Location of the image in the page, not including the gutter.
+    const Rect& rect() const { return rect_; }
+
+    const Size& page_size() const;
+
+   private:
+    friend class TextureAtlas;
+    Allocation(const std::shared_ptr<Page>& page,
+               const Rect& padded_rect,
+               const Rect& rect);
+
+    std::shared_ptr<Page> page_;
+    Rect padded_rect_;
+    Rect rect_;
+  };
+
+  TextureAtlas();
+  ~TextureAtlas();
+
+  // Finds room for a |size| image stored with the given glTexImage2D()
+  // parameters. Returns NULL when the image should get its own texture.
+  std::unique_ptr<Allocation> Allocate(const Size& size,
+                                       GLenum internal_format,
+                                       GLint byte_order,
+                                       GLint byte_type);
+
+  // Forgets all pages without deleting their textures. Called when the
+  // OpenGL context is recreated and the old texture names are meaningless.
+  void Reset();
+
+  int page_count() const { return pages_.size(); }
+
+  // Bytes of video memory used by all pages.
+  size_t GetMemoryUsage() const;
+
+  // The atlas owned by the graphics system, or NULL.
+  static TextureAtlas* current() { return s_current_; }
+
+ private:
+  struct Page {
+    Page(const Size& size,
+         GLenum internal_format,
+         GLint byte_order,
+         GLint byte_type);
+    ~Page();
+
+    GLuint texture_id;
+    GLenum internal_format;
+    GLint byte_order;
+    GLint byte_type;
+    RectPacker packer;
+  };
+
+  // Frees all empty pages but one, so a screen that keeps swapping a single
+  // button doesn't recreate a page each time.
+  void TrimEmptyPages();
+
+  std::vector<std::shared_ptr<Page>> pages_;
+
+  static TextureAtlas* s_current_;
+};
+
+#endif  // SRC_SYSTEMS_SDL_TEXTURE_ATLAS_H_
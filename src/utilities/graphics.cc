@@ -37,22 +37,24 @@
 #include "systems/base/system_error.h"
 
 std::vector<int> GetSELEffect(RLMachine& machine, int selNum) {
+  static GameexeIndexedKey sel_key("SEL");
+  static GameexeIndexedKey selr_key("SELR");
   Gameexe& gexe = machine.system().gameexe();
   std::vector<int> selEffect;
 
-  if (gexe("SEL", selNum).Exists()) {
-    selEffect = gexe("SEL", selNum).ToIntVector();
+  if (sel_key(gexe, selNum).Exists()) {
+    selEffect = sel_key(gexe, selNum).ToIntVector();
     grp_to_rec_coordinates(selEffect[0], selEffect[1], selEffect[2], selEffect[3]);
-  } else if (gexe("SELR", selNum).Exists()) {
-    selEffect = gexe("SELR", selNum).ToIntVector();
+  } else if (selr_key(gexe, selNum).Exists()) {
+    selEffect = selr_key(gexe, selNum).ToIntVector();
   } else {
     // Can't find the specified #SEL effect. See if there's a #SEL.000 effect:
-    if (gexe("SEL", 0).Exists()) {
-      selEffect = gexe("SEL", 0).ToIntVector();
+    if (sel_key(gexe, 0).Exists()) {
+      selEffect = sel_key(gexe, 0).ToIntVector();
       grp_to_rec_coordinates(
           selEffect[0], selEffect[1], selEffect[2], selEffect[3]);
-    } else if (gexe("SELR", 0).Exists()) {
-      selEffect = gexe("SELR", 0).ToIntVector();
+    } else if (selr_key(gexe, 0).Exists()) {
+      selEffect = selr_key(gexe, 0).ToIntVector();
     } else {
       // Crap! Couldn't fall back on the default one either, so instead return
       // a SEL vector that is a screenwide, short fade because we absolutely
@@ -0,0 +1,155 @@
+// -*- Mode: C++; tab-width:2; indent-tabs-mode: nil; c-basic-offset: 2 -*-
+// vi:tw=80:et:ts=2:sts=2
+//
+// -----------------------------------------------------------------------
+//
+// This file is part of RLVM, a RealLive virtual machine clone.
+//
+// -----------------------------------------------------------------------
+//
+// Copyright (C) 2015 Elliot Glaysher
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA.
+// -----------------------------------------------------------------------
+
+
+#ifndef SRC_UTILITIES_SIZED_LRU_CACHE_H_
+#define SRC_UTILITIES_SIZED_LRU_CACHE_H_
+
+#include <cstddef>
+#include <functional>
+#include <list>
+#include <unordered_map>
+#include <utility>
+
+// Least recently used ordering plus byte accounting for caches which are
+// limited by memory instead of by entry count. Every entry carries a weight
+// in bytes supplied by the owner; the owner decides when it is over budget
+// and calls EvictOldest() until it isn't. Values live in list nodes, so a
+// pointer returned by Fetch() or Insert() survives other entries being
+// touched, inserted or evicted.
+template <typename Key, typename Value, typename Hash = std::hash<Key>>
+class SizedLRUCache {
+ public:
+  SizedLRUCache() : bytes_(0), hits_(0), misses_(0), evictions_(0) {}
+
+  // Returns the value under |key| and marks it as the most recently used, or
+  // returns NULL. Counts as a hit or a miss.
+  Value* Fetch(const Key& key) {
+    auto it = index_.find(key);
+    if (it == index_.end()) {
+      misses_++;
+      return NULL;
+    }
+
+    hits_++;
+    entries_.splice(entries_.begin(), entries_, it->second);
+    return &it->second->value;
+  }
+
+  // Whether |key| is cached. Doesn't touch the stats or the LRU order.
+  bool Contains(const Key& key) const {
+    return index_.find(key) != index_.end();
+  }
+
+  // Stores |value| under |key| as the most recently used entry, weighing
+  // |bytes|, and returns the stored copy. Replaces any previous entry.
+  Value& Insert(const Key& key, Value value, size_t bytes) {
+    Erase(key);
+
+    entries_.push_front(Entry{key, std::move(value), bytes});
+    index_.emplace(key, entries_.begin());
+    bytes_ += bytes;
+    return entries_.front().value;
+  }
+
+  // Changes the weight of the entry under |key|, for values which grow after
+  // they were inserted.
+  void SetBytes(const Key& key, size_t bytes) {
+    auto it = index_.find(key);
+    if (it == index_.end())
+      return;
+
+    bytes_ -= it->second->bytes;
+    it->second->bytes = bytes;
+    bytes_ += bytes;
+  }
+
+  // The least recently used value. Only valid when size() > 0.
+  const Value& oldest() const { return entries_.back().value; }
+
+  // Drops the least recently used entry. The most recently used entry is
+  // never evicted, so this returns false once it is the only one left.
+  bool EvictOldest() {
+    if (entries_.size() < 2)
+      return false;
+
+    Entry& victim = entries_.back();
+    bytes_ -= victim.bytes;
+    index_.erase(victim.key);
+    entries_.pop_back();
+    evictions_++;
+    return true;
+  }
+
+  void Clear() {
+    entries_.clear();
+    index_.clear();
+    bytes_ = 0;
+  }
+
+  // Calls |func| on every cached value, most recently used first.
+  template <typename Func>
+  void ForEach(Func func) const {
+    for (const Entry& entry : entries_)
+      func(entry.value);
+  }
+
+  size_t size() const { return entries_.size(); }
+  size_t bytes() const { return bytes_; }
+
+  int hits() const { return hits_; }
+  int misses() const { return misses_; }
+  int evictions() const { return evictions_; }
+
+ private:
+  struct Entry {
+    Key key;
+    Value value;
+    size_t bytes;
+  };
+  typedef std::list<Entry> EntryList;
+
+  void Erase(const Key& key) {
+    auto it = index_.find(key);
+    if (it == index_.end())
+      return;
+
+    bytes_ -= it->second->bytes;
+    entries_.erase(it->second);
+    index_.erase(it);
+  }
+
+  // Most recently used first.
+  EntryList entries_;
+  std::unordered_map<Key, typename EntryList::iterator, Hash> index_;
+  size_t bytes_;
+
+  int hits_;
+  int misses_;
+  int evictions_;
+};
+
+#endif  // SRC_UTILITIES_SIZED_LRU_CACHE_H_
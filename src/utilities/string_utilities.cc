@@ -27,8 +27,15 @@
 
 #include "utilities/string_utilities.h"
 
+#include <cstring>
+#include <functional>
+#include <mutex>
 #include <string>
 
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
 #include "encodings/codepage.h"
 #include "utilities/exception.h"
 #include "utf8cpp/utf8.h"
@@ -36,6 +43,22 @@
 using std::string;
 using std::wstring;
 
+namespace {
+
+// Number of lines cp932toUTF8() remembers. The cache is direct mapped: a line
+// simply replaces whatever was in its slot. It's shared by all threads.
+const size_t kTranscodeCacheSize = 512;
+
+struct TranscodeCacheEntry {
+  TranscodeCacheEntry() : transformation(-1) {}
+
+  int transformation;
+  string source;
+  string utf8;
+};
+
+}  // namespace
+
 wstring cp932toUnicode(const string& line, int transformation) {
   return Cp::instance(transformation).ConvertString(line);
 }
@@ -63,11 +86,59 @@ string UnicodeToUTF8(const std::wstring& widestring) {
 }
 
 string cp932toUTF8(const string& line, int transformation) {
-  if (line.empty())
+  // Plain ASCII is the same in every codepage and in UTF-8.
+  if (AsciiPrefixLength(line.data(), line.size()) == line.size())
     return line;
 
-  std::wstring ws = cp932toUnicode(line, transformation);
-  return UnicodeToUTF8(ws);
+  // Error messages can be built on the scenario prefetch thread while the
+  // main thread renders text. The lock also covers the conversion, since
+  // Cp::instance() swaps its codepage object when the transformation
+  // changes.
+  static std::mutex mutex;
+  static TranscodeCacheEntry cache[kTranscodeCacheSize];
+  std::lock_guard<std::mutex> lock(mutex);
+  size_t hash = std::hash<string>()(line) ^ size_t(transformation);
+  TranscodeCacheEntry& entry = cache[hash % kTranscodeCacheSize];
+  if (entry.transformation == transformation && entry.source == line)
+    return entry.utf8;
+
+  string utf8 = Cp::instance(transformation).ConvertStringToUTF8(line);
+  entry.transformation = transformation;
+  entry.source = line;
+  entry.utf8 = utf8;
+  return utf8;
+}
+
+size_t AsciiPrefixLength(const char* str, size_t length) {
+  size_t i = 0;
+
+#if defined(__SSE2__)
+  // Sixteen bytes at a time: a byte is flagged if its high bit is set or it
+  // is zero.
+  const __m128i zero = _mm_setzero_si128();
+  for (; i + 16 <= length; i += 16) {
+    __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(str + i));
+    __m128i flagged = _mm_or_si128(bytes, _mm_cmpeq_epi8(bytes, zero));
+    if (_mm_movemask_epi8(flagged))
+      break;
+  }
+#else
+  // Eight bytes at a time.
+  const uint64_t kOnes = 0x0101010101010101ull;
+  const uint64_t kHighBits = 0x8080808080808080ull;
+  for (; i + 8 <= length; i += 8) {
+    uint64_t word;
+    std::memcpy(&word, str + i, sizeof(word));
+    uint64_t has_zero = (word - kOnes) & ~word & kHighBits;
+    if ((word & kHighBits) || has_zero)
+      break;
+  }
+#endif
+
+  // Finish off the tail, or find the exact byte in the block that stopped us.
+  while (i < length && str[i] != 0 && !(str[i] & 0x80))
+    ++i;
+  return i;
 }
 
 bool IsOpeningQuoteMark(int codepoint) {
@@ -59,9 +59,15 @@ std::string TransformationName(int transformation);
 // Converts a UTF-16 string to a UTF-8 one.
 std::string UnicodeToUTF8(const std::wstring& widestring);
 
-// For convenience. Combines the two above functions.
+// Converts a CP932 string (or one of the transformations above) straight to
+// UTF-8. Lines that aren't plain ASCII are remembered in a small cache, since
+// the same lines come back whenever the backlog or a replay shows them again.
 std::string cp932toUTF8(const std::string& line, int transformation);
 
+// Returns the number of bytes at the start of |str| that are 7-bit ASCII,
+// stopping at the first NUL or byte with the high bit set.
+size_t AsciiPrefixLength(const char* str, size_t length);
+
 // Returns true if codepoint is either of the Japanese quote marks or '('.
 bool IsOpeningQuoteMark(int codepoint);
 
@@ -0,0 +1,138 @@
+// -*- Mode: C++; tab-width:2; indent-tabs-mode: nil; c-basic-offset: 2 -*-
+// vi:tw=80:et:ts=2:sts=2
+//
+// -----------------------------------------------------------------------
+//
+// This file is part of RLVM, a RealLive virtual machine clone.
+//
+// -----------------------------------------------------------------------
+//
+// Copyright (C) 2015 Elliot Glaysher
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA.
+// -----------------------------------------------------------------------
+
+#include "gtest/gtest.h"
+
+#include <boost/filesystem.hpp>
+#include <cstdio>
+#include <string>
+
+#include "libreallive/archive.h"
+#include "libreallive/bytecode.h"
+#include "libreallive/intmemref.h"
+#include "libreallive/scenario.h"
+#include "machine/rlmachine.h"
+#include "modules/module_jmp.h"
+#include "test_system/test_system.h"
+#include "test_utils.h"
+
+using libreallive::Archive;
+using libreallive::IntMemRef;
+using libreallive::Scenario;
+
+namespace fs = boost::filesystem;
+
+class ArchiveDiskCacheTest : public ::testing::Test {
+ protected:
+  ArchiveDiskCacheTest()
+      : cache_dir(fs::temp_directory_path() /
+                  fs::unique_path("rlvm-seen-cache-%%%%%%%%")) {}
+
+  ~ArchiveDiskCacheTest() {
+    boost::system::error_code ec;
+    fs::remove_all(cache_dir, ec);
+  }
+
+  std::string Seen(const std::string& name) {
+    return locateTestCase("Module_Jmp_SEEN/" + name);
+  }
+
+  fs::path cache_dir;
+};
+
+TEST_F(ArchiveDiskCacheTest, SecondRunReadsTheCache) {
+  {
+    Archive arc(Seen("jump_0.TXT"));
+    arc.EnableDiskCache(cache_dir.string());
+    ASSERT_TRUE(arc.GetScenario(1));
+
+    Archive::DiskCacheStats stats = arc.GetDiskCacheStats();
+    EXPECT_EQ(0, stats.hits);
+    EXPECT_EQ(1, stats.misses);
+    EXPECT_EQ(1, stats.writes);
+    EXPECT_TRUE(fs::exists(cache_dir / "seen0001.cache"));
+  }
+
+  Archive uncached(Seen("jump_0.TXT"));
+  Archive cached(Seen("jump_0.TXT"));
+  cached.EnableDiskCache(cache_dir.string());
+  Scenario* expected = uncached.GetScenario(1);
+  Scenario* actual = cached.GetScenario(1);
+  EXPECT_EQ(1, cached.GetDiskCacheStats().hits);
+  EXPECT_EQ(0, cached.GetDiskCacheStats().writes);
+
+  // Both parse into the same elements.
+  Scenario::const_iterator a = actual->begin();
+  Scenario::const_iterator e = expected->begin();
+  for (; a != actual->end() && e != expected->end(); ++a, ++e) {
+    EXPECT_EQ((*e)->GetBytecodeLength(), (*a)->GetBytecodeLength());
+    EXPECT_EQ((*e)->GetEntrypoint(), (*a)->GetEntrypoint());
+  }
+  EXPECT_TRUE(a == actual->end());
+  EXPECT_TRUE(e == expected->end());
+}
+
+TEST_F(ArchiveDiskCacheTest, DamagedEntryIsRewritten) {
+  {
+    Archive arc(Seen("goto_0.TXT"));
+    arc.EnableDiskCache(cache_dir.string());
+    arc.GetScenario(1);
+  }
+
+  // Clobber the magic number.
+  fs::path entry = cache_dir / "seen0001.cache";
+  FILE* f = fopen(entry.string().c_str(), "r+b");
+  ASSERT_TRUE(f);
+  fputc('X', f);
+  fclose(f);
+
+  Archive arc(Seen("goto_0.TXT"));
+  arc.EnableDiskCache(cache_dir.string());
+  ASSERT_TRUE(arc.GetScenario(1));
+  EXPECT_EQ(0, arc.GetDiskCacheStats().hits);
+  EXPECT_EQ(1, arc.GetDiskCacheStats().writes);
+}
+
+// A scenario built from the cache runs like any other. Same listing as
+// LargeJmpTest.goto.
+TEST_F(ArchiveDiskCacheTest, CachedScenarioRuns) {
+  {
+    Archive arc(Seen("goto_0.TXT"));
+    arc.EnableDiskCache(cache_dir.string());
+    arc.GetScenario(1);
+  }
+
+  Archive arc(Seen("goto_0.TXT"));
+  arc.EnableDiskCache(cache_dir.string());
+  TestSystem system;
+  RLMachine rlmachine(system, arc);
+  rlmachine.AttachModule(new JmpModule);
+  rlmachine.ExecuteUntilHalted();
+
+  EXPECT_EQ(1, arc.GetDiskCacheStats().hits);
+  EXPECT_EQ(1, rlmachine.GetIntValue(IntMemRef('A', 0)));
+  EXPECT_EQ(0, rlmachine.GetIntValue(IntMemRef('A', 1)));
+}
@@ -0,0 +1,96 @@
+// -*- Mode: C++; tab-width:2; indent-tabs-mode: nil; c-basic-offset: 2 -*-
+// vi:tw=80:et:ts=2:sts=2
+//
+// -----------------------------------------------------------------------
+//
+// This file is part of RLVM, a RealLive virtual machine clone.
+//
+// -----------------------------------------------------------------------
+//
+// Copyright (C) 2015 Elliot Glaysher
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA.
+// -----------------------------------------------------------------------
+
+#include "gtest/gtest.h"
+
+#include <cstdint>
+#include <vector>
+
+#include "libreallive/bytecode.h"
+#include "libreallive/bytecode_arena.h"
+
+using libreallive::BytecodeArena;
+using libreallive::BytecodeElement;
+
+namespace {
+
+int g_live_elements = 0;
+
+class CountingElement : public BytecodeElement {
+ public:
+  CountingElement() { ++g_live_elements; }
+  virtual ~CountingElement() { --g_live_elements; }
+
+  virtual const size_t GetBytecodeLength() const { return 1; }
+};
+
+class HugeElement : public CountingElement {
+ public:
+  char payload[BytecodeArena::kBlockSize * 2];
+};
+
+bool IsAligned(const void* p) {
+  return reinterpret_cast<uintptr_t>(p) % alignof(std::max_align_t) == 0;
+}
+
+}  // namespace
+
+TEST(BytecodeArenaTest, ConstructsContiguouslyAndDestroysEverything) {
+  {
+    BytecodeArena arena;
+    std::vector<CountingElement*> elements;
+    for (int i = 0; i < 100; ++i)
+      elements.push_back(arena.Construct<CountingElement>());
+
+    EXPECT_EQ(100, g_live_elements);
+    EXPECT_EQ(100u, arena.size());
+
+    // Everything fits in the first block, so elements are laid out one after
+    // another.
+    for (size_t i = 1; i < elements.size(); ++i) {
+      EXPECT_LT(elements[i - 1], elements[i]);
+      EXPECT_TRUE(IsAligned(elements[i]));
+    }
+  }
+
+  EXPECT_EQ(0, g_live_elements);
+}
+
+TEST(BytecodeArenaTest, OversizedElementsGetTheirOwnBlock) {
+  {
+    BytecodeArena arena;
+    CountingElement* before = arena.Construct<CountingElement>();
+    HugeElement* huge = arena.Construct<HugeElement>();
+    CountingElement* after = arena.Construct<CountingElement>();
+
+    EXPECT_TRUE(IsAligned(huge));
+    EXPECT_LT(before, after);
+    EXPECT_EQ(3, g_live_elements);
+    EXPECT_GE(arena.bytes_used(), sizeof(HugeElement));
+  }
+
+  EXPECT_EQ(0, g_live_elements);
+}
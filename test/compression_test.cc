@@ -0,0 +1,275 @@
+// -*- Mode: C++; tab-width:2; indent-tabs-mode: nil; c-basic-offset: 2 -*-
+// vi:tw=80:et:ts=2:sts=2
+//
+// -----------------------------------------------------------------------
+//
+// This file is part of RLVM, a RealLive virtual machine clone.
+//
+// -----------------------------------------------------------------------
+//
+// Copyright (C) 2015 Elliot Glaysher
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA.
+// -----------------------------------------------------------------------
+
+#include "gtest/gtest.h"
+
+#include <boost/filesystem.hpp>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+#include "libreallive/alldefs.h"
+#include "libreallive/compression.h"
+#include "test_utils.h"
+
+namespace fs = boost::filesystem;
+
+using libreallive::compression::Decompress;
+using libreallive::compression::XorKey;
+using libreallive::compression::xor_mask;
+
+namespace {
+
+// The straightforward byte at a time decoder that Decompress() replaced, kept
+// as the yardstick for correctness and speed.
+void ReferenceDecompress(const char* src,
+                         size_t src_len,
+                         char* dst,
+                         size_t dst_len,
+                         const XorKey* per_game_xor_key) {
+  int bit = 1;
+  const char* srcend = src + src_len;
+  char* dststart = dst;
+  char* dstend = dst + dst_len;
+  src += 8;
+  unsigned char mask = 8;
+  char flag = *src++ ^ xor_mask[mask++];
+  while (src < srcend && dst < dstend) {
+    if (bit == 256) {
+      bit = 1;
+      flag = *src++ ^ xor_mask[mask++];
+    }
+    if (flag & bit) {
+      *dst++ = *src++ ^ xor_mask[mask++];
+    } else {
+      char* repeat;
+      int count = *src++ ^ xor_mask[mask++];
+      count += (*src++ ^ xor_mask[mask++]) << 8;
+      repeat = dst - ((count >> 4) - 1) - 1;
+      count = (count & 0x0f) + 2;
+      if (repeat < dststart || repeat >= dst)
+        throw libreallive::Error("corrupt data");
+      for (int i = 0; i < count; i++)
+        *dst++ = *repeat++;
+    }
+    bit <<= 1;
+  }
+
+  if (per_game_xor_key) {
+    for (; per_game_xor_key->xor_offset != -1; per_game_xor_key++) {
+      dst = dststart + per_game_xor_key->xor_offset;
+      for (int i = 0; i < per_game_xor_key->xor_length && dst < dstend; ++i) {
+        *dst++ ^= per_game_xor_key->xor_key[i % 16];
+      }
+    }
+  }
+}
+
+struct CompressedScenario {
+  std::string name;
+  std::string data;
+  size_t uncompressed_length;
+};
+
+// Pulls the compressed bytecode of every scenario out of the SEEN.TXT files
+// in the test data.
+std::vector<CompressedScenario> LoadFixtures() {
+  std::vector<CompressedScenario> scenarios;
+  fs::path root = fs::path(locateTestCase("Module_Jmp_SEEN")).parent_path();
+  for (fs::recursive_directory_iterator it(root), end; it != end; ++it) {
+    if (it->path().extension() != ".TXT")
+      continue;
+
+    std::ifstream file(it->path().string().c_str(), std::ios::binary);
+    std::string archive((std::istreambuf_iterator<char>(file)),
+                        std::istreambuf_iterator<char>());
+    if (archive.size() < 80000)
+      continue;
+
+    for (int i = 0; i < 10000; ++i) {
+      const long offset = libreallive::read_i32(archive, i * 8);
+      const long length = libreallive::read_i32(archive, i * 8 + 4);
+      if (!offset || offset + length > long(archive.size()))
+        continue;
+
+      const char* scenario = archive.data() + offset;
+      CompressedScenario entry;
+      entry.name = it->path().filename().string() + "#" + std::to_string(i);
+      entry.data.assign(scenario + libreallive::read_i32(scenario + 0x20),
+                        libreallive::read_i32(scenario + 0x28));
+      entry.uncompressed_length = libreallive::read_i32(scenario + 0x24);
+      scenarios.push_back(entry);
+    }
+  }
+  return scenarios;
+}
+
+// Builds a compressed stream out of |items|: a literal is a single byte, a
+// back reference is (distance << 4 | (length - 2)) as two bytes.
+class StreamBuilder {
+ public:
+  StreamBuilder() : plain_(8, 0), bit_(256), flag_pos_(0) {}
+
+  void Literal(char c) {
+    NextItem(true);
+    plain_.push_back(c);
+  }
+
+  void Match(int distance, int length) {
+    NextItem(false);
+    const int pair = (distance << 4) | (length - 2);
+    plain_.push_back(pair & 0xff);
+    plain_.push_back(pair >> 8);
+  }
+
+  std::string Build() const {
+    std::string out(plain_);
+    for (size_t i = 0; i < out.size(); ++i)
+      out[i] ^= xor_mask[i & 0xff];
+    return out;
+  }
+
+ private:
+  void NextItem(bool literal) {
+    if (bit_ == 256) {
+      bit_ = 1;
+      flag_pos_ = plain_.size();
+      plain_.push_back(0);
+    }
+    if (literal)
+      plain_[flag_pos_] |= bit_;
+    bit_ <<= 1;
+  }
+
+  std::string plain_;
+  int bit_;
+  size_t flag_pos_;
+};
+
+std::string RunDecompress(const std::string& data, size_t length,
+                          const XorKey* key) {
+  std::string out(length, 0);
+  Decompress(data.data(), data.size(), &out[0], length, key);
+  return out;
+}
+
+std::string RunReference(const std::string& data, size_t length,
+                         const XorKey* key) {
+  std::string out(length, 0);
+  ReferenceDecompress(data.data(), data.size(), &out[0], length, key);
+  return out;
+}
+
+}  // namespace
+
+TEST(CompressionTest, MatchesReferenceOnEveryFixture) {
+  std::vector<CompressedScenario> scenarios = LoadFixtures();
+  ASSERT_FALSE(scenarios.empty());
+
+  for (const CompressedScenario& scenario : scenarios) {
+    EXPECT_EQ(RunReference(scenario.data, scenario.uncompressed_length, NULL),
+              RunDecompress(scenario.data, scenario.uncompressed_length, NULL))
+        << scenario.name;
+    EXPECT_EQ(
+        RunReference(scenario.data, scenario.uncompressed_length,
+                     libreallive::compression::little_busters_ex_xor_mask),
+        RunDecompress(scenario.data, scenario.uncompressed_length,
+                      libreallive::compression::little_busters_ex_xor_mask))
+        << scenario.name;
+  }
+}
+
+TEST(CompressionTest, ShortAndLongDistanceMatches) {
+  StreamBuilder builder;
+  for (char c = 'a'; c <= 'l'; ++c)
+    builder.Literal(c);
+  builder.Match(1, 17);   // Run of 'l'.
+  builder.Match(29, 17);  // Wide copy from the start.
+  builder.Match(10, 17);  // Wide copy, overlapping its own output.
+  // Enough trailing literals that the last match still has the 24 bytes of
+  // room the wide copy needs; they also overwrite what it spills.
+  for (char c : std::string("!mnopqrs"))
+    builder.Literal(c);
+  std::string data = builder.Build();
+
+  const size_t length = 12 + 17 + 17 + 17 + 8;
+  std::string expected =
+      "abcdefghijkl" "lllllllllllllllll" "abcdefghijkllllll"
+      "hijkllllllhijklll" "!mnopqrs";
+  EXPECT_EQ(expected, RunReference(data, length, NULL));
+  EXPECT_EQ(expected, RunDecompress(data, length, NULL));
+
+  // Same thing, but with too little room left for the wide copy.
+  EXPECT_EQ(expected.substr(0, 52), RunDecompress(data, 52, NULL));
+}
+
+TEST(CompressionTest, RejectsMatchesBeforeTheStart) {
+  StreamBuilder builder;
+  builder.Literal('a');
+  builder.Match(2, 2);
+  std::string data = builder.Build();
+  EXPECT_THROW(RunDecompress(data, 16, NULL), libreallive::Error);
+}
+
+// Not run by default. To run it, pass --gtest_also_run_disabled_tests and
+// --gtest_filter=CompressionTest.DISABLED_Benchmark to rlvm_unittests.
+TEST(CompressionTest, DISABLED_Benchmark) {
+  std::vector<CompressedScenario> scenarios = LoadFixtures();
+  ASSERT_FALSE(scenarios.empty());
+
+  size_t bytes = 0;
+  for (const CompressedScenario& scenario : scenarios)
+    bytes += scenario.uncompressed_length;
+
+  const int kRounds = 2000;
+  std::vector<char> out(4096);
+  for (int pass = 0; pass < 2; ++pass) {
+    auto start = std::chrono::steady_clock::now();
+    for (int round = 0; round < kRounds; ++round) {
+      for (const CompressedScenario& scenario : scenarios) {
+        if (out.size() < scenario.uncompressed_length)
+          out.resize(scenario.uncompressed_length);
+        if (pass == 0) {
+          ReferenceDecompress(scenario.data.data(), scenario.data.size(),
+                              &out[0], scenario.uncompressed_length, NULL);
+        } else {
+          Decompress(scenario.data.data(), scenario.data.size(), &out[0],
+                     scenario.uncompressed_length, NULL);
+        }
+      }
+    }
+    std::chrono::duration<double> elapsed =
+        std::chrono::steady_clock::now() - start;
+    std::cout << (pass == 0 ? "reference:  " : "Decompress: ")
+              << scenarios.size() << " scenarios x " << kRounds << " in "
+              << elapsed.count() << "s, "
+              << (bytes * kRounds / elapsed.count() / (1024 * 1024))
+              << " MB/s" << std::endl;
+  }
+}
@@ -0,0 +1,206 @@
+// -*- Mode: C++; tab-width:2; indent-tabs-mode: nil; c-basic-offset: 2 -*-
+// vi:tw=80:et:ts=2:sts=2
+//
+// -----------------------------------------------------------------------
+//
+// This file is part of RLVM, a RealLive virtual machine clone.
+//
+// -----------------------------------------------------------------------
+//
+// Copyright (C) 2015 Elliot Glaysher
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA.
+// -----------------------------------------------------------------------
+
+
+#include "gtest/gtest.h"
+
+#include <memory>
+#include <ostream>
+
+#include "systems/base/damage_tracker.h"
+#include "systems/base/graphics_object.h"
+#include "systems/base/graphics_object_data.h"
+#include "systems/base/graphics_system.h"
+#include "test_system/mock_surface.h"
+#include "test_system/test_text_window.h"
+
+#include "test_utils.h"
+
+namespace {
+
+const Size kScreen(640, 480);
+
+// A 50x50 image.
+class SquareObjectData : public GraphicsObjectData {
+ public:
+  SquareObjectData() : surface_(MockSurface::Create("square", Size(50, 50))) {}
+
+  virtual int PixelWidth(const GraphicsObject& go) override { return 50; }
+  virtual int PixelHeight(const GraphicsObject& go) override { return 50; }
+  virtual GraphicsObjectData* Clone() const override {
+    return new SquareObjectData(*this);
+  }
+  virtual void Execute(RLMachine& machine) override {}
+
+ protected:
+  virtual std::shared_ptr<const Surface> CurrentSurface(
+      const GraphicsObject& go) override {
+    return surface_;
+  }
+  virtual Rect SrcRect(const GraphicsObject& go) override {
+    return Rect(Point(0, 0), Size(50, 50));
+  }
+  virtual void ObjectInfo(std::ostream& tree) override {}
+
+ private:
+  std::shared_ptr<const Surface> surface_;
+};
+
+// Starts the tracker off the initial full frame.
+DamageTracker MakeTracker(int percent) {
+  DamageTracker tracker(kScreen, percent);
+  tracker.FrameDrawn(tracker.GetRedrawRect());
+  return tracker;
+}
+
+}  // namespace
+
+TEST(DamageTrackerTest, FirstFrameIsFull) {
+  DamageTracker tracker(kScreen, 50);
+  EXPECT_TRUE(tracker.IsFullRedraw());
+  EXPECT_EQ(Rect(Point(0, 0), kScreen), tracker.GetRedrawRect());
+}
+
+TEST(DamageTrackerTest, UnionsDamage) {
+  DamageTracker tracker = MakeTracker(50);
+  EXPECT_FALSE(tracker.IsFullRedraw());
+
+  tracker.AddRect(Rect::REC(10, 20, 30, 40));
+  tracker.AddRect(Rect::REC(100, 5, 10, 10));
+  EXPECT_FALSE(tracker.IsFullRedraw());
+  EXPECT_EQ(Rect::GRP(10, 5, 110, 60), tracker.GetRedrawRect());
+
+  tracker.FrameDrawn(tracker.GetRedrawRect());
+  EXPECT_EQ(100 * 55, tracker.GetStats().last_frame_pixels);
+  EXPECT_EQ(1, tracker.GetStats().partial_frames);
+  EXPECT_EQ(0, tracker.GetRedrawRect().width());
+}
+
+TEST(DamageTrackerTest, ClipsToScreen) {
+  DamageTracker tracker = MakeTracker(50);
+  tracker.AddRect(Rect::REC(-10, -10, 20, 20));
+  tracker.AddRect(Rect::REC(700, 0, 20, 20));
+  tracker.AddRect(Rect());
+  EXPECT_EQ(Rect::GRP(0, 0, 10, 10), tracker.GetRedrawRect());
+}
+
+TEST(DamageTrackerTest, FallsBackToFullRedraw) {
+  DamageTracker tracker = MakeTracker(50);
+  tracker.AddRect(Rect::REC(0, 0, 320, 240));
+  EXPECT_FALSE(tracker.IsFullRedraw());
+
+  // Two small corners whose union covers most of the screen.
+  tracker.AddRect(Rect::REC(630, 470, 10, 10));
+  EXPECT_TRUE(tracker.IsFullRedraw());
+  EXPECT_EQ(Rect(Point(0, 0), kScreen), tracker.GetRedrawRect());
+
+  tracker.FrameDrawn(tracker.GetRedrawRect());
+  EXPECT_EQ(640 * 480, tracker.GetStats().last_frame_pixels);
+  EXPECT_EQ(2, tracker.GetStats().full_frames);
+}
+
+TEST(DamageTrackerTest, ZeroPercentDisablesPartialRedraw) {
+  DamageTracker tracker = MakeTracker(0);
+  EXPECT_TRUE(tracker.IsFullRedraw());
+  tracker.AddRect(Rect::REC(0, 0, 1, 1));
+  EXPECT_TRUE(tracker.IsFullRedraw());
+}
+
+class DamageTrackingTest : public FullSystemTest {};
+
+// Moving an object only redraws where it was and where it is.
+TEST_F(DamageTrackingTest, MovedObjectDamagesOldAndNewFootprint) {
+  GraphicsSystem& graphics = system.graphics();
+  GraphicsObject& obj = graphics.GetObject(0, 3);
+  obj.SetObjectData(new SquareObjectData);
+  obj.SetVisible(1);
+  obj.SetX(100);
+  obj.SetY(100);
+
+  graphics.RefreshDamagedArea();
+  EXPECT_EQ(1, graphics.damage_tracker().GetStats().full_frames);
+
+  // Nothing changed.
+  graphics.RefreshDamagedArea();
+  EXPECT_EQ(1, graphics.damage_tracker().GetStats().partial_frames);
+  EXPECT_EQ(0, graphics.damage_tracker().GetStats().last_frame_pixels);
+
+  obj.SetX(200);
+  graphics.RefreshDamagedArea();
+  EXPECT_EQ(2, graphics.damage_tracker().GetStats().partial_frames);
+  EXPECT_EQ(150 * 50, graphics.damage_tracker().GetStats().last_frame_pixels);
+
+  // Hiding it damages only where it was.
+  obj.SetVisible(0);
+  graphics.RefreshDamagedArea();
+  EXPECT_EQ(50 * 50, graphics.damage_tracker().GetStats().last_frame_pixels);
+}
+
+TEST_F(DamageTrackingTest, UnboundedObjectsForceFullRedraw) {
+  GraphicsSystem& graphics = system.graphics();
+  GraphicsObject& obj = graphics.GetObject(0, 3);
+  obj.SetObjectData(new SquareObjectData);
+  obj.SetVisible(1);
+  graphics.RefreshDamagedArea();
+
+  obj.SetRotation(450);
+  graphics.RefreshDamagedArea();
+  EXPECT_EQ(2, graphics.damage_tracker().GetStats().full_frames);
+}
+
+TEST_F(DamageTrackingTest, ForceRefreshRedrawsEverything) {
+  GraphicsSystem& graphics = system.graphics();
+  graphics.RefreshDamagedArea();
+
+  graphics.MarkScreenAreaAsDirty(GUT_TEXTSYS, Rect::REC(0, 0, 10, 10));
+  graphics.RefreshDamagedArea();
+  EXPECT_EQ(100, graphics.damage_tracker().GetStats().last_frame_pixels);
+
+  graphics.ForceRefresh();
+  graphics.RefreshDamagedArea();
+  EXPECT_EQ(640 * 480, graphics.damage_tracker().GetStats().last_frame_pixels);
+}
+
+// A script can draw into DC0 under DrawManual() and go back to DrawAuto()
+// without a refresh; the next character printed must still bring the DC0
+// changes to the screen along with itself.
+TEST_F(DamageTrackingTest, DamageFromManualModeIsKept) {
+  GraphicsSystem& graphics = system.graphics();
+  graphics.RefreshDamagedArea();
+
+  graphics.SetScreenUpdateMode(GraphicsSystem::SCREENUPDATEMODE_MANUAL);
+  // What SDLSurface reports after a write to DC0.
+  graphics.MarkScreenAsDirty(GUT_DRAW_DC0);
+  EXPECT_FALSE(graphics.screen_needs_refresh());
+  graphics.SetScreenUpdateMode(GraphicsSystem::SCREENUPDATEMODE_AUTOMATIC);
+
+  TestTextWindow window(system, 0);
+  window.DisplayCharacter("\xe3\x81\x82", "");
+  EXPECT_TRUE(graphics.screen_needs_refresh());
+
+  graphics.RefreshDamagedArea();
+  EXPECT_EQ(640 * 480, graphics.damage_tracker().GetStats().last_frame_pixels);
+}
@@ -28,6 +28,7 @@
 #include "gtest/gtest.h"
 
 #include "libreallive/archive.h"
+#include "libreallive/compiled_expression.h"
 #include "libreallive/expression.h"
 #include "libreallive/intmemref.h"
 #include "machine/rlmachine.h"
@@ -148,3 +149,46 @@ TEST(ExpressionTest, ParseQuotedEnglishString) {
 
   ASSERT_EQ(16, libreallive::NextString(s.c_str()));
 }
+
+// Makes sure that the flattened form of an expression statement computes the
+// same thing as walking the ExpressionPiece tree.
+TEST(ExpressionTest, CompiledMatchesTree) {
+  const char* statements[] = {
+      // intA[1] = (intA[0] + 5) * 2
+      "$ 00 [ $ ff 01 00 00 00 ] 5c 1e ( $ 00 [ $ ff 00 00 00 00 ] 5c 00 "
+      "$ ff 05 00 00 00 ) 5c 02 $ ff 02 00 00 00",
+      // intB[intA[0]] += -intA[1] % 7
+      "$ 01 [ $ 00 [ $ ff 00 00 00 00 ] ] 5c 14 5c 01 $ 00 [ $ ff 01 00 00 "
+      "00 ] 5c 04 $ ff 07 00 00 00",
+      // intA[2] = intA[0] < intA[1] && intA[1] != 3
+      "$ 00 [ $ ff 02 00 00 00 ] 5c 1e $ 00 [ $ ff 00 00 00 00 ] 5c 2b "
+      "$ 00 [ $ ff 01 00 00 00 ] 5c 3c $ 00 [ $ ff 01 00 00 00 ] 5c 29 "
+      "$ ff 03 00 00 00"};
+
+  TestSystem system;
+  libreallive::Archive arc(
+      locateTestCase("ExpressionTest_SEEN/basicOperators.TXT"));
+  RLMachine tree_machine(system, arc);
+  RLMachine compiled_machine(system, arc);
+  tree_machine.SetIntValue(IntMemRef('A', 0), 7);
+  compiled_machine.SetIntValue(IntMemRef('A', 0), 7);
+
+  for (const char* statement : statements) {
+    string parsable = PrintableToParsableString(statement);
+    const char* start = parsable.c_str();
+    ExpressionPiece piece(GetAssignment(start));
+    CompiledExpression compiled(piece);
+    ASSERT_TRUE(compiled.is_valid()) << statement;
+
+    EXPECT_EQ(piece.GetIntegerValue(tree_machine),
+              compiled.Evaluate(compiled_machine)) << statement;
+  }
+
+  for (int i = 0; i < 10; ++i) {
+    EXPECT_EQ(tree_machine.GetIntValue(IntMemRef('A', i)),
+              compiled_machine.GetIntValue(IntMemRef('A', i)));
+    EXPECT_EQ(tree_machine.GetIntValue(IntMemRef('B', i)),
+              compiled_machine.GetIntValue(IntMemRef('B', i)));
+  }
+  EXPECT_EQ(-3, compiled_machine.GetIntValue(IntMemRef('B', 7)));
+}
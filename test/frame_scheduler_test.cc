@@ -0,0 +1,103 @@
+// -*- Mode: C++; tab-width:2; indent-tabs-mode: nil; c-basic-offset: 2 -*-
+// vi:tw=80:et:ts=2:sts=2
+//
+// -----------------------------------------------------------------------
+//
+// This file is part of RLVM, a RealLive virtual machine clone.
+//
+// -----------------------------------------------------------------------
+//
+// Copyright (C) 2015 Elliot Glaysher
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA.
+// -----------------------------------------------------------------------
+
+
+#include "gtest/gtest.h"
+
+#include <memory>
+
+#include "libreallive/archive.h"
+#include "libreallive/intmemref.h"
+#include "machine/frame_scheduler.h"
+#include "machine/rlmachine.h"
+#include "modules/module_jmp.h"
+#include "test_system/test_event_system.h"
+#include "test_system/test_system.h"
+
+#include "test_utils.h"
+
+using libreallive::IntMemRef;
+
+namespace {
+
+// A clock that advances by a fixed step each time it's read.
+class SteppingClock : public EventSystemMockHandler {
+ public:
+  explicit SteppingClock(unsigned int step) : ticks_(0), step_(step) {}
+  virtual unsigned int GetTicks() const {
+    ticks_ += step_;
+    return ticks_;
+  }
+
+ private:
+  mutable unsigned int ticks_;
+  unsigned int step_;
+};
+
+class FrameSchedulerTest : public ::testing::Test {
+ protected:
+  FrameSchedulerTest()
+      : arc(locateTestCase("Module_Jmp_SEEN/goto_0.TXT")),
+        rlmachine(system, arc) {
+    rlmachine.AttachModule(new JmpModule);
+  }
+
+  void SetClockStep(unsigned int step) {
+    dynamic_cast<TestEventSystem&>(system.event())
+        .SetMockHandler(std::make_shared<SteppingClock>(step));
+  }
+
+  libreallive::Archive arc;
+  TestSystem system;
+  RLMachine rlmachine;
+};
+
+}  // namespace
+
+// With time standing still, the whole script fits in the first frame.
+TEST_F(FrameSchedulerTest, RunsScriptWithinOneFrame) {
+  SetClockStep(0);
+  FrameScheduler scheduler(system, rlmachine);
+  scheduler.Run();
+
+  EXPECT_TRUE(rlmachine.halted());
+  EXPECT_EQ(1, rlmachine.GetIntValue(IntMemRef('A', 2)));
+  EXPECT_EQ(1, scheduler.frame_count());
+  EXPECT_EQ(0, scheduler.late_frame_count());
+  EXPECT_GT(scheduler.instruction_count(), 0);
+}
+
+// When each frame takes longer than the interval, the scheduler resyncs
+// instead of falling further behind, and still finishes the script.
+TEST_F(FrameSchedulerTest, ResyncsAfterOverrun) {
+  SetClockStep(50);
+  FrameScheduler scheduler(system, rlmachine);
+  scheduler.Run();
+
+  EXPECT_TRUE(rlmachine.halted());
+  EXPECT_EQ(1, rlmachine.GetIntValue(IntMemRef('A', 2)));
+  EXPECT_EQ(scheduler.frame_count(), scheduler.late_frame_count());
+}
@@ -136,3 +136,45 @@ TEST(GameexeUnit, DstrackRegression) {
   EXPECT_EQ("dcbgm000", dc.GetStringAt(3));
   EXPECT_EQ("dcbgm000", dc.GetStringAt(4));
 }
+
+// Preformatted keys must resolve to the same entries as the string forms.
+TEST(GameexeUnit, PreformattedKeys) {
+  Gameexe ini(locateTestCase("Gameexe_data/Gameexe.ini"));
+  EXPECT_EQ(2, ini(GameexeKey("IMAGINE", "TWO")));
+  EXPECT_EQ(25, ini(GameexeKey("WINDOW", 0, "MOJI_SIZE")));
+  EXPECT_EQ("WINDOW.000.MOJI_SIZE", GameexeKey("WINDOW", 0, "MOJI_SIZE").str());
+  // Same padding the old std::setw(3) formatting produced.
+  EXPECT_EQ("SEL.0-5", ini("SEL", -5).key());
+  EXPECT_EQ("SEL.1234", ini("SEL", 1234).key());
+  EXPECT_FALSE(ini(GameexeKey("RANDOM_KEY")).Exists());
+}
+
+TEST(GameexeUnit, NegativeSizesFallBackToTheDefault) {
+  Gameexe ini;
+  ini.parseLine("#__IMAGE_CACHE_MB=-1");
+  ini.parseLine("#__TEXTURE_CACHE_MB=0");
+  EXPECT_EQ(48, ini("__IMAGE_CACHE_MB").ToNonNegativeInt(48));
+  EXPECT_EQ(0, ini("__TEXTURE_CACHE_MB").ToNonNegativeInt(64));
+  EXPECT_EQ(16, ini("__MISSING_MB").ToNonNegativeInt(16));
+}
+
+TEST(GameexeUnit, IndexedKeysFollowChanges) {
+  Gameexe ini(locateTestCase("Gameexe_data/Gameexe.ini"));
+  GameexeIndexedKey colour("COLOR_TABLE");
+  GameexeIndexedKey moji_size("WINDOW", "MOJI_SIZE");
+
+  EXPECT_EQ(255, colour(ini, 0).GetIntAt(0));
+  EXPECT_FALSE(colour(ini, 1).Exists());
+  EXPECT_EQ(25, moji_size(ini, 0).ToInt());
+
+  // A cached miss must not survive the key being added.
+  ini("COLOR_TABLE", 1) = 7;
+  EXPECT_TRUE(colour(ini, 1).Exists());
+  EXPECT_EQ(7, colour(ini, 1).ToInt());
+
+  // Nor may a cached entry leak into lookups on another Gameexe.
+  Gameexe other;
+  other.parseLine("#COLOR_TABLE.000=1,2,3");
+  EXPECT_EQ(1, colour(other, 0).GetIntAt(0));
+  EXPECT_FALSE(moji_size(other, 0).Exists());
+}
@@ -0,0 +1,126 @@
+// -*- Mode: C++; tab-width:2; indent-tabs-mode: nil; c-basic-offset: 2 -*-
+// vi:tw=80:et:ts=2:sts=2
+//
+// -----------------------------------------------------------------------
+//
+// This file is part of RLVM, a RealLive virtual machine clone.
+//
+// -----------------------------------------------------------------------
+//
+// Copyright (C) 2015 Elliot Glaysher
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA.
+// -----------------------------------------------------------------------
+
+
+#include "gtest/gtest.h"
+
+#include <string>
+
+#include "systems/base/glyph_cache.h"
+
+namespace {
+
+Glyph MakeGlyph(int width, int height, uint8_t value = 0xFF) {
+  Glyph glyph;
+  glyph.size = Size(width, height);
+  glyph.coverage.assign(size_t(width) * height, value);
+  return glyph;
+}
+
+}  // namespace
+
+TEST(GlyphCacheTest, ReturnsStoredGlyph) {
+  GlyphCache cache(64 * 1024);
+  const Glyph* inserted = cache.Insert("a", 24, 0, MakeGlyph(10, 20, 0x80));
+  ASSERT_TRUE(inserted);
+
+  const Glyph* fetched = cache.Fetch("a", 24, 0);
+  EXPECT_EQ(inserted, fetched);
+  EXPECT_EQ(Size(10, 20), fetched->size);
+  EXPECT_EQ(200u, fetched->coverage.size());
+  EXPECT_EQ(0x80, fetched->coverage[0]);
+}
+
+// The same character at another size or in another style is a separate
+// rasterization, as is a different character whose UTF-8 shares bytes.
+TEST(GlyphCacheTest, KeysOnTextSizeAndStyle) {
+  GlyphCache cache(64 * 1024);
+  cache.Insert("a", 24, 0, MakeGlyph(10, 20));
+  cache.Insert("a", 12, 0, MakeGlyph(5, 10));
+  cache.Insert("a", 24, 2, MakeGlyph(12, 20));
+  cache.Insert("\xE3\x81\x82", 24, 0, MakeGlyph(24, 24));
+  cache.Insert("\xE3\x81\x84", 24, 0, MakeGlyph(22, 24));
+
+  EXPECT_EQ(Size(10, 20), cache.Fetch("a", 24, 0)->size);
+  EXPECT_EQ(Size(5, 10), cache.Fetch("a", 12, 0)->size);
+  EXPECT_EQ(Size(12, 20), cache.Fetch("a", 24, 2)->size);
+  EXPECT_EQ(Size(24, 24), cache.Fetch("\xE3\x81\x82", 24, 0)->size);
+  EXPECT_EQ(Size(22, 24), cache.Fetch("\xE3\x81\x84", 24, 0)->size);
+  EXPECT_FALSE(cache.Fetch("a", 24, 1));
+  EXPECT_FALSE(cache.Fetch("\xE3\x81", 24, 0));
+  EXPECT_EQ(5u, cache.GetStats().entries);
+}
+
+// A glyph weighs its coverage plus its key text, so a bigger size costs
+// more of the budget than a smaller one.
+TEST(GlyphCacheTest, WeighsCoverageAndText) {
+  GlyphCache cache(64 * 1024);
+  cache.Insert("a", 12, 0, MakeGlyph(8, 8));
+  size_t small = cache.GetStats().bytes;
+
+  cache.Insert("abc", 24, 0, MakeGlyph(16, 16));
+  size_t both = cache.GetStats().bytes;
+  EXPECT_EQ(small + (16 * 16 - 8 * 8) + 2, both - small);
+
+  // Re-rasterizing replaces the old coverage rather than adding to it.
+  cache.Insert("a", 12, 0, MakeGlyph(4, 4));
+  EXPECT_EQ(both - (8 * 8 - 4 * 4), cache.GetStats().bytes);
+  EXPECT_EQ(2u, cache.GetStats().entries);
+  EXPECT_EQ(Size(4, 4), cache.Fetch("a", 12, 0)->size);
+}
+
+TEST(GlyphCacheTest, EvictsLeastRecentlyUsedGlyphs) {
+  // Room for two 32x32 glyphs, but not three.
+  GlyphCache cache(2 * 32 * 32 + 512);
+  cache.Insert("a", 24, 0, MakeGlyph(32, 32));
+  cache.Insert("b", 24, 0, MakeGlyph(32, 32));
+
+  // Touching "a" makes "b" the eviction candidate.
+  cache.Fetch("a", 24, 0);
+  cache.Insert("c", 24, 0, MakeGlyph(32, 32));
+
+  EXPECT_TRUE(cache.Fetch("a", 24, 0));
+  EXPECT_FALSE(cache.Fetch("b", 24, 0));
+  EXPECT_TRUE(cache.Fetch("c", 24, 0));
+  EXPECT_EQ(1, cache.GetStats().evictions);
+}
+
+// The caller draws the glyph Insert() returns, so it has to survive even
+// when it alone is over budget.
+TEST(GlyphCacheTest, KeepsNewestGlyphEvenOverBudget) {
+  GlyphCache cache(16);
+  cache.Insert("a", 24, 0, MakeGlyph(32, 32));
+  const Glyph* big = cache.Insert("b", 24, 0, MakeGlyph(64, 64));
+
+  ASSERT_TRUE(big);
+  EXPECT_EQ(Size(64, 64), big->size);
+  EXPECT_EQ(1u, cache.GetStats().entries);
+  EXPECT_EQ(big, cache.Fetch("b", 24, 0));
+
+  cache.Clear();
+  EXPECT_EQ(0u, cache.GetStats().entries);
+  EXPECT_EQ(0u, cache.GetStats().bytes);
+}
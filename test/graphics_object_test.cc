@@ -33,8 +33,10 @@
 #include <boost/serialization/scoped_ptr.hpp>
 
 #include <boost/scoped_ptr.hpp>
+#include <cstdio>
 #include <functional>
 #include <iostream>
+#include <sstream>
 #include <string>
 #include <tuple>
 #include <vector>
@@ -369,3 +371,48 @@ TEST_F(GraphicsObjectTest, RunMutatorsOnChildObjects) {
   parent.Execute(rlmachine);
   EXPECT_TRUE(mutator_test->called());
 }
+
+namespace {
+
+// Returns the object numbers in the order a refresh draws them.
+std::vector<int> RenderedObjects(GraphicsSystem& graphics) {
+  std::ostringstream tree;
+  graphics.Refresh(&tree);
+
+  std::vector<int> order;
+  std::istringstream lines(tree.str());
+  std::string line;
+  while (std::getline(lines, line)) {
+    int obj_num;
+    if (sscanf(line.c_str(), "Object #%d:", &obj_num) == 1)
+      order.push_back(obj_num);
+  }
+  return order;
+}
+
+}  // namespace
+
+TEST_F(GraphicsObjectTest, RenderOrderFollowsZOrder) {
+  GraphicsSystem& graphics = system.graphics();
+  for (int i = 1; i <= 4; ++i) {
+    GraphicsObject& obj = graphics.GetObject(0, i);
+    obj.SetObjectData(new GraphicsObjectOfFile(system, FILE_NAME));
+    obj.SetVisible(1);
+  }
+  EXPECT_EQ(std::vector<int>({1, 2, 3, 4}), RenderedObjects(graphics));
+
+  graphics.GetObject(0, 1).SetZOrder(10);
+  graphics.GetObject(0, 3).SetZLayer(-1);
+  EXPECT_EQ(std::vector<int>({3, 2, 4, 1}), RenderedObjects(graphics));
+
+  graphics.GetObject(0, 2).SetZDepth(5);
+  graphics.GetObject(0, 4).SetVisible(0);
+  EXPECT_EQ(std::vector<int>({3, 2, 1}), RenderedObjects(graphics));
+
+  graphics.GetObject(0, 4).SetVisible(1);
+  graphics.GetObject(0, 3).FreeObjectData();
+  EXPECT_EQ(std::vector<int>({4, 2, 1}), RenderedObjects(graphics));
+
+  graphics.ClearAndPromoteObjects();
+  EXPECT_EQ(std::vector<int>(), RenderedObjects(graphics));
+}
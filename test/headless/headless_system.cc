@@ -0,0 +1,76 @@
+// -*- Mode: C++; tab-width:2; indent-tabs-mode: nil; c-basic-offset: 2 -*-
+// vi:tw=80:et:ts=2:sts=2
+//
+// -----------------------------------------------------------------------
+//
+// This file is part of RLVM, a RealLive virtual machine clone.
+//
+// -----------------------------------------------------------------------
+//
+// Copyright (C) 2015 Elliot Glaysher
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA.
+// -----------------------------------------------------------------------
+
+
+#include "headless/headless_system.h"
+
+#include <string>
+
+#include "systems/base/graphics_system.h"
+#include "systems/base/sound_system.h"
+#include "systems/base/text_system.h"
+
+// -----------------------------------------------------------------------
+// VirtualClock
+// -----------------------------------------------------------------------
+VirtualClock::VirtualClock() : ticks_(0) {}
+
+VirtualClock::~VirtualClock() {}
+
+unsigned int VirtualClock::GetTicks() const { return ticks_; }
+
+void VirtualClock::Wait(unsigned int milliseconds) const {
+  ticks_ += milliseconds;
+}
+
+// -----------------------------------------------------------------------
+// HeadlessSystem
+// -----------------------------------------------------------------------
+HeadlessSystem::HeadlessSystem(const std::string& path_to_gameexe)
+    : TestSystem(path_to_gameexe),
+      clock_(new VirtualClock),
+      refresh_count_(0) {
+  dynamic_cast<TestEventSystem&>(event()).SetMockHandler(clock_);
+
+  // Nobody is there to click through the text.
+  text().SetAutoMode(true);
+}
+
+HeadlessSystem::~HeadlessSystem() {}
+
+void HeadlessSystem::Run(RLMachine& machine) {
+  // The same order as SDLSystem::Run().
+  event().ExecuteEventSystem(machine);
+  text().ExecuteTextSystem();
+  sound().ExecuteSoundSystem();
+  graphics().ExecuteGraphicsSystem(machine);
+
+  if (graphics().screen_needs_refresh()) {
+    graphics().Refresh(NULL);
+    graphics().OnScreenRefreshed();
+    refresh_count_++;
+  }
+}
@@ -0,0 +1,75 @@
+// -*- Mode: C++; tab-width:2; indent-tabs-mode: nil; c-basic-offset: 2 -*-
+// vi:tw=80:et:ts=2:sts=2
+//
+// -----------------------------------------------------------------------
+//
+// This file is part of RLVM, a RealLive virtual machine clone.
+//
+// -----------------------------------------------------------------------
+//
+// Copyright (C) 2015 Elliot Glaysher
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA.
+// -----------------------------------------------------------------------
+
+
+#ifndef TEST_HEADLESS_HEADLESS_SYSTEM_H_
+#define TEST_HEADLESS_HEADLESS_SYSTEM_H_
+
+#include <memory>
+#include <string>
+
+#include "test_system/test_event_system.h"
+#include "test_system/test_system.h"
+
+// A clock that only moves when someone waits on it. Waiting is therefore
+// free: a pause that would sleep for two seconds returns immediately with
+// the clock two seconds later.
+class VirtualClock : public EventSystemMockHandler {
+ public:
+  VirtualClock();
+  virtual ~VirtualClock();
+
+  virtual unsigned int GetTicks() const override;
+  virtual void Wait(unsigned int milliseconds) const override;
+
+ private:
+  mutable unsigned int ticks_;
+};
+
+// A TestSystem that actually runs its subsystems each frame, so that long
+// operations, effects, object mutators and rendering into the mock surfaces
+// all happen as they would in a real game, but against a VirtualClock and
+// with text set to advance automatically.
+class HeadlessSystem : public TestSystem {
+ public:
+  explicit HeadlessSystem(const std::string& path_to_gameexe);
+  virtual ~HeadlessSystem();
+
+  const VirtualClock& clock() const { return *clock_; }
+
+  // Number of times the screen was redrawn.
+  int refresh_count() const { return refresh_count_; }
+
+  // Overridden from TestSystem:
+  virtual void Run(RLMachine& machine) override;
+
+ private:
+  std::shared_ptr<VirtualClock> clock_;
+
+  int refresh_count_;
+};
+
+#endif  // TEST_HEADLESS_HEADLESS_SYSTEM_H_
@@ -0,0 +1,139 @@
+// -*- Mode: C++; tab-width:2; indent-tabs-mode: nil; c-basic-offset: 2 -*-
+// vi:tw=80:et:ts=2:sts=2
+//
+// -----------------------------------------------------------------------
+//
+// This file is part of RLVM, a RealLive virtual machine clone.
+//
+// -----------------------------------------------------------------------
+//
+// Copyright (C) 2015 Elliot Glaysher
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA.
+// -----------------------------------------------------------------------
+
+
+#include "headless/scripted_input_machine.h"
+
+#include <boost/algorithm/string.hpp>
+
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "long_operations/button_object_select_long_operation.h"
+#include "long_operations/select_long_operation.h"
+
+using std::cerr;
+using std::endl;
+
+// -----------------------------------------------------------------------
+// ScriptedInput
+// -----------------------------------------------------------------------
+ScriptedInput::ScriptedInput() : position_(0) {}
+
+ScriptedInput::~ScriptedInput() {}
+
+void ScriptedInput::Parse(std::istream& stream) {
+  std::string line;
+  while (std::getline(stream, line)) {
+    boost::trim(line);
+    if (line.empty() || line[0] == '#')
+      continue;
+
+    Decision decision = {false, 0, line};
+    if (line[0] == '@' && line.size() > 1) {
+      try {
+        decision.index = std::stoi(line.substr(1));
+        decision.by_index = true;
+      }
+      catch (...) {
+        // Not a number; treat it as option text.
+      }
+    }
+
+    decisions_.push_back(decision);
+  }
+}
+
+bool ScriptedInput::Next(Decision* decision) {
+  if (position_ >= decisions_.size())
+    return false;
+
+  *decision = decisions_[position_++];
+  return true;
+}
+
+// -----------------------------------------------------------------------
+// ScriptedInputMachine
+// -----------------------------------------------------------------------
+ScriptedInputMachine::ScriptedInputMachine(System& in_system,
+                                           libreallive::Archive& in_archive)
+    : RLMachine(in_system, in_archive),
+      decision_count_(0),
+      fallback_count_(0) {}
+
+ScriptedInputMachine::~ScriptedInputMachine() {}
+
+void ScriptedInputMachine::PushLongOperation(LongOperation* long_operation) {
+  if (SelectLongOperation* sel =
+          dynamic_cast<SelectLongOperation*>(long_operation)) {
+    decision_count_++;
+
+    ScriptedInput::Decision decision;
+    bool answered = false;
+    if (input_.Next(&decision)) {
+      if (decision.by_index) {
+        sel->SelectByIndex(decision.index);
+        answered = true;
+      } else {
+        answered = sel->SelectByText(decision.text);
+      }
+
+      if (!answered) {
+        cerr << "WARNING: No option '" << decision.text << "'. Options are:"
+             << endl;
+        for (const std::string& option : sel->GetOptions())
+          cerr << "- \"" << option << "\"" << endl;
+      }
+    } else if (fallback_count_ == 0) {
+      cerr << "WARNING: Ran out of scripted input; taking the first option "
+           << "from here on." << endl;
+    }
+
+    if (!answered) {
+      fallback_count_++;
+      sel->SelectByIndex(0);
+    }
+  } else if (ButtonObjectSelectLongOperation* sel =
+                 dynamic_cast<ButtonObjectSelectLongOperation*>(
+                     long_operation)) {
+    decision_count_++;
+
+    ScriptedInput::Decision decision;
+    int value = 1;
+    if (input_.Next(&decision) && decision.by_index) {
+      value = decision.index;
+    } else {
+      fallback_count_++;
+    }
+
+    set_store_register(value);
+    delete sel;
+    return;
+  }
+
+  RLMachine::PushLongOperation(long_operation);
+}
@@ -0,0 +1,92 @@
+// -*- Mode: C++; tab-width:2; indent-tabs-mode: nil; c-basic-offset: 2 -*-
+// vi:tw=80:et:ts=2:sts=2
+//
+// -----------------------------------------------------------------------
+//
+// This file is part of RLVM, a RealLive virtual machine clone.
+//
+// -----------------------------------------------------------------------
+//
+// Copyright (C) 2015 Elliot Glaysher
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA.
+// -----------------------------------------------------------------------
+
+
+#ifndef TEST_HEADLESS_SCRIPTED_INPUT_MACHINE_H_
+#define TEST_HEADLESS_SCRIPTED_INPUT_MACHINE_H_
+
+#include <istream>
+#include <string>
+#include <vector>
+
+#include "machine/rlmachine.h"
+
+// The answers to a route's decisions, read from an input file. Blank lines
+// and lines starting with '#' are ignored. Every other line answers the next
+// decision: "@N" picks option N (counting from zero), and anything else picks
+// the option with that text. For button object selections, "@N" is the
+// value returned to the script.
+class ScriptedInput {
+ public:
+  struct Decision {
+    bool by_index;
+    int index;
+    std::string text;
+  };
+
+  ScriptedInput();
+  ~ScriptedInput();
+
+  // Appends the decisions in |stream|.
+  void Parse(std::istream& stream);
+
+  // Returns false when there are no decisions left.
+  bool Next(Decision* decision);
+
+  size_t size() const { return decisions_.size(); }
+  size_t remaining() const { return decisions_.size() - position_; }
+
+ private:
+  std::vector<Decision> decisions_;
+  size_t position_;
+};
+
+// An RLMachine that answers selections from a ScriptedInput instead of
+// waiting for a click. When the input runs out, it takes the first option
+// so that the route keeps going.
+class ScriptedInputMachine : public RLMachine {
+ public:
+  ScriptedInputMachine(System& in_system, libreallive::Archive& in_archive);
+  virtual ~ScriptedInputMachine();
+
+  ScriptedInput& input() { return input_; }
+
+  // Number of selections answered, and how many of those the input didn't
+  // cover.
+  int decision_count() const { return decision_count_; }
+  int fallback_count() const { return fallback_count_; }
+
+  // Overridden from RLMachine:
+  virtual void PushLongOperation(LongOperation* long_operation) override;
+
+ private:
+  ScriptedInput input_;
+
+  int decision_count_;
+  int fallback_count_;
+};
+
+#endif  // TEST_HEADLESS_SCRIPTED_INPUT_MACHINE_H_
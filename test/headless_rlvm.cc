@@ -0,0 +1,232 @@
+// -*- Mode: C++; tab-width:2; indent-tabs-mode: nil; c-basic-offset: 2 -*-
+// vi:tw=80:et:ts=2:sts=2
+//
+// -----------------------------------------------------------------------
+//
+// This file is part of RLVM, a RealLive virtual machine clone.
+//
+// -----------------------------------------------------------------------
+//
+// Copyright (C) 2015 Elliot Glaysher
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA.
+// -----------------------------------------------------------------------
+
+
+// Runs a game with no window, no sound and no real time, as fast as the CPU
+// allows. Text advances on its own and selections are answered from an input
+// file, so whole routes can be replayed to catch regressions:
+//
+//   headless_rlvm --input route.txt /path/to/game
+
+#include <boost/filesystem/operations.hpp>
+#include <boost/filesystem/fstream.hpp>
+#include <boost/program_options.hpp>
+
+#include <chrono>
+#include <iostream>
+#include <string>
+
+#include "headless/headless_system.h"
+#include "headless/scripted_input_machine.h"
+#include "libreallive/gameexe.h"
+#include "libreallive/reallive.h"
+#include "machine/frame_scheduler.h"
+#include "machine/game_hacks.h"
+#include "modules/modules.h"
+#include "systems/base/system_error.h"
+#include "utilities/exception.h"
+#include "utilities/file.h"
+
+using namespace std;
+
+namespace po = boost::program_options;
+namespace fs = boost::filesystem;
+
+// -----------------------------------------------------------------------
+
+void printUsage(const string& name, po::options_description& opts) {
+  cout << "Usage: " << name << " [options] <game root>" << endl << opts
+       << endl;
+}
+
+// -----------------------------------------------------------------------
+
+int main(int argc, char* argv[]) {
+  // -----------------------------------------------------------------------
+  // Parse command line options
+
+  // Declare the supported options.
+  po::options_description opts("Options");
+  opts.add_options()("help", "Produce help message")(
+      "input", po::value<string>(),
+      "File of answers to the route's selections, one per line")(
+      "start", po::value<int>(), "Start at a specific SEEN number")(
+      "max-time", po::value<int>(),
+      "Stop after this many seconds of game time")(
+      "memory", "Forces debug mode (Sets #MEMORY=1 in the Gameexe.ini file)")(
+      "undefined-opcodes", "Display a message on undefined opcodes")(
+      "count-undefined",
+      "On exit, present a summary table about how many times each undefined "
+      "opcode was called");
+
+  // Declare the final option to be game-root
+  po::options_description hidden("Hidden");
+  hidden.add_options()(
+      "game-root", po::value<string>(), "Location of game root");
+
+  po::positional_options_description p;
+  p.add("game-root", 1);
+
+  // Use these on the command line
+  po::options_description commandLineOpts;
+  commandLineOpts.add(opts).add(hidden);
+
+  po::variables_map vm;
+  po::store(po::basic_command_line_parser<char>(argc, argv)
+                .options(commandLineOpts)
+                .positional(p)
+                .run(),
+            vm);
+  po::notify(vm);
+
+  // -----------------------------------------------------------------------
+  // Process command line options
+  fs::path gamerootPath, gameexePath, seenPath;
+
+  if (vm.count("help")) {
+    printUsage(argv[0], opts);
+    return 0;
+  }
+
+  if (vm.count("game-root")) {
+    gamerootPath = vm["game-root"].as<string>();
+
+    if (!fs::is_directory(gamerootPath)) {
+      cerr << "ERROR: Path '" << gamerootPath << "' is not a directory."
+           << endl;
+      return -1;
+    }
+
+    // Some games hide data in a lower subdirectory.  A little hack to
+    // make these behave as expected...
+    if (CorrectPathCase(gamerootPath / "Gameexe.ini").empty()) {
+      if (!CorrectPathCase(gamerootPath / "KINETICDATA" / "Gameexe.ini")
+               .empty()) {
+        gamerootPath /= "KINETICDATA/";
+      } else if (!CorrectPathCase(gamerootPath / "REALLIVEDATA" / "Gameexe.ini")
+                      .empty()) {
+        gamerootPath /= "REALLIVEDATA/";
+      }
+    }
+  } else {
+    printUsage(argv[0], opts);
+    return -1;
+  }
+
+  try {
+    gameexePath = CorrectPathCase(gamerootPath / "Gameexe.ini");
+    seenPath = CorrectPathCase(gamerootPath / "Seen.txt");
+
+    HeadlessSystem system(gameexePath.string());
+    Gameexe& gameexe = system.gameexe();
+    gameexe("__GAMEPATH") = gamerootPath.string();
+
+    if (vm.count("start"))
+      gameexe("SEEN_START") = vm["start"].as<int>();
+
+    if (vm.count("memory"))
+      gameexe("MEMORY") = 1;
+
+    libreallive::Archive arc(seenPath.string(), gameexe("REGNAME"));
+    ScriptedInputMachine rlmachine(system, arc);
+    AddAllModules(rlmachine);
+    AddGameHacks(rlmachine);
+
+    if (vm.count("input")) {
+      fs::ifstream input(vm["input"].as<string>());
+      if (!input) {
+        cerr << "ERROR: Can't open input file '" << vm["input"].as<string>()
+             << "'." << endl;
+        return -1;
+      }
+      rlmachine.input().Parse(input);
+    }
+
+    if (vm.count("undefined-opcodes"))
+      rlmachine.SetPrintUndefinedOpcodes(true);
+
+    if (vm.count("count-undefined"))
+      rlmachine.RecordUndefinedOpcodeCounts();
+
+    rlmachine.SetHaltOnException(false);
+
+    // Global and save game memory are deliberately left alone, so a replay
+    // always starts from the same state and never touches the player's data.
+    unsigned int max_ticks = 0;
+    if (vm.count("max-time"))
+      max_ticks = vm["max-time"].as<int>() * 1000u;
+
+    std::chrono::steady_clock::time_point start =
+        std::chrono::steady_clock::now();
+
+    FrameScheduler scheduler(system, rlmachine);
+    while (!rlmachine.halted()) {
+      scheduler.RunFrame();
+
+      if (max_ticks && system.clock().GetTicks() >= max_ticks) {
+        cerr << "Stopping after " << vm["max-time"].as<int>()
+             << " seconds of game time." << endl;
+        break;
+      }
+    }
+
+    double wall_seconds = std::chrono::duration<double>(
+                              std::chrono::steady_clock::now() - start)
+                              .count();
+
+    cout << "Instructions:  " << scheduler.instruction_count() << endl
+         << "Frames:        " << scheduler.frame_count() << endl
+         << "Redraws:       " << system.refresh_count() << endl
+         << "Decisions:     " << rlmachine.decision_count() << " ("
+         << rlmachine.fallback_count() << " not covered by input)" << endl
+         << "Unused input:  " << rlmachine.input().remaining() << endl
+         << "Game time:     " << system.clock().GetTicks() / 1000.0 << "s"
+         << endl
+         << "Wall time:     " << wall_seconds << "s" << endl;
+  }
+  catch (rlvm::Exception& e) {
+    cerr << "Fatal RLVM error: " << e.what() << endl;
+    return 1;
+  }
+  catch (libreallive::Error& e) {
+    cerr << "Fatal libreallive error: " << e.what() << endl;
+    return 1;
+  }
+  catch (SystemError& e) {
+    cerr << "Fatal local system error: " << e.what() << endl;
+    return 1;
+  }
+  catch (std::exception& e) {
+    cout << "Uncaught exception: " << e.what() << endl;
+    return 1;
+  }
+  catch (const char* e) {
+    cout << "Uncaught exception: " << e << endl;
+    return 1;
+  }
+
+  return 0;
+}
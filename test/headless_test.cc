@@ -0,0 +1,91 @@
+// -*- Mode: C++; tab-width:2; indent-tabs-mode: nil; c-basic-offset: 2 -*-
+// vi:tw=80:et:ts=2:sts=2
+//
+// -----------------------------------------------------------------------
+//
+// This file is part of RLVM, a RealLive virtual machine clone.
+//
+// -----------------------------------------------------------------------
+//
+// Copyright (C) 2015 Elliot Glaysher
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA.
+// -----------------------------------------------------------------------
+
+
+#include "gtest/gtest.h"
+
+#include <sstream>
+
+#include "headless/headless_system.h"
+#include "headless/scripted_input_machine.h"
+#include "libreallive/archive.h"
+#include "libreallive/intmemref.h"
+#include "machine/frame_scheduler.h"
+#include "modules/module_jmp.h"
+#include "systems/base/event_system.h"
+#include "systems/base/text_system.h"
+
+#include "test_utils.h"
+
+using libreallive::IntMemRef;
+
+TEST(ScriptedInputTest, ParsesDecisions) {
+  std::istringstream stream(
+      "# Route to the good ending\n"
+      "@2\n"
+      "\n"
+      "Go to the roof\n");
+  ScriptedInput input;
+  input.Parse(stream);
+  ASSERT_EQ(2, input.size());
+
+  ScriptedInput::Decision decision;
+  ASSERT_TRUE(input.Next(&decision));
+  EXPECT_TRUE(decision.by_index);
+  EXPECT_EQ(2, decision.index);
+
+  ASSERT_TRUE(input.Next(&decision));
+  EXPECT_FALSE(decision.by_index);
+  EXPECT_EQ("Go to the roof", decision.text);
+
+  EXPECT_EQ(0, input.remaining());
+  EXPECT_FALSE(input.Next(&decision));
+}
+
+// Waiting costs no real time; it only moves the virtual clock forward.
+TEST(HeadlessSystemTest, WaitingAdvancesVirtualClock) {
+  HeadlessSystem system(locateTestCase("Gameexe_data/Gameexe.ini"));
+  EXPECT_TRUE(system.text().auto_mode());
+  EXPECT_EQ(0, system.event().GetTicks());
+
+  system.event().Wait(2000);
+  EXPECT_EQ(2000, system.event().GetTicks());
+  EXPECT_EQ(2000, system.clock().GetTicks());
+}
+
+TEST(HeadlessSystemTest, RunsScript) {
+  libreallive::Archive arc(locateTestCase("Module_Jmp_SEEN/goto_0.TXT"));
+  HeadlessSystem system(locateTestCase("Gameexe_data/Gameexe.ini"));
+  ScriptedInputMachine rlmachine(system, arc);
+  rlmachine.AttachModule(new JmpModule);
+
+  FrameScheduler scheduler(system, rlmachine);
+  scheduler.Run();
+
+  EXPECT_TRUE(rlmachine.halted());
+  EXPECT_EQ(1, rlmachine.GetIntValue(IntMemRef('A', 2)));
+  EXPECT_EQ(0, rlmachine.decision_count());
+}
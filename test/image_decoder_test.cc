@@ -0,0 +1,171 @@
+// -*- Mode: C++; tab-width:2; indent-tabs-mode: nil; c-basic-offset: 2 -*-
+// vi:tw=80:et:ts=2:sts=2
+//
+// -----------------------------------------------------------------------
+//
+// This file is part of RLVM, a RealLive virtual machine clone.
+//
+// -----------------------------------------------------------------------
+//
+// Copyright (C) 2015 Elliot Glaysher
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA.
+// -----------------------------------------------------------------------
+
+#include "gtest/gtest.h"
+
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "systems/base/image_decoder.h"
+#include "systems/base/system_error.h"
+#include "utilities/exception.h"
+#include "test_utils.h"
+#include "xclannad/file.h"
+
+// type0.g00 is a 2x1 type 0 g00 with one literal run of two pixels.
+static void ExpectTinyImage(const DecodedImage& image) {
+  EXPECT_EQ(2, image.width);
+  EXPECT_EQ(1, image.height);
+  ASSERT_TRUE(image.pixels.get());
+  EXPECT_FALSE(image.has_alpha);
+
+  uint32_t pixels[2];
+  memcpy(pixels, image.pixels.get(), sizeof(pixels));
+  EXPECT_EQ(0xff1e140au, pixels[0]);
+  EXPECT_EQ(0xff3c3228u, pixels[1]);
+
+  ASSERT_EQ(1u, image.region_table.size());
+  EXPECT_EQ(Rect(Point(0, 0), Size(2, 1)), image.region_table[0].rect);
+}
+
+TEST(ImageDecoderTest, DecodesSynchronously) {
+  ImageDecoder decoder;
+  ExpectTinyImage(*decoder.Decode(locateTestCase("ImageDecoder/type0.g00")));
+}
+
+TEST(ImageDecoderTest, DecodeUsesAsyncResult) {
+  ImageDecoder decoder;
+  std::string path = locateTestCase("ImageDecoder/type0.g00");
+
+  ImageDecoder::Future future = decoder.DecodeAsync(path);
+  EXPECT_TRUE(decoder.HasPendingDecode(path));
+
+  // Asking twice doesn't decode twice.
+  ImageDecoder::Future second = decoder.DecodeAsync(path);
+  std::shared_ptr<const DecodedImage> image = decoder.Decode(path);
+  EXPECT_EQ(future.get(), image);
+  EXPECT_EQ(second.get(), image);
+  EXPECT_FALSE(decoder.HasPendingDecode(path));
+
+  ExpectTinyImage(*image);
+}
+
+TEST(ImageDecoderTest, ErrorsArriveThroughTheFuture) {
+  ImageDecoder decoder;
+  ImageDecoder::Future missing = decoder.DecodeAsync("/nonexistent/x.g00");
+  EXPECT_THROW(missing.get(), rlvm::Exception);
+
+  std::string empty = locateTestCase("Gameroot/g00/doesntmatter.g00");
+  decoder.DecodeAsync(empty);
+  EXPECT_THROW(decoder.Decode(empty), SystemError);
+}
+
+// type2.g00 is a 4x2 type 2 g00 with two 2x2 patterns side by side. The
+// second pattern only has pixel data for its right column.
+TEST(ImageDecoderTest, Type2PatternsAreDecodedOnDemand) {
+  ImageDecoder decoder;
+  std::shared_ptr<DecodedImage> image =
+      decoder.Decode(locateTestCase("ImageDecoder/type2.g00"));
+  EXPECT_EQ(4, image->width);
+  EXPECT_EQ(2, image->height);
+  EXPECT_FALSE(image->pixels.get());
+  ASSERT_TRUE(image->patterns.get());
+  ASSERT_EQ(2, image->patterns->pattern_count());
+  ASSERT_EQ(2u, image->region_table.size());
+  EXPECT_EQ(Rect(Point(2, 0), Size(2, 2)), image->region_table[1].rect);
+
+  // Asking for the second pattern first decompresses past the first one.
+  int width, height;
+  bool has_alpha;
+  DecodedImage::PixelBuffer second =
+      image->patterns->DecodePattern(1, &width, &height, &has_alpha);
+  EXPECT_EQ(2, width);
+  EXPECT_EQ(2, height);
+  EXPECT_TRUE(has_alpha);
+  uint32_t pixels[4];
+  memcpy(pixels, second.get(), sizeof(pixels));
+  EXPECT_EQ(0u, pixels[0]);
+  EXPECT_EQ(0xff405060u, pixels[1]);
+  EXPECT_EQ(0u, pixels[2]);
+  EXPECT_EQ(0xff708090u, pixels[3]);
+
+  DecodedImage::PixelBuffer first =
+      image->patterns->DecodePattern(0, &width, &height, &has_alpha);
+  EXPECT_FALSE(has_alpha);
+  memcpy(pixels, first.get(), sizeof(pixels));
+  EXPECT_EQ(0xff0000ffu, pixels[0]);
+  EXPECT_EQ(0xff00ff00u, pixels[1]);
+  EXPECT_EQ(0xffff0000u, pixels[2]);
+  EXPECT_EQ(0xff102030u, pixels[3]);
+
+  EXPECT_THROW(image->patterns->DecodePattern(2, &width, &height, &has_alpha),
+               SystemError);
+}
+
+TEST(ImageDecoderTest, Type2PatternsMatchTheCanvas) {
+  std::ifstream file(locateTestCase("ImageDecoder/type2.g00").c_str(),
+                     std::ios::binary);
+  std::vector<char> data((std::istreambuf_iterator<char>(file)),
+                         std::istreambuf_iterator<char>());
+
+  std::unique_ptr<GRPCONV> conv(
+      GRPCONV::AssignConverter(data.data(), data.size(), "type2.g00"));
+  ASSERT_TRUE(conv.get());
+  EXPECT_TRUE(G00PatternDecoder::CanDecode(*conv));
+  std::vector<uint32_t> canvas(conv->Width() * conv->Height() + 256);
+  ASSERT_TRUE(conv->Read(reinterpret_cast<char*>(canvas.data())));
+
+  G00PatternDecoder patterns(data.data(), data.size());
+  for (int i = 0; i < patterns.pattern_count(); ++i) {
+    const GRPCONV::REGION& region = conv->region_table[i];
+    int width, height;
+    bool has_alpha;
+    DecodedImage::PixelBuffer pattern =
+        patterns.DecodePattern(i, &width, &height, &has_alpha);
+    for (int y = 0; y < height; ++y) {
+      for (int x = 0; x < width; ++x) {
+        uint32_t pixel;
+        memcpy(&pixel, pattern.get() + (y * width + x) * 4, sizeof(pixel));
+        EXPECT_EQ(canvas[(region.y1 + y) * conv->Width() + region.x1 + x],
+                  pixel)
+            << "pattern " << i << " at " << x << "," << y;
+      }
+    }
+  }
+}
+
+TEST(ImageDecoderTest, SingleRegionImagesAreDecodedWhole) {
+  ImageDecoder decoder;
+  std::shared_ptr<DecodedImage> image =
+      decoder.Decode(locateTestCase("ImageDecoder/type0.g00"));
+  EXPECT_FALSE(image->patterns.get());
+  EXPECT_TRUE(image->pixels.get());
+}
@@ -577,6 +577,54 @@ TEST(LargeJmpTest, farcall) {
   }
 }
 
+// Tests that the archive finds SEEN00002 as a farcall target of SEEN00001 once
+// the farcall has been parsed, and that farcall still works when SEEN00002 is
+// parsed on the prefetch thread.
+TEST(LargeJmpTest, farcallWithPrefetching) {
+  libreallive::Archive scan_arc(
+      locateTestCase("Module_Jmp_SEEN/farcallTest_0.TXT"));
+  libreallive::Scenario* one = scan_arc.GetScenario(1);
+  EXPECT_TRUE(one->GetReachableScenarios().empty());
+  EXPECT_EQ(0u, one->parsed_region_count());
+
+  for (libreallive::Scenario::const_iterator it = one->begin();
+       it != one->end(); ++it) {
+  }
+  std::vector<int> reachable = one->GetReachableScenarios();
+  ASSERT_EQ(1, reachable.size());
+  EXPECT_EQ(2, reachable[0]);
+
+  for (int i = 1; i < 4; ++i) {
+    libreallive::Archive arc(
+        locateTestCase("Module_Jmp_SEEN/farcallTest_0.TXT"));
+    arc.EnablePrefetching();
+    TestSystem system;
+    RLMachine rlmachine(system, arc);
+    rlmachine.AttachModule(new JmpModule);
+    rlmachine.SetIntValue(IntMemRef('B', 0), i);
+    rlmachine.ExecuteUntilHalted();
+
+    EXPECT_EQ(1, rlmachine.GetIntValue(IntMemRef('A', 0)));
+    EXPECT_EQ(i, rlmachine.GetIntValue(IntMemRef('A', 1)));
+    EXPECT_EQ(1, rlmachine.GetIntValue(IntMemRef('A', 2)));
+  }
+}
+
+// Racing the prefetch thread for SEEN00002 must never replace the Scenario
+// that GetScenario() already handed out.
+TEST(LargeJmpTest, prefetchingKeepsScenariosHandedOut) {
+  for (int i = 0; i < 50; ++i) {
+    libreallive::Archive arc(
+        locateTestCase("Module_Jmp_SEEN/farcallTest_0.TXT"));
+    arc.EnablePrefetching();
+    arc.GetScenario(1);
+    libreallive::Scenario* two = arc.GetScenario(2);
+    ASSERT_TRUE(two);
+    EXPECT_EQ(two, arc.GetScenario(2));
+    EXPECT_TRUE(two->GetReachableScenarios().empty());
+  }
+}
+
 // -----------------------------------------------------------------------
 
 // Tests gosub_with
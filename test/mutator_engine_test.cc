@@ -0,0 +1,94 @@
+// -*- Mode: C++; tab-width:2; indent-tabs-mode: nil; c-basic-offset: 2 -*-
+// vi:tw=80:et:ts=2:sts=2
+//
+// -----------------------------------------------------------------------
+//
+// This file is part of RLVM, a RealLive virtual machine clone.
+//
+// -----------------------------------------------------------------------
+//
+// Copyright (C) 2015 Elliot Glaysher
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA.
+// -----------------------------------------------------------------------
+
+
+#include "gtest/gtest.h"
+
+#include "systems/base/mutator_engine.h"
+#include "utilities/math_util.h"
+
+// Every track must get exactly what ObjectMutator::GetValueForTime() would
+// have computed on its own.
+TEST(MutatorEngineTest, MatchesInterpolateBetween) {
+  MutatorEngine engine;
+  const unsigned int begin = 1000;
+  const int duration = 700;
+  int tracks[3];
+  for (int type = 0; type < 3; ++type)
+    tracks[type] = engine.Add(begin, duration, -40, 255, type);
+
+  for (unsigned int ticks = 900; ticks < 1800; ticks += 7) {
+    engine.Evaluate(ticks);
+    for (int type = 0; type < 3; ++type) {
+      int expected;
+      if (ticks < begin)
+        expected = -40;
+      else if (ticks < begin + duration)
+        expected = InterpolateBetween(
+            begin, ticks, begin + duration, -40, 255, type);
+      else
+        expected = 255;
+      EXPECT_EQ(expected, engine.value(tracks[type]))
+          << "type " << type << " at " << ticks;
+    }
+  }
+}
+
+TEST(MutatorEngineTest, ReusesReleasedTracks) {
+  MutatorEngine engine;
+  int one = engine.Add(0, 100, 0, 10, 0);
+  int two = engine.Add(0, 100, 0, 20, 0);
+  EXPECT_EQ(2, engine.live_count());
+
+  engine.Release(one);
+  EXPECT_EQ(1, engine.live_count());
+
+  int three = engine.Add(0, 100, 0, 30, 0);
+  EXPECT_EQ(one, three);
+  EXPECT_EQ(2, engine.live_count());
+
+  engine.Evaluate(200);
+  EXPECT_EQ(20, engine.value(two));
+  EXPECT_EQ(30, engine.value(three));
+}
+
+TEST(MutatorEngineTest, TracksEvaluationTime) {
+  MutatorEngine engine;
+  engine.Add(0, 100, 0, 10, 0);
+  EXPECT_FALSE(engine.IsEvaluatedAt(50));
+
+  engine.BeginFrame(50);
+  EXPECT_TRUE(engine.in_frame());
+  EXPECT_TRUE(engine.IsEvaluatedAt(50));
+  EXPECT_EQ(50u, engine.ticks());
+
+  // A new track needs another pass before its value can be read.
+  engine.Add(0, 100, 0, 20, 0);
+  EXPECT_FALSE(engine.IsEvaluatedAt(50));
+
+  engine.EndFrame();
+  EXPECT_FALSE(engine.in_frame());
+}
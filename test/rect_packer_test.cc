@@ -0,0 +1,113 @@
+// -*- Mode: C++; tab-width:2; indent-tabs-mode: nil; c-basic-offset: 2 -*-
+// vi:tw=80:et:ts=2:sts=2
+//
+// -----------------------------------------------------------------------
+//
+// This file is part of RLVM, a RealLive virtual machine clone.
+//
+// -----------------------------------------------------------------------
+//
+// Copyright (C) 2015 Elliot Glaysher
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA.
+// -----------------------------------------------------------------------
+
+
+#include "gtest/gtest.h"
+
+#include <vector>
+
+#include "systems/base/rect_packer.h"
+
+namespace {
+
+// Rect::Intersects() counts rectangles that merely share an edge.
+bool Overlaps(const Rect& a, const Rect& b) {
+  return a.x() < b.x2() && b.x() < a.x2() && a.y() < b.y2() && b.y() < a.y2();
+}
+
+}  // namespace
+
+TEST(RectPackerTest, PacksAlongAShelf) {
+  RectPacker packer(Size(64, 64));
+  Rect a, b;
+  ASSERT_TRUE(packer.Allocate(Size(16, 8), &a));
+  ASSERT_TRUE(packer.Allocate(Size(16, 8), &b));
+  EXPECT_EQ(Rect::REC(0, 0, 16, 8), a);
+  EXPECT_EQ(Rect::REC(16, 0, 16, 8), b);
+  EXPECT_EQ(16 * 8 * 2, packer.used_area());
+}
+
+TEST(RectPackerTest, OpensNewShelfForTallerImages) {
+  RectPacker packer(Size(64, 64));
+  Rect a, b;
+  ASSERT_TRUE(packer.Allocate(Size(16, 8), &a));
+  ASSERT_TRUE(packer.Allocate(Size(16, 20), &b));
+  EXPECT_EQ(Rect::REC(0, 8, 16, 20), b);
+  EXPECT_FALSE(Overlaps(a, b));
+}
+
+TEST(RectPackerTest, RejectsOversizedAndFullPages) {
+  RectPacker packer(Size(32, 32));
+  Rect r;
+  EXPECT_FALSE(packer.Allocate(Size(33, 1), &r));
+  ASSERT_TRUE(packer.Allocate(Size(32, 32), &r));
+  EXPECT_FALSE(packer.Allocate(Size(1, 1), &r));
+}
+
+TEST(RectPackerTest, ReusesReleasedSpace) {
+  RectPacker packer(Size(32, 32));
+  std::vector<Rect> rects(4);
+  for (Rect& r : rects)
+    ASSERT_TRUE(packer.Allocate(Size(8, 32), &r));
+  Rect extra;
+  EXPECT_FALSE(packer.Allocate(Size(8, 8), &extra));
+
+  // Free the middle two; a rectangle spanning both fits in the coalesced hole.
+  packer.Release(rects[1]);
+  packer.Release(rects[2]);
+  ASSERT_TRUE(packer.Allocate(Size(16, 32), &extra));
+  EXPECT_EQ(Rect::REC(8, 0, 16, 32), extra);
+}
+
+TEST(RectPackerTest, EmptyShelvesAreReturnedToThePage) {
+  RectPacker packer(Size(32, 32));
+  Rect small, tall;
+  ASSERT_TRUE(packer.Allocate(Size(8, 8), &small));
+  packer.Release(small);
+  EXPECT_TRUE(packer.empty());
+
+  // With the 8 pixel shelf gone, a full height image fits.
+  ASSERT_TRUE(packer.Allocate(Size(32, 32), &tall));
+  EXPECT_EQ(Rect::REC(0, 0, 32, 32), tall);
+}
+
+TEST(RectPackerTest, NoOverlapUnderChurn) {
+  RectPacker packer(Size(256, 256));
+  std::vector<Rect> live;
+  for (int i = 0; i < 400; ++i) {
+    Rect r;
+    Size size(4 + (i * 7) % 29, 4 + (i * 13) % 23);
+    if (packer.Allocate(size, &r)) {
+      for (const Rect& other : live)
+        ASSERT_FALSE(Overlaps(r, other)) << "iteration " << i;
+      live.push_back(r);
+    }
+    if (i % 3 == 0 && !live.empty()) {
+      packer.Release(live[i % live.size()]);
+      live.erase(live.begin() + i % live.size());
+    }
+  }
+}
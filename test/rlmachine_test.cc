@@ -27,6 +27,11 @@
 
 #include "gtest/gtest.h"
 
+#include <boost/archive/text_oarchive.hpp>
+#include <boost/date_time/posix_time/time_serialize.hpp>
+#include <boost/iostreams/filter/zlib.hpp>
+#include <boost/iostreams/filtering_stream.hpp>
+
 #include <iostream>
 #include <utility>
 #include <string>
@@ -34,8 +39,12 @@
 
 #include "machine/memory.h"
 #include "machine/rlmachine.h"
+#include "machine/save_game_header.h"
 #include "machine/serialization.h"
 #include "modules/module_str.h"
+#include "systems/base/graphics_system.h"
+#include "systems/base/sound_system.h"
+#include "systems/base/text_system.h"
 #include "utilities/exception.h"
 #include "libreallive/intmemref.h"
 #include "test_utils.h"
@@ -93,6 +102,24 @@ TEST_F(RLMachineTest, RejectsDoubleAttachs) {
   EXPECT_THROW({ rlmachine.AttachModule(new StrModule); }, rlvm::Exception);
 }
 
+// CommandElements cache the operation they were dispatched to; make sure that
+// cache isn't shared between machines with different modules.
+TEST_F(RLMachineTest, DispatchCacheIsPerMachine) {
+  libreallive::Archive arc(locateTestCase("Module_Str_SEEN/strcpy_0.TXT"));
+  {
+    RLMachine with_module(system, arc);
+    with_module.AttachModule(new StrModule);
+    with_module.ExecuteUntilHalted();
+    EXPECT_EQ("valid", with_module.GetStringValue(STRS_LOCATION, 0));
+  }
+
+  {
+    RLMachine without_module(system, arc);
+    without_module.ExecuteUntilHalted();
+    EXPECT_EQ("", without_module.GetStringValue(STRS_LOCATION, 0));
+  }
+}
+
 TEST_F(RLMachineTest, ReturnFromFarcallMismatch) {
   EXPECT_THROW({ rlmachine.ReturnFromFarcall(); }, rlvm::Exception);
 }
@@ -276,3 +303,77 @@ TEST_F(RLMachineTest, SerializationOfSavepointValues) {
     verifyStrMemoryCountingFrom(loadMachine, STRS_LOCATION, 0);
   }
 }
+
+// Save games used to be a zlib compressed boost text archive of everything;
+// make sure we can still read those.
+TEST_F(RLMachineTest, LoadsLegacyTextSaveGames) {
+  stringstream ss;
+  libreallive::Archive arc(locateTestCase("Module_Str_SEEN/strcpy_0.TXT"));
+
+  // Write a save game the way older versions of rlvm did.
+  {
+    RLMachine saveMachine(system, arc);
+    setIntMemoryCountingFrom(saveMachine, LOCAL_INTEGER_BANKS, 0);
+    setStrMemoryCountingFrom(saveMachine, STRS_LOCATION, 0);
+    saveMachine.MarkSavepoint();
+
+    boost::iostreams::filtering_stream<boost::iostreams::output> output;
+    output.push(boost::iostreams::zlib_compressor());
+    output.push(ss);
+
+    Serialization::g_current_machine = &saveMachine;
+    {
+      const SaveGameHeader header("Legacy");
+      boost::archive::text_oarchive oa(output);
+      oa << 2 << header
+         << const_cast<const LocalMemory&>(saveMachine.memory().local())
+         << const_cast<const RLMachine&>(saveMachine)
+         << static_cast<const System&>(system)
+         << static_cast<const GraphicsSystem&>(system.graphics())
+         << static_cast<const TextSystem&>(system.text())
+         << static_cast<const SoundSystem&>(system.sound());
+    }
+    Serialization::g_current_machine = NULL;
+  }
+
+  EXPECT_EQ("Legacy", Serialization::loadHeaderFrom(ss).title);
+
+  ss.clear();
+  ss.seekg(0);
+  {
+    RLMachine loadMachine(system, arc);
+    Serialization::loadGameFrom(ss, loadMachine);
+    verifyIntMemoryCountingFrom(loadMachine, LOCAL_INTEGER_BANKS, 0);
+    verifyStrMemoryCountingFrom(loadMachine, STRS_LOCATION, 0);
+  }
+}
+
+TEST_F(RLMachineTest, SaveGameHeaderRoundTrips) {
+  stringstream ss;
+  libreallive::Archive arc(locateTestCase("Module_Str_SEEN/strcpy_0.TXT"));
+  RLMachine saveMachine(system, arc);
+  system.graphics().SetWindowSubtitle("Subtitle", 0);
+  Serialization::saveGameTo(ss, saveMachine);
+
+  SaveGameHeader header = Serialization::loadHeaderFrom(ss);
+  EXPECT_EQ("Subtitle", header.title);
+  EXPECT_FALSE(header.save_time.is_special());
+
+  // The header sits uncompressed at the front of the file, so the menus can
+  // read it without touching the rest: tag, version, title and time.
+  stringstream prefix(ss.str().substr(0, 8 + 4 + 4 + 8 + 8));
+  header = Serialization::loadHeaderFrom(prefix);
+  EXPECT_EQ("Subtitle", header.title);
+}
+
+// Only the current binary version is read. (Version 1 was never released.)
+TEST_F(RLMachineTest, RejectsOtherBinarySaveVersions) {
+  for (int version : {1, 3}) {
+    std::string data("RLVMSAVE");
+    for (int i = 0; i < 4; ++i)
+      data += char((version >> (i * 8)) & 0xff);
+    stringstream ss(data);
+    EXPECT_THROW(Serialization::loadHeaderFrom(ss), rlvm::Exception)
+        << "version " << version;
+  }
+}
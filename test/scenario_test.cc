@@ -0,0 +1,121 @@
+// -*- Mode: C++; tab-width:2; indent-tabs-mode: nil; c-basic-offset: 2 -*-
+// vi:tw=80:et:ts=2:sts=2
+//
+// -----------------------------------------------------------------------
+//
+// This file is part of RLVM, a RealLive virtual machine clone.
+//
+// -----------------------------------------------------------------------
+//
+// Copyright (C) 2015 Elliot Glaysher
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA.
+// -----------------------------------------------------------------------
+
+#include "gtest/gtest.h"
+
+#include "libreallive/archive.h"
+#include "libreallive/bytecode.h"
+#include "libreallive/scenario.h"
+#include "test_utils.h"
+
+using libreallive::Archive;
+using libreallive::CommandElement;
+using libreallive::Scenario;
+
+// Corresponding kepago listing:
+//
+//   jump(1, intB[0])
+//
+//   #ENTRYPOINT 1
+//   intA[0] = 1
+//   goto @end
+//
+//   #ENTRYPOINT 2
+//   intA[0] = 2
+//   goto @end
+//
+//   #ENTRYPOINT 3
+//   intA[0] = 3
+//   goto @end
+//
+//   @end
+class ScenarioTest : public ::testing::Test {
+ protected:
+  ScenarioTest()
+      : arc(locateTestCase("Module_Jmp_SEEN/jump_0.TXT")),
+        scenario(arc.GetScenario(arc.begin()->first)) {}
+
+  Archive arc;
+  Scenario* scenario;
+};
+
+TEST_F(ScenarioTest, NothingIsParsedUpFront) {
+  ASSERT_TRUE(scenario);
+  EXPECT_EQ(4u, scenario->region_count());
+  EXPECT_EQ(0u, scenario->parsed_region_count());
+}
+
+// The prefetch thread only looks at what the interpreter already parsed.
+TEST_F(ScenarioTest, FindingJumpTargetsParsesNothing) {
+  scenario->GetReachableScenarios();
+  EXPECT_EQ(0u, scenario->parsed_region_count());
+}
+
+TEST_F(ScenarioTest, EntrypointParsesOnlyWhatItReaches) {
+  Scenario::const_iterator it = scenario->FindEntrypoint(1);
+  EXPECT_EQ(1, (*it)->GetEntrypoint());
+
+  // Entrypoint 1's own region, plus the one its goto @end lands in.
+  EXPECT_EQ(2u, scenario->parsed_region_count());
+}
+
+TEST_F(ScenarioTest, IteratingParsesEverything) {
+  int entrypoints = 0;
+  for (Scenario::const_iterator it = scenario->begin(); it != scenario->end();
+       ++it) {
+    int entrypoint = (*it)->GetEntrypoint();
+    if (entrypoint != libreallive::BytecodeElement::kInvalidEntrypoint) {
+      EXPECT_TRUE(it == scenario->FindEntrypoint(entrypoint));
+      ++entrypoints;
+    }
+  }
+
+  // The compiler puts entrypoint 0 at the top of the file.
+  EXPECT_EQ(4, entrypoints);
+  EXPECT_EQ(scenario->region_count(), scenario->parsed_region_count());
+}
+
+// Every goto lands on an element that iteration reaches later on.
+TEST_F(ScenarioTest, JumpTargetsResolveAcrossRegions) {
+  int gotos = 0;
+  for (Scenario::const_iterator it = scenario->begin(); it != scenario->end();
+       ++it) {
+    const CommandElement* command = dynamic_cast<const CommandElement*>(*it);
+    if (!command)
+      continue;
+
+    for (size_t i = 0; i < command->GetPointersCount(); ++i) {
+      Scenario::const_iterator target = command->GetPointer(i);
+      Scenario::const_iterator walk = it;
+      while (walk != scenario->end() && walk != target)
+        ++walk;
+      EXPECT_TRUE(walk == target);
+      ++gotos;
+    }
+  }
+
+  EXPECT_EQ(3, gotos);
+}
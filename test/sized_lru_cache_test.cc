@@ -0,0 +1,141 @@
+// -*- Mode: C++; tab-width:2; indent-tabs-mode: nil; c-basic-offset: 2 -*-
+// vi:tw=80:et:ts=2:sts=2
+//
+// -----------------------------------------------------------------------
+//
+// This file is part of RLVM, a RealLive virtual machine clone.
+//
+// -----------------------------------------------------------------------
+//
+// Copyright (C) 2015 Elliot Glaysher
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA.
+// -----------------------------------------------------------------------
+
+#include "gtest/gtest.h"
+
+#include <string>
+#include <vector>
+
+#include "utilities/sized_lru_cache.h"
+
+typedef SizedLRUCache<std::string, int> Cache;
+
+TEST(SizedLRUCacheTest, CountsHitsAndMisses) {
+  Cache cache;
+  cache.Insert("one", 1, 10);
+
+  ASSERT_TRUE(cache.Fetch("one"));
+  EXPECT_EQ(1, *cache.Fetch("one"));
+  EXPECT_FALSE(cache.Fetch("two"));
+
+  // Contains() is a peek, not a use.
+  EXPECT_TRUE(cache.Contains("one"));
+  EXPECT_FALSE(cache.Contains("two"));
+
+  EXPECT_EQ(2, cache.hits());
+  EXPECT_EQ(1, cache.misses());
+  EXPECT_EQ(1u, cache.size());
+  EXPECT_EQ(10u, cache.bytes());
+}
+
+TEST(SizedLRUCacheTest, EvictsLeastRecentlyUsed) {
+  Cache cache;
+  cache.Insert("one", 1, 10);
+  cache.Insert("two", 2, 20);
+  cache.Insert("three", 3, 30);
+
+  // Touching "one" makes "two" the eviction candidate.
+  cache.Fetch("one");
+  EXPECT_EQ(2, cache.oldest());
+  EXPECT_TRUE(cache.EvictOldest());
+
+  EXPECT_TRUE(cache.Contains("one"));
+  EXPECT_FALSE(cache.Contains("two"));
+  EXPECT_TRUE(cache.Contains("three"));
+  EXPECT_EQ(40u, cache.bytes());
+  EXPECT_EQ(1, cache.evictions());
+}
+
+TEST(SizedLRUCacheTest, NeverEvictsTheNewestEntry) {
+  Cache cache;
+  EXPECT_FALSE(cache.EvictOldest());
+
+  cache.Insert("one", 1, 10);
+  cache.Insert("two", 2, 20);
+  EXPECT_TRUE(cache.EvictOldest());
+  EXPECT_FALSE(cache.EvictOldest());
+
+  EXPECT_TRUE(cache.Contains("two"));
+  EXPECT_EQ(20u, cache.bytes());
+  EXPECT_EQ(1, cache.evictions());
+}
+
+TEST(SizedLRUCacheTest, InsertReplacesEntry) {
+  Cache cache;
+  cache.Insert("one", 1, 10);
+  cache.Insert("two", 2, 20);
+  cache.Insert("one", 100, 5);
+
+  EXPECT_EQ(2u, cache.size());
+  EXPECT_EQ(25u, cache.bytes());
+  EXPECT_EQ(100, *cache.Fetch("one"));
+
+  // The replacement is the most recently used entry.
+  EXPECT_EQ(2, cache.oldest());
+}
+
+TEST(SizedLRUCacheTest, SetBytesReweighsEntry) {
+  Cache cache;
+  cache.Insert("one", 1, 10);
+  cache.Insert("two", 2, 20);
+
+  cache.SetBytes("one", 50);
+  cache.SetBytes("missing", 1000);
+  EXPECT_EQ(70u, cache.bytes());
+
+  EXPECT_TRUE(cache.EvictOldest());
+  EXPECT_EQ(20u, cache.bytes());
+}
+
+TEST(SizedLRUCacheTest, ValuesStayPutWhileOthersChange) {
+  Cache cache;
+  int* one = &cache.Insert("one", 1, 10);
+  cache.Insert("two", 2, 10);
+  cache.Fetch("two");
+  cache.Fetch("one");
+  cache.Insert("three", 3, 10);
+  cache.EvictOldest();
+
+  EXPECT_EQ(one, cache.Fetch("one"));
+  EXPECT_EQ(1, *one);
+}
+
+TEST(SizedLRUCacheTest, ForEachVisitsMostRecentFirst) {
+  Cache cache;
+  cache.Insert("one", 1, 10);
+  cache.Insert("two", 2, 10);
+  cache.Insert("three", 3, 10);
+  cache.Fetch("one");
+
+  std::vector<int> order;
+  cache.ForEach([&order](int value) { order.push_back(value); });
+  EXPECT_EQ((std::vector<int>{1, 3, 2}), order);
+
+  cache.Clear();
+  EXPECT_EQ(0u, cache.size());
+  EXPECT_EQ(0u, cache.bytes());
+  EXPECT_FALSE(cache.Contains("one"));
+}
@@ -0,0 +1,173 @@
+// -*- Mode: C++; tab-width:2; indent-tabs-mode: nil; c-basic-offset: 2 -*-
+// vi:tw=80:et:ts=2:sts=2
+//
+// -----------------------------------------------------------------------
+//
+// This file is part of RLVM, a RealLive virtual machine clone.
+//
+// -----------------------------------------------------------------------
+//
+// Copyright (C) 2015 Elliot Glaysher
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA.
+// -----------------------------------------------------------------------
+
+
+#include "gtest/gtest.h"
+
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "encodings/codepage.h"
+#include "utf8cpp/utf8.h"
+#include "utilities/string_utilities.h"
+
+namespace {
+
+const char kThrows[] = "<throws>";
+
+// The conversion cp932toUTF8() used to do, through a wstring.
+std::string ConvertThroughUnicode(const std::string& line, int transformation) {
+  try {
+    return UnicodeToUTF8(cp932toUnicode(line, transformation));
+  }
+  catch (const utf8::exception& e) {
+    return kThrows;
+  }
+}
+
+std::string ConvertDirectly(const std::string& line, int transformation) {
+  try {
+    return cp932toUTF8(line, transformation);
+  }
+  catch (const utf8::exception& e) {
+    return kThrows;
+  }
+}
+
+// Builds a string of whole characters in |transformation|'s encoding: plain
+// ASCII runs of varying lengths mixed with single and double byte
+// characters.
+std::string MakeLine(unsigned int seed, int transformation) {
+  Codepage& codepage = Cp::instance(transformation);
+  std::string line;
+  for (int i = 0; i < 60; ++i) {
+    seed = seed * 1103515245 + 12345;
+    unsigned int r = (seed >> 8) & 0xFFFF;
+    if (r % 3 == 0) {
+      line.append((r >> 4) % 20 + 1, 'a' + (r % 26));
+    } else {
+      unsigned char lead = 0x80 + (r >> 8) % 0x7F;
+      line += char(lead);
+      if (codepage.IsLeadByte(lead))
+        line += char(0x40 + r % 0xBF);
+    }
+  }
+  return line;
+}
+
+}  // namespace
+
+TEST(StringUtilitiesTest, AsciiPrefixLength) {
+  std::string ascii(100, 'x');
+  EXPECT_EQ(100u, AsciiPrefixLength(ascii.data(), ascii.size()));
+  EXPECT_EQ(0u, AsciiPrefixLength(ascii.data(), 0));
+
+  // Stop at the first high byte or NUL, whether it falls in a block or in
+  // the tail.
+  for (size_t position : {0u, 7u, 15u, 16u, 31u, 40u, 99u}) {
+    std::string high = ascii;
+    high[position] = '\x82';
+    EXPECT_EQ(position, AsciiPrefixLength(high.data(), high.size()));
+
+    std::string nul = ascii;
+    nul[position] = '\0';
+    EXPECT_EQ(position, AsciiPrefixLength(nul.data(), nul.size()));
+  }
+}
+
+TEST(StringUtilitiesTest, AsciiPassesThrough) {
+  for (int transformation = 0; transformation < 4; ++transformation) {
+    EXPECT_EQ("", cp932toUTF8("", transformation));
+    EXPECT_EQ("Hello, world! [0-9]", cp932toUTF8("Hello, world! [0-9]",
+                                                  transformation));
+  }
+}
+
+TEST(StringUtilitiesTest, ConvertsShiftJis) {
+  // "「あ」ｱ" in Shift_JIS.
+  std::string line = "\x81\x75\x82\xA0\x81\x76\xB1";
+  EXPECT_EQ("\xE3\x80\x8C\xE3\x81\x82\xE3\x80\x8D\xEF\xBD\xB1",
+            cp932toUTF8(line, 0));
+
+  // Twice, so the second one comes from the cache.
+  EXPECT_EQ(cp932toUTF8(line, 0), cp932toUTF8(line, 0));
+
+  // Conversion stops at an embedded NUL.
+  std::string with_nul = line + std::string(1, '\0') + "tail";
+  EXPECT_EQ(cp932toUTF8(line, 0), cp932toUTF8(with_nul, 0));
+}
+
+// The single pass conversion must agree with the old one in every codepage.
+TEST(StringUtilitiesTest, MatchesConversionThroughUnicode) {
+  for (int transformation = 0; transformation < 4; ++transformation) {
+    int converted = 0;
+    for (unsigned int seed = 1; seed < 50; ++seed) {
+      std::string line = MakeLine(seed, transformation);
+      std::string expected = ConvertThroughUnicode(line, transformation);
+      EXPECT_EQ(expected, ConvertDirectly(line, transformation))
+          << "transformation " << transformation << ", seed " << seed;
+      if (expected != kThrows)
+        converted++;
+    }
+    EXPECT_GT(converted, 0) << "transformation " << transformation;
+  }
+}
+
+// The scenario prefetch thread can convert error messages while the main
+// thread converts text, so the line cache is shared between threads.
+TEST(StringUtilitiesTest, ConvertsFromSeveralThreads) {
+  std::vector<std::string> lines;
+  std::vector<std::string> expected;
+  for (unsigned int seed = 1; seed < 40; ++seed) {
+    std::string line = MakeLine(seed, 0);
+    std::string converted = ConvertThroughUnicode(line, 0);
+    if (converted == kThrows)
+      continue;
+    lines.push_back(line);
+    expected.push_back(converted);
+  }
+  ASSERT_FALSE(lines.empty());
+
+  std::vector<int> mismatches(4, 0);
+  std::vector<std::thread> threads;
+  for (int t = 0; t < 4; ++t) {
+    threads.emplace_back([&, t] {
+      for (int round = 0; round < 200; ++round) {
+        for (size_t i = 0; i < lines.size(); ++i) {
+          size_t which = (i + t) % lines.size();
+          if (cp932toUTF8(lines[which], 0) != expected[which])
+            mismatches[t]++;
+        }
+      }
+    });
+  }
+  for (std::thread& thread : threads)
+    thread.join();
+
+  for (int t = 0; t < 4; ++t)
+    EXPECT_EQ(0, mismatches[t]) << "thread " << t;
+}
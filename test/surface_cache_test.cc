@@ -0,0 +1,118 @@
+// -*- Mode: C++; tab-width:2; indent-tabs-mode: nil; c-basic-offset: 2 -*-
+// vi:tw=80:et:ts=2:sts=2
+//
+// -----------------------------------------------------------------------
+//
+// This file is part of RLVM, a RealLive virtual machine clone.
+//
+// -----------------------------------------------------------------------
+//
+// Copyright (C) 2015 Elliot Glaysher
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA.
+// -----------------------------------------------------------------------
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+#include <memory>
+#include <string>
+
+#include "systems/base/surface_cache.h"
+#include "test_system/mock_surface.h"
+
+using ::testing::Return;
+
+namespace {
+
+const size_t kSquareBytes = 10 * 10 * 4;
+
+std::shared_ptr<const Surface> MakeSurface(const std::string& name,
+                                           size_t texture_bytes = 0) {
+  MockSurface* surface = MockSurface::Create(name, Size(10, 10));
+  ON_CALL(*surface, GetTextureMemoryUsage())
+      .WillByDefault(Return(texture_bytes));
+  return std::shared_ptr<const Surface>(surface);
+}
+
+}  // namespace
+
+TEST(SurfaceCacheTest, CountsHitsAndMisses) {
+  SurfaceCache cache(10 * kSquareBytes, 10 * kSquareBytes);
+  std::shared_ptr<const Surface> one = MakeSurface("one");
+  cache.Insert("one", one);
+
+  EXPECT_EQ(one, cache.Fetch("one"));
+  EXPECT_FALSE(cache.Fetch("two"));
+  EXPECT_TRUE(cache.Contains("one"));
+
+  SurfaceCache::Stats stats = cache.GetStats();
+  EXPECT_EQ(1, stats.hits);
+  EXPECT_EQ(1, stats.misses);
+  EXPECT_EQ(1u, stats.entries);
+  EXPECT_EQ(kSquareBytes, stats.decoded_bytes);
+}
+
+TEST(SurfaceCacheTest, EvictsLeastRecentlyUsedByDecodedBytes) {
+  SurfaceCache cache(2 * kSquareBytes, 10 * kSquareBytes);
+  cache.Insert("one", MakeSurface("one"));
+  cache.Insert("two", MakeSurface("two"));
+
+  // Touching "one" makes "two" the eviction candidate.
+  cache.Fetch("one");
+  cache.Insert("three", MakeSurface("three"));
+
+  EXPECT_TRUE(cache.Contains("one"));
+  EXPECT_FALSE(cache.Contains("two"));
+  EXPECT_TRUE(cache.Contains("three"));
+  EXPECT_EQ(1, cache.GetStats().evictions);
+  EXPECT_EQ(2 * kSquareBytes, cache.GetStats().decoded_bytes);
+}
+
+TEST(SurfaceCacheTest, EvictsByTextureBytes) {
+  SurfaceCache cache(10 * kSquareBytes, 1000);
+  cache.Insert("one", MakeSurface("one", 600));
+  cache.Insert("two", MakeSurface("two", 600));
+
+  EXPECT_FALSE(cache.Contains("one"));
+  EXPECT_TRUE(cache.Contains("two"));
+  EXPECT_EQ(600u, cache.GetStats().texture_bytes);
+}
+
+TEST(SurfaceCacheTest, KeepsOversizedNewestEntry) {
+  SurfaceCache cache(kSquareBytes / 2, kSquareBytes);
+  cache.Insert("one", MakeSurface("one"));
+  EXPECT_TRUE(cache.Contains("one"));
+
+  // Shrinking the budget still leaves the most recent entry.
+  cache.Insert("two", MakeSurface("two"));
+  cache.SetBudgets(0, 0);
+  EXPECT_FALSE(cache.Contains("one"));
+  EXPECT_TRUE(cache.Contains("two"));
+}
+
+TEST(SurfaceCacheTest, FetchRecountsDecodedBytes) {
+  SurfaceCache cache(10 * kSquareBytes, 10 * kSquareBytes);
+  MockSurface* surface = MockSurface::Create("lazy", Size(10, 10));
+  ON_CALL(*surface, GetDecodedMemoryUsage()).WillByDefault(Return(0));
+  cache.Insert("lazy", std::shared_ptr<const Surface>(surface));
+  EXPECT_EQ(0u, cache.GetStats().decoded_bytes);
+
+  // Like an image whose patterns are decoded after it was cached.
+  ON_CALL(*surface, GetDecodedMemoryUsage())
+      .WillByDefault(Return(kSquareBytes));
+  cache.Fetch("lazy");
+  EXPECT_EQ(kSquareBytes, cache.GetStats().decoded_bytes);
+}
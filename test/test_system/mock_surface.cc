@@ -37,13 +37,24 @@
 // -----------------------------------------------------------------------
 // static
 MockSurface* MockSurface::Create(const std::string& surface_name) {
-  return new ::testing::NiceMock<MockSurface>(surface_name);
+  MockSurface* surface = new ::testing::NiceMock<MockSurface>(surface_name);
+  surface->UseDefaultDecodedMemoryUsage();
+  return surface;
 }
 
 // static
 MockSurface* MockSurface::Create(const std::string& surface_name,
                                  const Size& size) {
-  return new ::testing::NiceMock<MockSurface>(surface_name, size);
+  MockSurface* surface =
+      new ::testing::NiceMock<MockSurface>(surface_name, size);
+  surface->UseDefaultDecodedMemoryUsage();
+  return surface;
+}
+
+void MockSurface::UseDefaultDecodedMemoryUsage() {
+  ON_CALL(*this, GetDecodedMemoryUsage())
+      .WillByDefault(::testing::Invoke(
+          [this] { return Surface::GetDecodedMemoryUsage(); }));
 }
 
 void MockSurface::Allocate(const Size& size) {
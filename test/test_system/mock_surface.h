@@ -70,6 +70,8 @@ class MockSurface : public Surface {
   MOCK_METHOD2(ApplyColour, void(const RGBColour&, const Rect&));
 
   MOCK_CONST_METHOD4(GetDCPixel, void(const Point&, int&, int&, int&));
+  MOCK_CONST_METHOD0(GetTextureMemoryUsage, size_t());
+  MOCK_CONST_METHOD0(GetDecodedMemoryUsage, size_t());
 
   // Concrete implementations of the cloning methods.
   virtual std::shared_ptr<Surface> ClipAsColorMask(const Rect& rect,
@@ -84,6 +86,9 @@ class MockSurface : public Surface {
   MockSurface(const std::string& surface_name, const Size& size);
 
  private:
+  // Makes GetDecodedMemoryUsage() report the size based default.
+  void UseDefaultDecodedMemoryUsage();
+
   // Unique name of this surface.
   std::string surface_name_;
 
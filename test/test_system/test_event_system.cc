@@ -53,7 +53,8 @@ unsigned int TestEventSystem::GetTicks() const {
 }
 
 void TestEventSystem::Wait(unsigned int milliseconds) const {
-  // waiting is a noop.
+  // Real waiting is a noop; the handler may advance a fake clock instead.
+  event_system_mock_->Wait(milliseconds);
 }
 
 Point TestEventSystem::GetCursorPos() {
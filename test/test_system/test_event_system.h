@@ -41,6 +41,7 @@ class EventSystemMockHandler {
   virtual bool shiftPressed() const { return false; }
   virtual bool ctrlPressed() const { return false; }
   virtual unsigned int GetTicks() const { return counter_++; }
+  virtual void Wait(unsigned int milliseconds) const {}
 
  private:
   mutable int counter_;
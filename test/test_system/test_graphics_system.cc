@@ -147,6 +147,8 @@ std::shared_ptr<Surface> TestGraphicsSystem::EndFrameToSurface() {
   return std::shared_ptr<Surface>();
 }
 
+bool TestGraphicsSystem::BeginPartialFrame(const Rect& area) { return true; }
+
 MockSurface& TestGraphicsSystem::GetMockDC(int dc) {
   return *display_contexts_[dc];
 }
@@ -62,6 +62,7 @@ class TestGraphicsSystem : public GraphicsSystem {
   virtual void BeginFrame() override;
   virtual void EndFrame() override;
   virtual std::shared_ptr<Surface> EndFrameToSurface() override;
+  virtual bool BeginPartialFrame(const Rect& area) override;
 
   // Needed because of covariant issues.
   MockSurface& GetMockDC(int dc);